@@ -0,0 +1,232 @@
+/*
+ * bench.c
+ *
+ * micro benchmark of qparam on host, each operation is run on tables of several sizes :
+ *  - cpu time is the thread cpu time, the median of several runs, so it is stable on a busy machine
+ *  - flash time, erases and programmed bytes come from the flash simulator, they are exact
+ *
+ * usage : param_bench [-q] [-r runs]
+ *  -q      quick, few iterations, only checks that every operation works
+ *  -r      runs of each operation, default 7
+ */
+
+#include "../../src/param.c"    //white box, param_find_by_name and _param_resume_all are static
+#include <host_flash.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_PART_SIZE         (32 * 1024)     //storage of each table in bench partition
+#define BENCH_RUNS_MAX          31
+
+#define PARAM_TABLE_NAME            bench16
+#define PARAM_TABLE_FILE            <bench16_def.h>
+#define PARAM_TABLE_PART_NAME       "bench"
+#define PARAM_TABLE_SAVE_ADDR       (BENCH_PART_SIZE * 0)
+#define PARAM_TABLE_AUTO_SAVE_DELAY 0
+#include <param_table.h>
+
+#define PARAM_TABLE_NAME            bench64
+#define PARAM_TABLE_FILE            <bench64_def.h>
+#define PARAM_TABLE_PART_NAME       "bench"
+#define PARAM_TABLE_SAVE_ADDR       (BENCH_PART_SIZE * 1)
+#define PARAM_TABLE_AUTO_SAVE_DELAY 0
+#include <param_table.h>
+
+#define PARAM_TABLE_NAME            bench256
+#define PARAM_TABLE_FILE            <bench256_def.h>
+#define PARAM_TABLE_PART_NAME       "bench"
+#define PARAM_TABLE_SAVE_ADDR       (BENCH_PART_SIZE * 2)
+#define PARAM_TABLE_AUTO_SAVE_DELAY 0
+#include <param_table.h>
+
+typedef struct{
+    u64 cpu_ns;             //cpu time of one operation
+    u64 flash_ns;           //simulated flash time of one operation
+    double erases;          //sectors erased by one operation
+    u64 prog_bytes;         //bytes programmed by one operation
+}bench_result_t;
+
+typedef void (*bench_fn_t)(param_tbl_t *tbl, int iter);
+
+static int bench_runs = 7;
+static int bench_quick = 0;
+static u8 bench_buf[PARAM_VALUE_MAX + 1];
+
+static u64 bench_cpu_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return((u64)ts.tv_sec * 1000000000 + ts.tv_nsec);
+}
+
+static int bench_cmp(const void *a, const void *b)
+{
+    u64 va = *(const u64 *)a, vb = *(const u64 *)b;
+    return((va > vb) - (va < vb));
+}
+
+static void bench_run(param_tbl_t *tbl, bench_fn_t fn, int iters, bench_result_t *result)
+{
+    u64 cpu[BENCH_RUNS_MAX];
+    host_flash_stats_t st0, st1;
+
+    fn(tbl, 0);//warm up
+    host_flash_get_stats(&st0);
+    for (int r = 0; r < bench_runs; r++)
+    {
+        u64 begin = bench_cpu_ns();
+        for (int i = 0; i < iters; i++)
+        {
+            fn(tbl, r * iters + i + 1);
+        }
+        cpu[r] = (bench_cpu_ns() - begin) / iters;
+    }
+    host_flash_get_stats(&st1);
+    qsort(cpu, bench_runs, sizeof(cpu[0]), bench_cmp);
+    result->cpu_ns = cpu[bench_runs / 2];
+    iters *= bench_runs;
+    result->flash_ns = (st1.busy_ns - st0.busy_ns) / iters;
+    result->erases = (double)(st1.erases - st0.erases) / iters;
+    result->prog_bytes = (st1.prog_bytes - st0.prog_bytes) / iters;
+}
+
+static int bench_value(param_tbl_t *tbl, int idx, int iter)//value differs from the last write of the param
+{
+    int size = tbl->msgs[idx].size;
+    memset(bench_buf, 'a' + (iter & 0x0F), size);
+    if (tbl->msgs[idx].type == PTYPE_STR)
+    {
+        bench_buf[size - 1] = 0;
+    }
+    return(size);
+}
+
+#ifndef PARAM_USING_INDEX_ONLY
+static void bench_find_by_name(param_tbl_t *tbl, int iter)
+{
+    if (param_find_by_name(tbl, PARAM_MSG_NAME(tbl, iter % tbl->total)) < 0)
+    {
+        abort();
+    }
+}
+
+static void bench_read_by_name(param_tbl_t *tbl, int iter)
+{
+    int idx = iter % tbl->total;
+    param_tbl_read_by_name(tbl, (char *)PARAM_MSG_NAME(tbl, idx), bench_buf, tbl->msgs[idx].size);
+}
+
+static void bench_write_by_name(param_tbl_t *tbl, int iter)
+{
+    int idx = iter % tbl->total;
+    int size = bench_value(tbl, idx, iter);
+    param_tbl_write_by_name(tbl, (char *)PARAM_MSG_NAME(tbl, idx), bench_buf, size);
+}
+#endif
+
+static void bench_read_by_index(param_tbl_t *tbl, int iter)
+{
+    int idx = iter % tbl->total;
+    param_tbl_read_by_index(tbl, idx, bench_buf, tbl->msgs[idx].size);
+}
+
+static void bench_write_by_index(param_tbl_t *tbl, int iter)
+{
+    int idx = iter % tbl->total;
+    int size = bench_value(tbl, idx, iter);
+    param_tbl_write_by_index(tbl, idx, bench_buf, size);
+}
+
+static void bench_resume_all(param_tbl_t *tbl, int iter)
+{
+    _param_resume_all(tbl);
+}
+
+static void bench_save(param_tbl_t *tbl, int iter)
+{
+    bench_write_by_index(tbl, iter);//each save has a change
+    param_tbl_save(tbl);
+}
+
+static void bench_load(param_tbl_t *tbl, int iter)
+{
+    param_tbl_load(tbl);
+}
+
+static void bench_print(param_tbl_t *tbl, const char *op, const bench_result_t *result)
+{
+    printf("%-10s %6d %6d  %-16s %10llu %12llu %9.3f %10llu\n", tbl->name, tbl->total, tbl->size, op,
+           (unsigned long long)result->cpu_ns, (unsigned long long)(result->flash_ns / 1000),
+           result->erases, (unsigned long long)result->prog_bytes);
+}
+
+static void bench_table(param_tbl_t *tbl)
+{
+    static const struct{
+        const char *name;
+        bench_fn_t fn;
+        int iters;          //iterations of each run
+    }ops[] = {
+        #ifndef PARAM_USING_INDEX_ONLY
+        {"find_by_name",    bench_find_by_name,     100000},
+        {"read_by_name",    bench_read_by_name,     100000},
+        {"write_by_name",   bench_write_by_name,    100000},
+        #endif
+        {"read_by_index",   bench_read_by_index,    100000},
+        {"write_by_index",  bench_write_by_index,   100000},
+        {"resume_all",      bench_resume_all,       2000},
+        {"save",            bench_save,             20},
+        {"load",            bench_load,             50},
+    };
+    bench_result_t result;
+
+    if (param_tbl_init(tbl) != RT_EOK)
+    {
+        printf("%-10s init fail\n", tbl->name);
+        exit(1);
+    }
+    for (int i = 0; i < (int)(sizeof(ops) / sizeof(ops[0])); i++)
+    {
+        bench_run(tbl, ops[i].fn, bench_quick ? 2 : ops[i].iters, &result);
+        bench_print(tbl, ops[i].name, &result);
+    }
+    param_tbl_deinit(tbl);
+}
+
+int main(int argc, char **argv)
+{
+    param_tbl_t *tbls[] = {&param_tbl_main, &param_tbl_bench16, &param_tbl_bench64, &param_tbl_bench256};
+    int opt;
+
+    while ((opt = getopt(argc, argv, "qr:")) != -1)
+    {
+        switch(opt)
+        {
+        case 'q':
+            bench_quick = 1;
+            bench_runs = 1;
+            break;
+        case 'r':
+            bench_runs = atoi(optarg);
+            if ((bench_runs < 1) || (bench_runs > BENCH_RUNS_MAX))
+            {
+                fprintf(stderr, "runs must be 1 - %d\n", BENCH_RUNS_MAX);
+                return(1);
+            }
+            break;
+        default:
+            fprintf(stderr, "usage : %s [-q] [-r runs]\n", argv[0]);
+            return(1);
+        }
+    }
+
+    host_flash_open(NULL);
+    printf("cfg : %s\n", BENCH_CFG);
+    printf("table      params   size  operation         cpu ns/op  flash us/op  erase/op  prog B/op\n");
+    printf("---------- ------ ------  ---------------- ---------- ------------ --------- ----------\n");
+    for (int i = 0; i < (int)(sizeof(tbls) / sizeof(tbls[0])); i++)
+    {
+        bench_table(tbls[i]);
+    }
+    return(0);
+}
@@ -0,0 +1,26 @@
+#!/bin/sh
+# generates a parameter definition file of N params for the benchmark, types are cycled like port/param_def.h
+# usage : gen_def.sh N > bench<N>_def.h
+# the file has no include guard, so it is also usable with PARAM_USING_COMPACT
+
+n=${1:?usage: gen_def.sh N}
+echo "/* generated by gen_def.sh, $n params */"
+echo
+echo "#ifdef PARAM_TABLE_DEF"
+echo "PARAM_BEGIN()"
+i=0
+while [ $i -lt $n ]; do
+    case $((i % 8)) in
+    0) echo "PARAM_STRING(name_$i, 15, dev$i)";;
+    1) echo "PARAM_ARRAY (mac_$i, 6, 02 00 00 00 00 01)";;
+    2) echo "PARAM_INT   (count_$i, $i)";;
+    3) echo "PARAM_INT64 (total_$i, 56789123456789)";;
+    4) echo "PARAM_HEX   (reg_$i, A001)";;
+    5) echo "PARAM_HEX64 (mask_$i, 12345678ABCDEF)";;
+    6) echo "PARAM_FLOAT (volt_$i, 12.34)";;
+    7) echo "PARAM_DOUBLE(energy_$i, 87654321.123)";;
+    esac
+    i=$((i + 1))
+done
+echo "PARAM_END()"
+echo "#endif"
@@ -0,0 +1,341 @@
+/*
+ * powercut.c
+ *
+ * power loss test of the real param.c on the simulated flash. a save of new values over committed old ones
+ * is measured in steps, a step is the erase of one sector or the program of one page, then for each step :
+ *  - the flash before the new values is restored, the table is restarted and the new values are written
+ *  - the save is started, power is cut at the step, once with the step not done and once half done
+ *  - the table is restarted like a boot, it must load either the old or the new values
+ * old values are those committed when the save starts, writes may have saved some with PARAM_USING_XIP.
+ * boots are counted by result : old, new, fall back to backup, fall back to defaults and mixed values,
+ * and the boot recovery time is measured, simulated flash time and cpu time of init and load.
+ * the run fails if any boot lost the committed values or loaded a mix of both.
+ *
+ * usage : param_powercut [-v]
+ *  -v      print each boot and the logs of param.c, they are discarded by default
+ */
+
+#ifndef PARAM_USING_STATS
+#define PARAM_USING_STATS       //loads fall back to backup are counted by statistics
+#endif
+
+#include "../../src/param.c"    //white box, the statistics are read from the table
+#include <host_flash.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(PARAM_USING_PRE_ERASE) && (PARAM_ERASE_THREAD_PRIORITY > 0)
+#error "build with PARAM_ERASE_THREAD_PRIORITY=0, the retired slot is erased as a step of the save"
+#endif
+
+#define POWERCUT_ADDR           (32 * 1024)     //save address of the large table in user partition, and of its backup with PARAM_USING_DUAL
+
+#define PARAM_TABLE_NAME            pc256
+#define PARAM_TABLE_FILE            <bench256_def.h>
+#define PARAM_TABLE_PART_NAME       "user"
+#define PARAM_TABLE_SAVE_ADDR       POWERCUT_ADDR
+#define PARAM_TABLE_AUTO_SAVE_DELAY 0
+#include <param_table.h>
+
+enum{
+    PC_OLD = 0,             //committed values before the save
+    PC_NEW,                 //values of the save
+    PC_DEFAULTS,            //load failed, committed values are lost
+    PC_MIXED,               //neither old nor new values
+    PC_TOTAL,
+};
+
+typedef struct{
+    u32 steps;              //steps of one save
+    u32 boots;              //boots after power cut
+    u32 results[PC_TOTAL];  //boots of each result
+    u32 backup_loads;       //boots loaded from the backup copy
+    u64 flash_ns;           //flash time of all boots
+    u64 flash_max_ns;
+    u64 cpu_ns;             //cpu time of all boots
+    u64 cpu_max_ns;
+    u64 clean_flash_ns;     //boot without power cut
+    u64 clean_cpu_ns;
+}pc_result_t;
+
+static const char *pc_names[PC_TOTAL] = {"old", "new", "defaults", "mixed"};
+static u8 pc_flash[HOST_FLASH_SIZE];    //flash before new values are written
+static u8 pc_flash_old[HOST_FLASH_SIZE];//flash when the save of new values starts
+static u8 pc_buf[PARAM_VALUE_MAX + 1];
+static int pc_verbose = 0;
+static int pc_stderr = -1;              //saved stderr while logs are discarded
+
+static u64 pc_cpu_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return((u64)ts.tv_sec * 1000000000 + ts.tv_nsec);
+}
+
+static void pc_quiet(int on)//logs of param.c are expected on failed writes, they are discarded
+{
+    if (pc_verbose)
+    {
+        return;
+    }
+    fflush(stderr);
+    if (on && (pc_stderr < 0))
+    {
+        int fd = open("/dev/null", O_WRONLY);
+        pc_stderr = dup(2);
+        dup2(fd, 2);
+        close(fd);
+    }
+    else if (!on && (pc_stderr >= 0))
+    {
+        dup2(pc_stderr, 2);
+        close(pc_stderr);
+        pc_stderr = -1;
+    }
+}
+
+static void pc_fill(param_tbl_t *tbl, int gen)//every param gets a value of the generation
+{
+    for (int idx = 0; idx < tbl->total; idx++)
+    {
+        int size = tbl->msgs[idx].size;
+        memset(pc_buf, 'a' + (gen * 7 + idx) % 26, size);
+        if (tbl->msgs[idx].type == PTYPE_STR)
+        {
+            pc_buf[size - 1] = 0;
+        }
+        param_tbl_write_by_index(tbl, idx, pc_buf, size);
+    }
+}
+
+static u32 pc_snap_size(param_tbl_t *tbl)
+{
+    u32 size = 0;
+    for (int idx = 0; idx < tbl->total; idx++)
+    {
+        size += tbl->msgs[idx].size;
+    }
+    return(size);
+}
+
+static void pc_snap(param_tbl_t *tbl, u8 *snap)//values of all params
+{
+    for (int idx = 0; idx < tbl->total; idx++)
+    {
+        int size = tbl->msgs[idx].size;
+        memset(snap, 0, size);
+        param_tbl_read_by_index(tbl, idx, snap, size);
+        snap += size;
+    }
+}
+
+static int pc_save(param_tbl_t *tbl)
+{
+    int rst;
+    #if defined(PARAM_USING_DUAL) && (PARAM_DUAL_THREAD_PRIORITY > 0)
+    //the flash time is really waited, so the copies are written at the same time like on target, scaled to keep the run short
+    host_flash_timing_t timing = {.erase_us = 4500, .prog_us = 8, .prog_byte_ns = 270, .read_byte_ns = 16, .page_size = 256, .delay = 1};
+    host_flash_set_timing(&timing);
+    #endif
+    
+    rst = param_tbl_save(tbl);
+    #ifdef PARAM_USING_PRE_ERASE
+    param_tbl_pre_erase(tbl);//done by the erase thread on target, power may be cut in it too
+    #endif
+    #if defined(PARAM_USING_DUAL) && (PARAM_DUAL_THREAD_PRIORITY > 0)
+    host_flash_set_timing(NULL);
+    #endif
+    return(rst);
+}
+
+static int pc_boot(param_tbl_t *tbl, u64 *flash_ns, u64 *cpu_ns, u32 *backup_loads)
+{
+    host_flash_stats_t st0, st1;
+    u32 loads;
+    u64 cpu;
+    int rst;
+
+    param_tbl_deinit(tbl);
+    host_flash_get_stats(&st0);
+    cpu = pc_cpu_ns();
+    rst = param_tbl_init(tbl);
+    loads = tbl->stats.backup_loads;
+    if (rst == RT_EOK)
+    {
+        rst = param_tbl_load(tbl);
+    }
+    *cpu_ns = pc_cpu_ns() - cpu;
+    host_flash_get_stats(&st1);
+    *flash_ns = st1.busy_ns - st0.busy_ns;
+    *backup_loads = tbl->stats.backup_loads - loads;
+    tbl->cfg.auto_save_delay = 0;//only the saves of the test
+    return(rst);
+}
+
+static int pc_table(param_tbl_t *tbl, pc_result_t *result)
+{
+    host_flash_stats_t st0, st1;
+    u32 size = pc_snap_size(tbl);
+    u8 *snap_old = malloc(size), *snap_new = malloc(size), *snap = malloc(size);
+    u64 flash_ns, cpu_ns;
+    u32 backup;
+    int rst;
+
+    memset(result, 0, sizeof(*result));
+    host_flash_format();
+    host_flash_power_cut(-1, 0);
+    if ((snap_old == NULL) || (snap_new == NULL) || (snap == NULL) || (param_tbl_init(tbl) != RT_EOK))
+    {
+        free(snap_old);
+        free(snap_new);
+        free(snap);
+        return(-RT_ERROR);
+    }
+
+    //two saves, so every copy or slot has a committed image
+    tbl->cfg.auto_save_delay = 0;
+    pc_fill(tbl, 1);
+    pc_save(tbl);
+    pc_fill(tbl, 2);
+    pc_save(tbl);
+    memcpy(pc_flash, host_flash_mem, sizeof(pc_flash));
+    pc_boot(tbl, &flash_ns, &cpu_ns, &backup);//each trial starts with this boot
+    pc_fill(tbl, 3);
+    pc_snap(tbl, snap_new);
+    memcpy(pc_flash_old, host_flash_mem, sizeof(pc_flash_old));//a full shadow pool of PARAM_USING_XIP is saved by writes
+    host_flash_get_stats(&st0);
+    pc_save(tbl);
+    host_flash_get_stats(&st1);
+    result->steps = (st1.erases - st0.erases) + (st1.programs - st0.programs);
+    pc_boot(tbl, &result->clean_flash_ns, &result->clean_cpu_ns, &backup);
+    pc_snap(tbl, snap);
+    rst = (memcmp(snap, snap_new, size) == 0) ? RT_EOK : -RT_ERROR;
+    memcpy(host_flash_mem, pc_flash_old, sizeof(pc_flash_old));
+    pc_boot(tbl, &flash_ns, &cpu_ns, &backup);
+    pc_snap(tbl, snap_old);
+
+    for (u32 step = 0; (step < result->steps) && (rst == RT_EOK); step++)
+    {
+        for (int half = 0; half < 2; half++)
+        {
+            int res;
+
+            memcpy(host_flash_mem, pc_flash, sizeof(pc_flash));
+            pc_boot(tbl, &flash_ns, &cpu_ns, &backup);
+            pc_fill(tbl, 3);
+            if (memcmp(host_flash_mem, pc_flash_old, sizeof(pc_flash_old)) != 0)
+            {
+                printf("%-10s step %u : flash differs when the save starts, writes are not stable\n", tbl->name, step);
+                rst = -RT_ERROR;
+                break;
+            }
+            host_flash_power_cut(step, half);
+            pc_save(tbl);
+            if (!host_flash_power_lost())
+            {
+                printf("%-10s step %u : save ends before power is cut, steps are not stable\n", tbl->name, step);
+                rst = -RT_ERROR;
+                break;
+            }
+            host_flash_power_cut(-1, 0);
+
+            if (pc_boot(tbl, &flash_ns, &cpu_ns, &backup) != RT_EOK)
+            {
+                res = PC_DEFAULTS;
+            }
+            else
+            {
+                pc_snap(tbl, snap);
+                res = (memcmp(snap, snap_old, size) == 0) ? PC_OLD : (memcmp(snap, snap_new, size) == 0) ? PC_NEW : PC_MIXED;
+            }
+            result->boots++;
+            result->results[res]++;
+            result->backup_loads += backup;
+            result->flash_ns += flash_ns;
+            result->cpu_ns += cpu_ns;
+            if (flash_ns > result->flash_max_ns)
+            {
+                result->flash_max_ns = flash_ns;
+            }
+            if (cpu_ns > result->cpu_max_ns)
+            {
+                result->cpu_max_ns = cpu_ns;
+            }
+            if (pc_verbose || (res >= PC_DEFAULTS))
+            {
+                printf("%-10s step %3u %-4s : %-8s %s flash %llu us\n", tbl->name, step, half ? "half" : "none",
+                       pc_names[res], backup ? "backup" : "      ", (unsigned long long)(flash_ns / 1000));
+            }
+        }
+    }
+
+    param_tbl_deinit(tbl);
+    free(snap_old);
+    free(snap_new);
+    free(snap);
+    return(rst);
+}
+
+static void pc_report(param_tbl_t *tbl, const pc_result_t *result)
+{
+    u32 boots = (result->boots != 0) ? result->boots : 1;
+
+    printf("%-10s %6d %5u %5u %5u %5u %6u %8u %5u %9llu %9llu %9llu %9llu %9llu\n", tbl->name, tbl->size, result->steps,
+           result->boots, result->results[PC_OLD], result->results[PC_NEW], result->backup_loads, result->results[PC_DEFAULTS],
+           result->results[PC_MIXED], (unsigned long long)(result->clean_flash_ns / 1000),
+           (unsigned long long)(result->flash_ns / boots / 1000), (unsigned long long)(result->flash_max_ns / 1000),
+           (unsigned long long)(result->cpu_ns / boots / 1000), (unsigned long long)(result->cpu_max_ns / 1000));
+}
+
+int main(int argc, char **argv)
+{
+    param_tbl_t *tbls[] = {&param_tbl_main, &param_tbl_pc256};
+    pc_result_t results[sizeof(tbls) / sizeof(tbls[0])];
+    int fails = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "v")) != -1)
+    {
+        switch(opt)
+        {
+        case 'v':
+            pc_verbose = 1;
+            break;
+        default:
+            fprintf(stderr, "usage : %s [-v]\n", argv[0]);
+            return(1);
+        }
+    }
+
+    host_flash_open(NULL);
+    for (int i = 0; i < (int)(sizeof(tbls) / sizeof(tbls[0])); i++)
+    {
+        #ifdef PARAM_USING_BACKEND
+        if (tbls[i]->cfg.backend != &param_backend_fal)
+        {
+            fprintf(stderr, "%s is not on fal, power can not be cut\n", tbls[i]->name);
+            return(1);
+        }
+        #endif
+        pc_quiet(1);
+        if (pc_table(tbls[i], &results[i]) != RT_EOK)
+        {
+            pc_quiet(0);
+            printf("%-10s test fail\n", tbls[i]->name);
+            return(1);
+        }
+        pc_quiet(0);
+        fails += results[i].results[PC_DEFAULTS] + results[i].results[PC_MIXED];
+    }
+
+    printf("cfg : %s\n", POWERCUT_CFG);
+    printf("                                  boots                          boot flash us             boot cpu us\n");
+    printf("table        size steps boots   old   new backup defaults mixed     clean      mean       max      mean       max\n");
+    printf("---------- ------ ----- ----- ----- ----- ------ -------- ----- --------- --------- --------- --------- ---------\n");
+    for (int i = 0; i < (int)(sizeof(tbls) / sizeof(tbls[0])); i++)
+    {
+        pc_report(tbls[i], &results[i]);
+    }
+    return((fails != 0) ? 2 : 0);
+}
@@ -0,0 +1,250 @@
+/*
+ * replay.c
+ *
+ * replays a recorded write trace through the real param.c on the simulated flash, with a virtual clock
+ * driving the automatic save timer, then reports flash wear of the workload :
+ *  - erases of each sector and bytes programmed
+ *  - write amplification, bytes programmed per byte of params whose value changed
+ *  - erases per day and projected lifetime of the hottest sector
+ *
+ * trace format, one event each line, times in ms and not decreasing, '#' starts a comment :
+ *  <time> <name> <value>      write a param of main table, value is text like param write, may have spaces
+ *  <time> save                explicit save by application
+ *
+ * usage : param_replay [-d delay] [-e cycles] trace
+ *  -d      automatic save delay in ms, default PARAM_AUTO_SAVE_DELAY, 0 - only explicit saves
+ *  -e      erase cycles of a sector, default 100000
+ */
+
+#include "../../src/param.c"    //white box, param_find_by_name and param_input_value are static
+#include <host_flash.h>
+#include <host_clock.h>
+#include <ctype.h>
+#include <unistd.h>
+
+#ifdef PARAM_USING_INDEX_ONLY
+#error "trace refers to params by name, replay can not be built with PARAM_USING_INDEX_ONLY"
+#endif
+
+#define REPLAY_LINE_MAX         512
+#define REPLAY_DAY_MS           (24.0 * 3600 * 1000)
+
+typedef struct{
+    u32 lines;              //events replayed
+    u32 writes;             //writes of params
+    u32 changes;            //writes which changed the value
+    u64 change_bytes;       //bytes of params whose value changed
+    u32 saves;              //explicit saves
+    u32 errors;             //bad lines and unknown params
+}replay_result_t;
+
+static u8 replay_old[PARAM_VALUE_MAX];
+static u8 replay_new[PARAM_VALUE_MAX];
+
+static int replay_write(param_tbl_t *tbl, const char *name, const char *value, replay_result_t *result)
+{
+    int idx = param_find_by_name(tbl, name);
+    int size;
+
+    if (idx < 0)
+    {
+        return(-RT_ERROR);
+    }
+    size = tbl->msgs[idx].size;
+    memset(replay_old, 0, sizeof(replay_old));
+    memset(replay_new, 0, sizeof(replay_new));
+    param_tbl_read_by_index(tbl, idx, replay_old, size);
+    param_input_value(replay_new, tbl->msgs[idx].type, size, value);
+    if (param_tbl_write_by_index(tbl, idx, replay_new, size) != RT_EOK)
+    {
+        return(-RT_ERROR);
+    }
+    memset(replay_new, 0, sizeof(replay_new));
+    param_tbl_read_by_index(tbl, idx, replay_new, size);
+    result->writes++;
+    if (memcmp(replay_old, replay_new, size) != 0)
+    {
+        result->changes++;
+        result->change_bytes += size;
+    }
+    return(RT_EOK);
+}
+
+static int replay_trace(param_tbl_t *tbl, FILE *fp, replay_result_t *result, u64 *duration)
+{
+    char line[REPLAY_LINE_MAX];
+    u64 first = 0, last = 0;
+    int num = 0;
+
+    while (fgets(line, sizeof(line), fp) != NULL)
+    {
+        char *p = line, *name, *value, *end;
+        u64 time;
+
+        num++;
+        line[strcspn(line, "#\r\n")] = 0;
+        while (isspace((int)*p))
+        {
+            p++;
+        }
+        if (*p == 0)
+        {
+            continue;
+        }
+        time = strtoull(p, &end, 10);
+        name = end + strspn(end, " \t");
+        value = name + strcspn(name, " \t");
+        if (*value != 0)
+        {
+            *value++ = 0;
+            value += strspn(value, " \t");
+        }
+        if ((end == p) || (*name == 0) || ((result->lines != 0) && (time < last)))
+        {
+            fprintf(stderr, "line %d: bad event, time must not decrease\n", num);
+            result->errors++;
+            continue;
+        }
+        if (result->lines == 0)
+        {
+            first = last = time;
+        }
+        host_clock_advance(time - last);
+        last = time;
+        result->lines++;
+
+        if (strcmp(name, "save") == 0)
+        {
+            param_tbl_save(tbl);
+            result->saves++;
+        }
+        else if (replay_write(tbl, name, value, result) != RT_EOK)
+        {
+            fprintf(stderr, "line %d: unknown param %s\n", num, name);
+            result->errors++;
+        }
+    }
+
+    *duration = last - first;
+    return(RT_EOK);
+}
+
+static const struct fal_partition *replay_part(param_tbl_t *tbl)//wear is measured on the simulated flash, NULL - other storage
+{
+    #ifdef PARAM_USING_BACKEND
+    return((tbl->cfg.backend == &param_backend_fal) ? (const struct fal_partition *)tbl->dev : NULL);
+    #else
+    return(tbl->part);
+    #endif
+}
+
+static void replay_report(param_tbl_t *tbl, const replay_result_t *result, u64 duration, u32 cycles)
+{
+    host_flash_stats_t st;
+    double days = duration / REPLAY_DAY_MS;
+    u32 first = replay_part(tbl)->offset / HOST_FLASH_SECTOR_SIZE;
+    u32 total = replay_part(tbl)->len / HOST_FLASH_SECTOR_SIZE;
+    u32 hot = first;
+
+    host_flash_get_stats(&st);
+    for (u32 i = first; i < first + total; i++)
+    {
+        if (st.sector_erases[i] > st.sector_erases[hot])
+        {
+            hot = i;
+        }
+    }
+
+    printf("events      : %u, writes %u, explicit saves %u, errors %u\n", result->lines, result->writes, result->saves, result->errors);
+    printf("duration    : %.3f days, automatic save delay %u ms\n", days, tbl->cfg.auto_save_delay);
+    printf("changes     : %u writes changed a value, %llu bytes of params\n", result->changes, (unsigned long long)result->change_bytes);
+    printf("flash       : %u sector erases, %llu bytes programmed, write amplification %.2f\n", st.erases,
+           (unsigned long long)st.prog_bytes, (result->change_bytes != 0) ? (double)st.prog_bytes / result->change_bytes : 0.0);
+    if ((days <= 0) || (st.sector_erases[hot] == 0))
+    {
+        printf("lifetime    : not limited by this trace\n");
+    }
+    else
+    {
+        double rate = st.sector_erases[hot] / days;
+        printf("erase rate  : %.2f erases/day of partition, hottest sector 0x%06X %.2f erases/day\n",
+               st.erases / days, (hot - first) * HOST_FLASH_SECTOR_SIZE, rate);
+        printf("lifetime    : %.2f years at %u erase cycles\n", cycles / rate / 365, cycles);
+    }
+
+    printf("\n");
+    printf("sector      erases      erases/day\n");
+    printf("----------  ----------  ----------\n");
+    for (u32 i = first; i < first + total; i++)
+    {
+        if (st.sector_erases[i] != 0)
+        {
+            printf("0x%06X    %-10u  %.2f\n", (i - first) * HOST_FLASH_SECTOR_SIZE, st.sector_erases[i],
+                   (days > 0) ? st.sector_erases[i] / days : 0.0);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    param_tbl_t *tbl = &param_tbl_main;
+    replay_result_t result;
+    u32 cycles = 100000;
+    u64 duration;
+    FILE *fp;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "d:e:")) != -1)
+    {
+        switch(opt)
+        {
+        case 'd':
+            tbl->cfg.auto_save_delay = atoi(optarg);
+            break;
+        case 'e':
+            cycles = atoi(optarg);
+            break;
+        default:
+            optind = argc;
+            break;
+        }
+    }
+    if ((optind != argc - 1) || (cycles == 0))
+    {
+        fprintf(stderr, "usage : %s [-d delay] [-e cycles] trace\n", argv[0]);
+        return(1);
+    }
+    fp = fopen(argv[optind], "r");
+    if (fp == NULL)
+    {
+        fprintf(stderr, "can not open %s\n", argv[optind]);
+        return(1);
+    }
+
+    host_clock_virtual();//before the automatic save timer is created
+    host_flash_open(NULL);
+    if (param_tbl_init(tbl) != RT_EOK)
+    {
+        fprintf(stderr, "param init fail\n");
+        return(1);
+    }
+    if (replay_part(tbl) == NULL)
+    {
+        fprintf(stderr, "main table is not on fal, flash wear can not be measured\n");
+        return(1);
+    }
+    #ifndef PARAM_USING_AUTO_SAVE
+    tbl->cfg.auto_save_delay = 0;
+    #endif
+    host_flash_reset_stats();
+
+    memset(&result, 0, sizeof(result));
+    replay_trace(tbl, fp, &result, &duration);
+    fclose(fp);
+    host_clock_advance(tbl->cfg.auto_save_delay);//the pending save is done like the device keeps running
+
+    printf("cfg         : %s\n", REPLAY_CFG);
+    replay_report(tbl, &result, duration, cycles);
+    param_tbl_deinit(tbl);
+    return((result.errors != 0) ? 2 : 0);
+}
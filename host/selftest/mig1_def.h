@@ -0,0 +1,26 @@
+/*
+ * mig1_def.h
+ *
+ * old layout of the migration check
+ */
+
+#ifdef PARAM_TABLE_DEF
+
+PARAM_BEGIN()
+PARAM_INT   (kp,        10)
+PARAM_FLOAT (ki,        0.5)
+PARAM_STRING(model,     15,     m1)
+PARAM_INT   (old_only,  3)
+PARAM_HEX   (reg,       A001)
+PARAM_ARRAY (mac,       4,      01 02 03 04)
+PARAM_INT   (neg,       -5)
+PARAM_INT64 (big,       5000000000)
+PARAM_STRING(longs,     15,     abc)
+#ifdef PARAM_USING_JOURNAL
+PARAM_COUNTER(runs,     0)
+#else
+PARAM_INT64 (runs,     0)    //counters need the journal
+#endif
+PARAM_END()
+
+#endif
@@ -0,0 +1,26 @@
+/*
+ * mig2_def.h
+ *
+ * new layout of the migration check, a param is inserted, one removed, the others reordered and resized
+ */
+
+#ifdef PARAM_TABLE_DEF
+
+PARAM_BEGIN()
+PARAM_STRING(model,     7,      m2)
+PARAM_INT   (new_one,   9)
+PARAM_DOUBLE(ki,        0.25)
+#ifdef PARAM_USING_JOURNAL
+PARAM_COUNTER(runs,     0)
+#else
+PARAM_INT64 (runs,     0)    //counters need the journal
+#endif
+PARAM_INT64 (kp,        1)
+PARAM_HEX64 (reg,       0)
+PARAM_ARRAY (mac,       6,      00 00 00 00 00 00)
+PARAM_HEX   (neg,       7)
+PARAM_INT   (big,       4)
+PARAM_STRING(longs,     3,      x)
+PARAM_END()
+
+#endif
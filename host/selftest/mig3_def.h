@@ -0,0 +1,15 @@
+/*
+ * mig3_def.h
+ *
+ * layout of the migration check whose names share a name hash, images of other layout are not migrated
+ */
+
+#ifdef PARAM_TABLE_DEF
+
+PARAM_BEGIN()
+PARAM_INT   (pffumztne, 1)
+PARAM_INT   (plmsyqcbl, 2)
+PARAM_INT   (kp,        3)
+PARAM_END()
+
+#endif
@@ -0,0 +1,915 @@
+/*
+ * selftest.c
+ *
+ * behaviour check of the real param.c on the simulated flash. each option of the build is exercised by a
+ * round trip through the api, the table is rebooted between the steps like the target :
+ *  - a table whose storage overlaps an initialized table is refused
+ *  - dynamic params are set, updated and deleted, then read back after a reboot, with PARAM_USING_DYNAMIC
+ *  - an image is loaded by a table of other layout, params inserted, removed, reordered and resized,
+ *    and a layout whose names share a hash refuses it, with PARAM_USING_MIGRATE
+ *  - full and sparse blobs are exported, imported over changed values and kept by a reboot,
+ *    a damaged blob changes nothing, with PARAM_USING_EXPORT
+ *  - delta blobs carry only the params changed since a generation of the same epoch, a reboot starts another epoch
+ *    and a stale generation gets all params, the biggest blob fits the import of command line, with PARAM_USING_DELTA
+ *  - text is fed in chunks split inside lines, bad values are error lines and staged values are kept by a reboot,
+ *    with a small PARAM_XIP_SHADOW_SIZE a batch larger than the pool is refused whole, with PARAM_USING_TEXT_IMPORT
+ *  - presets are stored and switched, the active one is kept by a reboot, and a power cut at each step of a switch
+ *    loads the old or the new preset with its journal params, never a mix, with PARAM_USING_PRESET
+ *  - both copies are counted once in the statistics of the table after a save by the backup thread,
+ *    with PARAM_USING_DUAL and PARAM_USING_STATS
+ *  - on the RAM backend and on an eeprom of the stub rt_device api, saves never erase and only write the changed
+ *    bytes and the heads, a power cut at each write loads the old or the new values, with PARAM_USING_BACKEND
+ * the run stops at the first check that does not hold.
+ *
+ * usage : param_selftest [-v]
+ *  -v      print the logs of param.c, they are discarded by default
+ */
+
+#ifndef PARAM_RAM_SIZE
+#define PARAM_RAM_SIZE          (32 * 1024)     //all storage of the test table on the RAM backend
+#endif
+
+#include "../../src/param.c"    //white box, the state of the table is checked
+#include <host_flash.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef PARAM_USING_INDEX_ONLY
+#error "the behaviour check reads params by name"
+#endif
+
+#define ST_ADDR                 0               //save address of the test table in user partition
+#define ST_MIG_ADDR             (48 * 1024)     //save address of the tables of each layout in the migration check
+#define ST_TWIN_ADDR            (ST_ADDR + PARAM_SECTOR_SIZE)   //save address of a table overlapping the test table
+
+#define PARAM_TABLE_NAME            st
+#define PARAM_TABLE_FILE            "st_def.h"
+#define PARAM_TABLE_PART_NAME       "user"
+#define PARAM_TABLE_SAVE_ADDR       ST_ADDR
+#define PARAM_TABLE_AUTO_SAVE_DELAY 0
+#include <param_table.h>
+
+#define PARAM_TABLE_NAME            st_twin
+#define PARAM_TABLE_FILE            "st_def.h"
+#define PARAM_TABLE_PART_NAME       "user"
+#define PARAM_TABLE_SAVE_ADDR       ST_TWIN_ADDR
+#define PARAM_TABLE_AUTO_SAVE_DELAY 0
+#include <param_table.h>
+
+#ifdef PARAM_USING_BACKEND
+#define ST_EEPROM_NAME          "eeprom0"       //rt_device of the simulated eeprom
+#define ST_EEPROM_SIZE          (32 * 1024)
+
+#define PARAM_TABLE_NAME            st_ram
+#define PARAM_TABLE_FILE            "st_def.h"
+#define PARAM_TABLE_BACKEND         &param_backend_ram
+#define PARAM_TABLE_SAVE_ADDR       0
+#define PARAM_TABLE_AUTO_SAVE_DELAY 0
+#include <param_table.h>
+
+#define PARAM_TABLE_NAME            st_eeprom
+#define PARAM_TABLE_FILE            "st_def.h"
+#define PARAM_TABLE_PART_NAME       ST_EEPROM_NAME
+#define PARAM_TABLE_BACKEND         &param_backend_eeprom
+#define PARAM_TABLE_SAVE_ADDR       0
+#define PARAM_TABLE_AUTO_SAVE_DELAY 0
+#include <param_table.h>
+#endif
+
+#ifdef PARAM_USING_MIGRATE
+#define PARAM_TABLE_NAME            mig1
+#define PARAM_TABLE_FILE            "mig1_def.h"
+#define PARAM_TABLE_PART_NAME       "user"
+#define PARAM_TABLE_SAVE_ADDR       ST_MIG_ADDR
+#define PARAM_TABLE_AUTO_SAVE_DELAY 0
+#include <param_table.h>
+
+#define PARAM_TABLE_NAME            mig2
+#define PARAM_TABLE_FILE            "mig2_def.h"
+#define PARAM_TABLE_PART_NAME       "user"
+#define PARAM_TABLE_SAVE_ADDR       ST_MIG_ADDR
+#define PARAM_TABLE_AUTO_SAVE_DELAY 0
+#include <param_table.h>
+
+#define PARAM_TABLE_NAME            mig3
+#define PARAM_TABLE_FILE            "mig3_def.h"
+#define PARAM_TABLE_PART_NAME       "user"
+#define PARAM_TABLE_SAVE_ADDR       ST_MIG_ADDR
+#define PARAM_TABLE_AUTO_SAVE_DELAY 0
+#include <param_table.h>
+#endif
+
+enum{
+    ST_NAME = 0,
+    ST_COUNT,
+    ST_TOTAL,
+    ST_MASK,
+    ST_RATIO,
+    ST_ENERGY,
+    ST_MAC,
+    ST_GAIN,
+    ST_HOURS,
+};
+
+//a check that does not hold ends the test of its feature
+#define ST_CHECK(cond)  do{ if (!(cond)) { st_fail(__func__, __LINE__, #cond); return(-RT_ERROR); } }while(0)
+
+static int st_verbose = 0;
+static int st_stderr = -1;              //saved stderr while logs are discarded
+
+static void st_quiet(int on)//logs of param.c are expected on refused calls, they are discarded
+{
+    if (st_verbose)
+    {
+        return;
+    }
+    fflush(stderr);
+    if (on && (st_stderr < 0))
+    {
+        int fd = open("/dev/null", O_WRONLY);
+        st_stderr = dup(2);
+        dup2(fd, 2);
+        close(fd);
+    }
+    else if (!on && (st_stderr >= 0))
+    {
+        dup2(st_stderr, 2);
+        close(st_stderr);
+        st_stderr = -1;
+    }
+}
+
+static void st_fail(const char *func, int line, const char *cond)
+{
+    st_quiet(0);
+    printf("%s line %d : %s\n", func, line, cond);
+}
+
+static int st_boot(param_tbl_t *tbl)//restart of the table like a reset of target
+{
+    int rst;
+
+    param_tbl_deinit(tbl);
+    rst = param_tbl_init(tbl);
+    if (rst == RT_EOK)
+    {
+        rst = param_tbl_load(tbl);
+    }
+    tbl->cfg.auto_save_delay = 0;//only the saves of the test
+    return(rst);
+}
+
+static int st_start(param_tbl_t *tbl)//blank flash, the table reads default
+{
+    param_tbl_deinit(tbl);
+    host_flash_format();
+    host_flash_power_cut(-1, 0);
+    if (param_tbl_init(tbl) != RT_EOK)
+    {
+        return(-RT_ERROR);
+    }
+    tbl->cfg.auto_save_delay = 0;
+    return(RT_EOK);
+}
+
+static s32 st_int(param_tbl_t *tbl, int idx)
+{
+    s32 val = 0;
+    param_tbl_read_by_index(tbl, idx, &val, sizeof(val));
+    return(val);
+}
+
+static int st_set_int(param_tbl_t *tbl, int idx, s32 val)
+{
+    return(param_tbl_write_by_index(tbl, idx, &val, sizeof(val)));
+}
+
+#ifdef PARAM_USING_DYNAMIC
+static int st_dynamic(param_tbl_t *tbl)
+{
+    char key[16], buf[32];
+    int made = 0;
+
+    ST_CHECK(st_start(tbl) == RT_EOK);
+    ST_CHECK(param_tbl_dyn_set(tbl, "alpha", "one", 4) == RT_EOK);
+    ST_CHECK(param_tbl_dyn_set(tbl, "beta", "two", 4) == RT_EOK);
+    ST_CHECK(param_tbl_dyn_set(tbl, "gamma", "three", 6) == RT_EOK);
+    ST_CHECK(param_tbl_dyn_set(tbl, "alpha", "uno-longer", 11) == RT_EOK);
+    ST_CHECK(param_tbl_dyn_delete(tbl, "beta") == RT_EOK);
+    ST_CHECK(param_tbl_dyn_delete(tbl, "beta") < 0);
+    ST_CHECK(param_tbl_save(tbl) == RT_EOK);
+    ST_CHECK(st_boot(tbl) == RT_EOK);
+    ST_CHECK(param_tbl_dyn_count(tbl) == 2);
+    ST_CHECK((param_tbl_dyn_get(tbl, "alpha", buf, sizeof(buf)) == 11) && (strcmp(buf, "uno-longer") == 0));
+    ST_CHECK((param_tbl_dyn_get(tbl, "gamma", buf, sizeof(buf)) == 6) && (strcmp(buf, "three") == 0));
+    ST_CHECK(param_tbl_dyn_get(tbl, "beta", buf, sizeof(buf)) < 0);
+
+    //updates leave garbage in the arena, it is compacted when the arena is full, live params are kept
+    for (int i = 0; i < 1000; i++)
+    {
+        snprintf(key, sizeof(key), "k%d", i % 8);
+        snprintf(buf, sizeof(buf), "value %d", i);
+        ST_CHECK(param_tbl_dyn_set(tbl, key, buf, strlen(buf) + 1) == RT_EOK);
+    }
+    ST_CHECK(param_tbl_save(tbl) == RT_EOK);
+    ST_CHECK(st_boot(tbl) == RT_EOK);
+    ST_CHECK(param_tbl_dyn_count(tbl) == 10);
+    for (int i = 992; i < 1000; i++)
+    {
+        char val[32];
+        snprintf(key, sizeof(key), "k%d", i % 8);
+        snprintf(val, sizeof(val), "value %d", i);
+        ST_CHECK((param_tbl_dyn_get(tbl, key, buf, sizeof(buf)) > 0) && (strcmp(buf, val) == 0));
+    }
+
+    //a full arena refuses new params and keeps the old ones
+    st_quiet(1);
+    for (made = 0; made < 10000; made++)
+    {
+        snprintf(key, sizeof(key), "fill%d", made);
+        if (param_tbl_dyn_set(tbl, key, "0123456789abcdef", 16) != RT_EOK)
+        {
+            break;
+        }
+    }
+    st_quiet(0);
+    ST_CHECK((made > 0) && (made < 10000));
+    ST_CHECK(10 + made == param_dyn_max_count(tbl));//with default sizes the index is full first, 96 params
+    ST_CHECK(param_tbl_save(tbl) == RT_EOK);
+    ST_CHECK(st_boot(tbl) == RT_EOK);
+    ST_CHECK(param_tbl_dyn_count(tbl) == 10 + made);
+    ST_CHECK((param_tbl_dyn_get(tbl, "alpha", buf, sizeof(buf)) == 11) && (strcmp(buf, "uno-longer") == 0));
+    snprintf(key, sizeof(key), "fill%d", made - 1);
+    ST_CHECK(param_tbl_dyn_get(tbl, key, buf, sizeof(buf)) == 16);
+
+    //static params are not touched by dynamic ones
+    ST_CHECK(st_int(tbl, ST_COUNT) == 25);
+    ST_CHECK(st_set_int(tbl, ST_COUNT, 77) == RT_EOK);
+    ST_CHECK(param_tbl_save(tbl) == RT_EOK);
+    ST_CHECK(st_boot(tbl) == RT_EOK);
+    ST_CHECK(st_int(tbl, ST_COUNT) == 77);
+    ST_CHECK(param_tbl_dyn_count(tbl) == 10 + made);
+    return(RT_EOK);
+}
+#endif
+
+#ifdef PARAM_USING_MIGRATE
+static int st_migrate(param_tbl_t *tbl)
+{
+    param_tbl_t *old = &param_tbl_mig1, *new = &param_tbl_mig2, *dup = &param_tbl_mig3;
+    host_flash_stats_t st0, st1;
+    s32 i32;
+    s64 i64;
+    u32 u;
+    u64 u64v;
+    f32 f;
+    f64 d;
+    u8 mac[6];
+    char str[16];
+
+    //values of the old layout, the counter only in journal if it is on
+    ST_CHECK(st_start(old) == RT_EOK);
+    ST_CHECK(st_set_int(old, 0, 77) == RT_EOK);//kp
+    f = 1.25f;
+    ST_CHECK(param_tbl_write_by_name(old, "ki", &f, sizeof(f)) == RT_EOK);
+    ST_CHECK(param_tbl_write_by_name(old, "model", "abc", 4) == RT_EOK);
+    ST_CHECK(param_tbl_write_by_name(old, "longs", "abcdefgh", 9) == RT_EOK);
+    u = 0xBEEF;
+    ST_CHECK(param_tbl_write_by_name(old, "reg", &u, sizeof(u)) == RT_EOK);
+    ST_CHECK(param_tbl_write_by_name(old, "mac", "\x09\x08\x07\x06", 4) == RT_EOK);
+    i32 = -9;
+    ST_CHECK(param_tbl_write_by_name(old, "neg", &i32, sizeof(i32)) == RT_EOK);
+    i64 = 6000000000LL;
+    ST_CHECK(param_tbl_write_by_name(old, "big", &i64, sizeof(i64)) == RT_EOK);
+    ST_CHECK(param_tbl_save(old) == RT_EOK);
+    u64v = 42;
+    ST_CHECK(param_tbl_write_by_name(old, "runs", &u64v, sizeof(u64v)) == RT_EOK);
+    #ifndef PARAM_USING_JOURNAL
+    ST_CHECK(param_tbl_save(old) == RT_EOK);
+    #endif
+    param_tbl_deinit(old);
+
+    //the new firmware maps each saved param by name, values that do not fit keep default
+    st_quiet(1);
+    ST_CHECK(st_boot(new) == RT_EOK);
+    st_quiet(0);
+    ST_CHECK((param_tbl_read_by_name(new, "kp", &i64, sizeof(i64)) == RT_EOK) && (i64 == 77));
+    ST_CHECK((param_tbl_read_by_name(new, "ki", &d, sizeof(d)) == RT_EOK) && (d == 1.25));
+    ST_CHECK((param_tbl_read_by_name(new, "model", str, sizeof(str)) == RT_EOK) && (strcmp(str, "abc") == 0));
+    ST_CHECK((param_tbl_read_by_name(new, "longs", str, sizeof(str)) == RT_EOK) && (strcmp(str, "x") == 0));
+    ST_CHECK((param_tbl_read_by_name(new, "reg", &u64v, sizeof(u64v)) == RT_EOK) && (u64v == 0xBEEF));
+    ST_CHECK((param_tbl_read_by_name(new, "mac", mac, sizeof(mac)) == RT_EOK) && (memcmp(mac, "\x09\x08\x07\x06\0\0", 6) == 0));
+    ST_CHECK((param_tbl_read_by_name(new, "neg", &u, sizeof(u)) == RT_EOK) && (u == 7));
+    ST_CHECK((param_tbl_read_by_name(new, "big", &i32, sizeof(i32)) == RT_EOK) && (i32 == 4));
+    ST_CHECK((param_tbl_read_by_name(new, "new_one", &i32, sizeof(i32)) == RT_EOK) && (i32 == 9));
+    ST_CHECK((param_tbl_read_by_name(new, "runs", &u64v, sizeof(u64v)) == RT_EOK) && (u64v == 42));
+
+    //the migrated image is written back once, the next boot loads it without migration
+    host_flash_get_stats(&st0);
+    ST_CHECK(st_boot(new) == RT_EOK);
+    host_flash_get_stats(&st1);
+    ST_CHECK(st1.erases == st0.erases);
+    ST_CHECK(new->mig == NULL);
+    ST_CHECK((param_tbl_read_by_name(new, "kp", &i64, sizeof(i64)) == RT_EOK) && (i64 == 77));
+    ST_CHECK((param_tbl_read_by_name(new, "runs", &u64v, sizeof(u64v)) == RT_EOK) && (u64v == 42));
+    param_tbl_deinit(new);
+
+    //names sharing a hash would swap values, the image of other layout is refused and defaults are read
+    ST_CHECK(param_hash("pffumztne", 9) == param_hash("plmsyqcbl", 9));
+    st_quiet(1);
+    ST_CHECK(st_boot(dup) != RT_EOK);
+    st_quiet(0);
+    ST_CHECK(dup->mig_dup);
+    ST_CHECK(st_int(dup, 0) == 1);
+    ST_CHECK(st_int(dup, 1) == 2);
+    ST_CHECK(st_int(dup, 2) == 3);
+    param_tbl_deinit(dup);
+    return(RT_EOK);
+}
+#endif
+
+#ifdef PARAM_USING_EXPORT
+static int st_export(param_tbl_t *tbl)
+{
+    static u8 full[512], sparse[512], bad[512];
+    int full_size, sparse_size;
+    char str[16];
+
+    ST_CHECK(st_start(tbl) == RT_EOK);
+    ST_CHECK(st_set_int(tbl, ST_COUNT, 77) == RT_EOK);
+    ST_CHECK(param_tbl_write_by_index(tbl, ST_NAME, "abc", 4) == RT_EOK);
+    ST_CHECK(st_set_int(tbl, ST_GAIN, 9) == RT_EOK);
+    full_size = param_tbl_export(tbl, full, sizeof(full), 0);
+    sparse_size = param_tbl_export(tbl, sparse, sizeof(sparse), PARAM_EXPORT_SPARSE);
+    ST_CHECK((full_size > 0) && (full_size == param_tbl_export(tbl, NULL, 0, 0)));
+    ST_CHECK((sparse_size > 0) && (sparse_size < full_size));
+    st_quiet(1);
+    ST_CHECK(param_tbl_export(tbl, full, full_size - 1, 0) < 0);
+    st_quiet(0);
+    ST_CHECK(param_tbl_export(tbl, full, sizeof(full), 0) == full_size);
+
+    //a full blob replaces all values, volatile params keep RAM values
+    ST_CHECK(st_set_int(tbl, ST_COUNT, 1) == RT_EOK);
+    ST_CHECK(st_set_int(tbl, ST_MASK, 5) == RT_EOK);
+    ST_CHECK(param_tbl_write_by_index(tbl, ST_NAME, "zz", 3) == RT_EOK);
+    ST_CHECK(st_set_int(tbl, ST_GAIN, 11) == RT_EOK);
+    ST_CHECK(param_tbl_import(tbl, full, full_size) == RT_EOK);
+    ST_CHECK(st_int(tbl, ST_COUNT) == 77);
+    ST_CHECK(st_int(tbl, ST_MASK) == 0xA001);
+    ST_CHECK(st_int(tbl, ST_GAIN) == 11);
+    ST_CHECK(st_boot(tbl) == RT_EOK);
+    ST_CHECK(st_int(tbl, ST_COUNT) == 77);
+    ST_CHECK((param_tbl_read_by_index(tbl, ST_NAME, str, sizeof(str)) == RT_EOK) && (strcmp(str, "abc") == 0));
+
+    //a sparse blob resumes params without record to default
+    ST_CHECK(st_set_int(tbl, ST_MASK, 5) == RT_EOK);
+    ST_CHECK(st_set_int(tbl, ST_COUNT, 2) == RT_EOK);
+    ST_CHECK(param_tbl_import(tbl, sparse, sparse_size) == RT_EOK);
+    ST_CHECK(st_int(tbl, ST_MASK) == 0xA001);
+    ST_CHECK(st_int(tbl, ST_COUNT) == 77);
+    ST_CHECK(st_boot(tbl) == RT_EOK);
+    ST_CHECK(st_int(tbl, ST_MASK) == 0xA001);
+
+    //damaged or short blobs are refused before any param is changed
+    ST_CHECK(st_set_int(tbl, ST_COUNT, 3) == RT_EOK);
+    memcpy(bad, full, full_size);
+    bad[full_size - 1] ^= 0x55;
+    st_quiet(1);
+    ST_CHECK(param_tbl_import(tbl, bad, full_size) < 0);
+    ST_CHECK(param_tbl_import(tbl, full, full_size - 1) < 0);
+    ST_CHECK(param_tbl_import(tbl, full, sizeof(param_export_head_t) - 1) < 0);
+    st_quiet(0);
+    ST_CHECK(st_int(tbl, ST_COUNT) == 3);
+    return(RT_EOK);
+}
+#endif
+
+#ifdef PARAM_USING_DELTA
+static int st_delta_recs(param_tbl_t *tbl, u32 epoch, u32 since, u32 *new_epoch, u32 *new_gen)//records of a delta export
+{
+    static u8 blob[512];
+    const u8 *pdata = blob + sizeof(param_export_head_t);
+    param_export_head_t head;
+    int size = param_tbl_delta_export(tbl, epoch, since, blob, sizeof(blob));
+    int pos = PARAM_DELTA_HEAD_SIZE, count = 0;
+
+    if (size <= 0)
+    {
+        return(-1);
+    }
+    memcpy(&head, blob, sizeof(head));
+    memcpy(new_epoch, pdata, sizeof(u32));
+    memcpy(new_gen, pdata + sizeof(u32), sizeof(u32));
+    for (; pos < head.size; pos += PARAM_EXPORT_REC_SIZE + pdata[pos + sizeof(u16)])
+    {
+        count++;
+    }
+    return(count);
+}
+
+static int st_delta(param_tbl_t *tbl)
+{
+    static u8 full[512];
+    int all = tbl->total - 1;//the volatile gain is never exported
+    u32 epoch, gen, e, g;
+    int size;
+
+    ST_CHECK(st_start(tbl) == RT_EOK);
+    epoch = param_tbl_epoch(tbl);
+    ST_CHECK(epoch != 0);
+    ST_CHECK(st_delta_recs(tbl, 0, 0, &e, &gen) == all);
+    ST_CHECK((e == epoch) && (gen == param_tbl_generation(tbl)));
+
+    //changes since the generation of the same epoch
+    ST_CHECK(st_set_int(tbl, ST_COUNT, 5) == RT_EOK);
+    ST_CHECK(st_set_int(tbl, ST_GAIN, 6) == RT_EOK);
+    ST_CHECK(st_delta_recs(tbl, epoch, gen, &e, &g) == 1);
+    ST_CHECK(st_delta_recs(tbl, epoch, g, &e, &g) == 0);
+    ST_CHECK(st_delta_recs(tbl, epoch + 1, g, &e, &g) == all);
+
+    //a reboot starts another epoch, a generation of the last run gets all params even after generations passed it
+    ST_CHECK(param_tbl_save(tbl) == RT_EOK);
+    ST_CHECK(st_boot(tbl) == RT_EOK);
+    ST_CHECK(param_tbl_epoch(tbl) != epoch);
+    for (int i = 0; param_tbl_generation(tbl) <= g + 1; i++)
+    {
+        ST_CHECK(st_set_int(tbl, ST_MASK, i) == RT_EOK);
+    }
+    ST_CHECK(st_delta_recs(tbl, epoch, g, &e, &gen) == all);
+    ST_CHECK(st_delta_recs(tbl, e, gen, &e, &gen) == 0);
+
+    //a delta blob of all params is imported whole
+    size = param_tbl_delta_export(tbl, 0, 0, full, sizeof(full));
+    ST_CHECK(size > 0);
+    #ifdef PARAM_USING_CLI
+    ST_CHECK(size <= param_import_max(tbl));
+    #endif
+    ST_CHECK(st_set_int(tbl, ST_COUNT, 1) == RT_EOK);
+    ST_CHECK(st_set_int(tbl, ST_MASK, 0x5555) == RT_EOK);
+    ST_CHECK(param_tbl_import(tbl, full, size) == RT_EOK);
+    ST_CHECK(st_int(tbl, ST_COUNT) == 5);
+    ST_CHECK(st_boot(tbl) == RT_EOK);
+    ST_CHECK(st_int(tbl, ST_COUNT) == 5);
+    ST_CHECK(st_int(tbl, ST_MASK) != 0x5555);
+    return(RT_EOK);
+}
+#endif
+
+#ifdef PARAM_USING_TEXT_IMPORT
+static int st_text_import(param_tbl_t *tbl, const char *text, int chunk)//feed text in chunks, return of param_text_end
+{
+    param_text_t ctx;
+    int len = strlen(text);
+
+    if (param_tbl_text_begin(tbl, &ctx) != RT_EOK)
+    {
+        return(-RT_ERROR);
+    }
+    for (int pos = 0; pos < len; pos += chunk)
+    {
+        param_text_feed(&ctx, text + pos, (len - pos < chunk) ? len - pos : chunk);
+    }
+    return(param_text_end(&ctx));
+}
+
+static int st_text(param_tbl_t *tbl)
+{
+    char str[16];
+    u8 mac[6];
+    f32 ratio = 0;
+    u64 hours = 0;
+    int rst;
+
+    ST_CHECK(st_start(tbl) == RT_EOK);
+    ST_CHECK(st_text_import(tbl, "count=42\nname = hello\r\n# comment\n\nratio=2.5\nmac=01 02 03 0a 0B ff\nhours=7", 5) == 0);
+    ST_CHECK(st_int(tbl, ST_COUNT) == 42);
+    ST_CHECK(st_boot(tbl) == RT_EOK);
+    ST_CHECK(st_int(tbl, ST_COUNT) == 42);
+    ST_CHECK((param_tbl_read_by_index(tbl, ST_NAME, str, sizeof(str)) == RT_EOK) && (strcmp(str, "hello") == 0));
+    ST_CHECK((param_tbl_read_by_index(tbl, ST_RATIO, &ratio, sizeof(ratio)) == RT_EOK) && (ratio == 2.5f));
+    ST_CHECK((param_tbl_read_by_index(tbl, ST_MAC, mac, sizeof(mac)) == RT_EOK) && (memcmp(mac, "\x01\x02\x03\x0a\x0b\xff", 6) == 0));
+    ST_CHECK((param_tbl_read_by_index(tbl, ST_HOURS, &hours, sizeof(hours)) == RT_EOK) && (hours == 7));
+
+    //values must be parsed whole and fit the param, other lines are still applied
+    st_quiet(1);
+    rst = st_text_import(tbl, "count=abc\ncount=12junk\nratio=1.5x\nmac=01 02 03 04 05 06 07\nmac=01 1FF\n"
+                              "name=a name that is too long\nnosuch=1\nno equal sign\nmask=zz\nmask=beef\n", 7);
+    st_quiet(0);
+    ST_CHECK(rst == 9);
+    ST_CHECK(st_int(tbl, ST_COUNT) == 42);
+    ST_CHECK(st_int(tbl, ST_MASK) == 0xBEEF);
+    ST_CHECK((param_tbl_read_by_index(tbl, ST_RATIO, &ratio, sizeof(ratio)) == RT_EOK) && (ratio == 2.5f));
+    ST_CHECK((param_tbl_read_by_index(tbl, ST_MAC, mac, sizeof(mac)) == RT_EOK) && (memcmp(mac, "\x01\x02\x03\x0a\x0b\xff", 6) == 0));
+
+    #if defined(PARAM_USING_XIP) && (PARAM_XIP_SHADOW_SIZE < 128)
+    //the shadows of a batch are reserved first, a short pool is saved before the batch, never in the middle of it
+    ST_CHECK(st_set_int(tbl, ST_COUNT, 43) == RT_EOK);
+    ST_CHECK(st_set_int(tbl, ST_GAIN, 44) == RT_EOK);
+    ST_CHECK(st_text_import(tbl, "name=n\ntotal=2\nenergy=5\nmac=06\n", 64) == 0);
+    ST_CHECK(tbl->xip_used <= PARAM_XIP_SHADOW_SIZE);
+    ST_CHECK(st_int(tbl, ST_COUNT) == 43);
+    ST_CHECK(st_int(tbl, ST_GAIN) == 44);
+    ST_CHECK((param_tbl_read_by_index(tbl, ST_NAME, str, sizeof(str)) == RT_EOK) && (strcmp(str, "n") == 0));
+    ST_CHECK((param_tbl_read_by_index(tbl, ST_MAC, mac, sizeof(mac)) == RT_EOK) && (memcmp(mac, "\x06\0\0\0\0\0", 6) == 0));
+
+    //a batch the pool can not hold changes nothing
+    ST_CHECK(st_boot(tbl) == RT_EOK);
+    st_quiet(1);
+    rst = st_text_import(tbl, "name=m\ncount=1\ntotal=3\nmask=3\nratio=4\nenergy=6\nmac=07\nhours=8\n", 64);
+    st_quiet(0);
+    ST_CHECK(rst < 0);
+    ST_CHECK(st_int(tbl, ST_COUNT) == 43);
+    ST_CHECK(st_int(tbl, ST_MASK) == 0xBEEF);
+    ST_CHECK(st_boot(tbl) == RT_EOK);
+    ST_CHECK(st_int(tbl, ST_COUNT) == 43);
+    ST_CHECK(st_int(tbl, ST_MASK) == 0xBEEF);
+    #endif
+    return(RT_EOK);
+}
+#endif
+
+#ifdef PARAM_USING_PRESET
+static u64 st_hours(param_tbl_t *tbl)
+{
+    u64 val = 0;
+    param_tbl_read_by_index(tbl, ST_HOURS, &val, sizeof(val));
+    return(val);
+}
+
+static int st_set_hours(param_tbl_t *tbl, u64 val)
+{
+    return(param_tbl_write_by_index(tbl, ST_HOURS, &val, sizeof(val)));
+}
+
+static int st_preset_is(param_tbl_t *tbl, s32 count, u64 hours, const char *name)//values and active preset are of one state
+{
+    const char *active = param_tbl_preset_active(tbl);
+
+    if ((st_int(tbl, ST_COUNT) != count) || (st_hours(tbl) != hours))
+    {
+        return(0);
+    }
+    return((name == NULL) ? (active == NULL) : ((active != NULL) && (strcmp(active, name) == 0)));
+}
+
+static int st_preset_base(param_tbl_t *tbl, const char *from)//two presets are stored, the saved image or preset from is live
+{
+    ST_CHECK(st_start(tbl) == RT_EOK);
+    ST_CHECK(st_set_int(tbl, ST_COUNT, 11) == RT_EOK);
+    ST_CHECK(st_set_hours(tbl, 111) == RT_EOK);
+    ST_CHECK(param_tbl_preset_store(tbl, "normal") == RT_EOK);
+    ST_CHECK(st_set_int(tbl, ST_COUNT, 22) == RT_EOK);
+    ST_CHECK(st_set_hours(tbl, 222) == RT_EOK);
+    ST_CHECK(param_tbl_preset_store(tbl, "commission") == RT_EOK);
+    ST_CHECK(st_set_int(tbl, ST_COUNT, 33) == RT_EOK);
+    ST_CHECK(st_set_hours(tbl, 333) == RT_EOK);
+    ST_CHECK(param_tbl_save(tbl) == RT_EOK);
+    if (from != NULL)
+    {
+        ST_CHECK(param_tbl_preset_switch(tbl, from) == RT_EOK);
+    }
+    ST_CHECK(st_set_int(tbl, ST_GAIN, 9) == RT_EOK);
+    return(RT_EOK);
+}
+
+//power is cut at each step of the switch from one state to the other, the reboot loads one of them
+static int st_preset_cut(param_tbl_t *tbl, const char *from, s32 old_count, u64 old_hours, const char *to, s32 new_count, u64 new_hours)
+{
+    int done = 0;
+
+    for (int step = 0; !done; step++)
+    {
+        for (int half = 0; half < 2; half++)
+        {
+            #ifdef PARAM_USING_JOURNAL
+            u64 hours;
+            #endif
+
+            ST_CHECK(step < 64);
+            ST_CHECK(st_preset_base(tbl, from) == RT_EOK);
+            st_quiet(1);
+            host_flash_power_cut(step, half);
+            param_tbl_preset_switch(tbl, to);
+            done = !host_flash_power_lost();
+            host_flash_power_cut(-1, 0);
+            ST_CHECK(st_boot(tbl) == RT_EOK);
+            st_quiet(0);
+            ST_CHECK(st_preset_is(tbl, old_count, old_hours, from) || st_preset_is(tbl, new_count, new_hours, to));
+            ST_CHECK(!done || st_preset_is(tbl, new_count, new_hours, to));
+
+            #ifdef PARAM_USING_JOURNAL
+            //the journal goes on from the snapshot in effect
+            hours = st_hours(tbl) + 1;
+            ST_CHECK(st_set_hours(tbl, hours) == RT_EOK);
+            ST_CHECK(st_boot(tbl) == RT_EOK);
+            ST_CHECK(st_hours(tbl) == hours);
+            #endif
+        }
+    }
+    return(RT_EOK);
+}
+
+static int st_preset(param_tbl_t *tbl)
+{
+    ST_CHECK(st_preset_base(tbl, NULL) == RT_EOK);
+    ST_CHECK(param_tbl_preset_switch(tbl, "normal") == RT_EOK);
+    ST_CHECK(st_preset_is(tbl, 11, 111, "normal"));
+    ST_CHECK(st_int(tbl, ST_GAIN) == 9);
+    ST_CHECK(st_boot(tbl) == RT_EOK);
+    ST_CHECK(st_preset_is(tbl, 11, 111, "normal"));
+    ST_CHECK(param_tbl_preset_switch(tbl, "commission") == RT_EOK);
+    ST_CHECK(st_preset_is(tbl, 22, 222, "commission"));
+    ST_CHECK(st_boot(tbl) == RT_EOK);
+    ST_CHECK(st_preset_is(tbl, 22, 222, "commission"));
+    st_quiet(1);
+    ST_CHECK(param_tbl_preset_switch(tbl, "none") < 0);
+    st_quiet(0);
+
+    //a save puts the saved image in effect with the values of the preset
+    ST_CHECK(st_set_int(tbl, ST_COUNT, 44) == RT_EOK);
+    ST_CHECK(param_tbl_save(tbl) == RT_EOK);
+    ST_CHECK(st_preset_is(tbl, 44, 222, NULL));
+    ST_CHECK(st_boot(tbl) == RT_EOK);
+    ST_CHECK(st_preset_is(tbl, 44, 222, NULL));
+
+    ST_CHECK(st_preset_cut(tbl, NULL, 33, 333, "normal", 11, 111) == RT_EOK);
+    ST_CHECK(st_preset_cut(tbl, "normal", 11, 111, "commission", 22, 222) == RT_EOK);
+    return(RT_EOK);
+}
+#endif
+
+#if defined(PARAM_USING_DUAL) && defined(PARAM_USING_STATS)
+static int st_dual(param_tbl_t *tbl)
+{
+    param_stats_t *st = &tbl->stats;
+    u32 bak_erases = 0;
+
+    ST_CHECK(st_start(tbl) == RT_EOK);
+    memset(st, 0, sizeof(*st));
+    for (int i = 0; i < 4; i++)
+    {
+        ST_CHECK(st_set_int(tbl, ST_COUNT, 100 + i) == RT_EOK);
+        ST_CHECK(param_tbl_save(tbl) == RT_EOK);
+    }
+    //the copies are the same image, the backup one is written by the thread and added after it
+    ST_CHECK(st->prog_bytes[PSTAT_RGN_IMAGE] > 0);
+    ST_CHECK(st->prog_bytes[PSTAT_RGN_BACKUP] == st->prog_bytes[PSTAT_RGN_IMAGE]);
+    ST_CHECK(st->erase_bytes[PSTAT_RGN_BACKUP] == 4 * PARAM_SECTOR_SIZE);
+    for (int i = 0; i < PARAM_STATS_SECTORS; i++)
+    {
+        if (st->sectors[i].addr & PARAM_ADDR_BAK)
+        {
+            bak_erases += st->sectors[i].erases;
+        }
+    }
+    ST_CHECK(bak_erases == 4);
+    #if PARAM_DUAL_THREAD_PRIORITY > 0
+    ST_CHECK(param_dual_tbl == NULL);
+    ST_CHECK(param_dual_stats.prog_bytes[PSTAT_RGN_BACKUP] == 0);
+    #endif
+    st_quiet(1);//the blank dynamic area is logged with PARAM_USING_DYNAMIC
+    ST_CHECK(st_boot(tbl) == RT_EOK);
+    st_quiet(0);
+    ST_CHECK(st_int(tbl, ST_COUNT) == 103);
+    return(RT_EOK);
+}
+#endif
+
+#if defined(PARAM_USING_BACKEND) && !defined(PARAM_USING_EXT_IMAGE) && !defined(PARAM_USING_PRE_ERASE) && !defined(PARAM_USING_DUAL)
+static param_backend_t st_io;           //backend of the table under test, the real one with counted writes and erases
+static const param_backend_t *st_io_base;
+static u32 st_io_erases;
+static u32 st_io_bytes;                 //bytes written, the torn part of the last write included
+static int st_io_left = -1;             //writes before the power is lost, the last one is torn, -1 - never
+
+static int st_io_write(void *dev, u32 addr, const u8 *buf, u32 size)
+{
+    if (st_io_left == 0)//no power, nothing is written
+    {
+        return(-RT_ERROR);
+    }
+    if ((st_io_left > 0) && (--st_io_left == 0))
+    {
+        st_io_bytes += size / 2;
+        if (size / 2 > 0)
+        {
+            st_io_base->write(dev, addr, buf, size / 2);
+        }
+        return(-RT_ERROR);
+    }
+    st_io_bytes += size;
+    return(st_io_base->write(dev, addr, buf, size));
+}
+
+static int st_io_erase(void *dev, u32 addr, u32 size)
+{
+    st_io_erases++;
+    return(st_io_base->erase(dev, addr, size));
+}
+
+static void st_io_hook(param_tbl_t *tbl)
+{
+    st_io_base = tbl->cfg.backend;
+    st_io = *st_io_base;
+    st_io.write = st_io_write;
+    st_io.erase = st_io_erase;
+    tbl->cfg.backend = &st_io;
+    st_io_left = -1;
+}
+
+static u8 st_eeprom_mem[ST_EEPROM_SIZE];
+static struct rt_device st_eeprom_dev;
+
+static rt_size_t st_eeprom_read(rt_device_t dev, rt_off_t pos, void *buffer, rt_size_t size)
+{
+    if ((pos < 0) || (pos + size > ST_EEPROM_SIZE))
+    {
+        return(0);
+    }
+    memcpy(buffer, st_eeprom_mem + pos, size);
+    return(size);
+}
+
+static rt_size_t st_eeprom_write(rt_device_t dev, rt_off_t pos, const void *buffer, rt_size_t size)
+{
+    if ((pos < 0) || (pos + size > ST_EEPROM_SIZE) || ((u32)pos / PARAM_EEPROM_PAGE_SIZE != (pos + size - 1) / PARAM_EEPROM_PAGE_SIZE))
+    {
+        return(0);//a write never crosses a page of the chip
+    }
+    memcpy(st_eeprom_mem + pos, buffer, size);
+    return(size);
+}
+
+static int st_in_place_is(param_tbl_t *tbl, s32 count, const char *name)
+{
+    char str[16];
+
+    return((st_int(tbl, ST_COUNT) == count)
+        && (param_tbl_read_by_index(tbl, ST_NAME, str, sizeof(str)) == RT_EOK) && (strcmp(str, name) == 0));
+}
+
+static int st_in_place(param_tbl_t *tbl, u8 *mem, u32 size)//round trip and power cuts on storage written in place
+{
+    const param_backend_t *backend = tbl->cfg.backend;
+    int fallbacks = 0;
+    int rst = -RT_ERROR;
+
+    st_io_hook(tbl);
+    param_tbl_deinit(tbl);
+    memset(mem, 0xFF, size);
+    ST_CHECK(param_tbl_init(tbl) == RT_EOK);
+    ST_CHECK(st_set_int(tbl, ST_COUNT, 77) == RT_EOK);
+    st_io_erases = 0;
+    ST_CHECK(param_tbl_save(tbl) == RT_EOK);
+    ST_CHECK(st_io_erases == 0);
+    st_quiet(1);//the blank dynamic area is logged with PARAM_USING_DYNAMIC
+    ST_CHECK(st_boot(tbl) == RT_EOK);
+    st_quiet(0);
+    ST_CHECK(st_int(tbl, ST_COUNT) == 77);
+
+    //one changed byte, only it and the head of each copy are written, nothing is erased
+    ST_CHECK(st_set_int(tbl, ST_COUNT, 78) == RT_EOK);
+    st_io_bytes = 0;
+    ST_CHECK(param_tbl_save(tbl) == RT_EOK);
+    ST_CHECK(st_io_erases == 0);
+    ST_CHECK(st_io_bytes == 2 * (1 + sizeof(param_head_t)));
+    st_quiet(1);
+    ST_CHECK(st_boot(tbl) == RT_EOK);
+    st_quiet(0);
+    ST_CHECK(st_int(tbl, ST_COUNT) == 78);
+
+    //the power is lost at each write of a save, the boot loads the old or the new values
+    for (int cut = 1; cut < 1000; cut++)
+    {
+        char old[16], name[16];
+        s32 count = st_int(tbl, ST_COUNT);
+
+        ST_CHECK(param_tbl_read_by_index(tbl, ST_NAME, old, sizeof(old)) == RT_EOK);
+        snprintf(name, sizeof(name), "cut%d", cut);
+        ST_CHECK(param_tbl_write_by_index(tbl, ST_NAME, name, strlen(name) + 1) == RT_EOK);
+        ST_CHECK(st_set_int(tbl, ST_COUNT, count + 1000) == RT_EOK);
+        st_io_left = cut;
+        st_io_bytes = 0;
+        st_quiet(1);
+        param_tbl_save(tbl);
+        st_quiet(0);
+        rst = (st_io_left != 0) ? RT_EOK : -RT_ERROR;//the save ends before the power is lost
+        st_io_left = -1;
+        st_quiet(1);
+        ST_CHECK(st_boot(tbl) == RT_EOK);
+        st_quiet(0);
+        ST_CHECK(st_in_place_is(tbl, count, old) || st_in_place_is(tbl, count + 1000, name));
+        if (rst == RT_EOK)
+        {
+            ST_CHECK(st_in_place_is(tbl, count + 1000, name));
+            break;
+        }
+        fallbacks += ((st_io_bytes > 0) && st_in_place_is(tbl, count, old));//the first copy is torn, the other one is loaded
+    }
+    ST_CHECK(rst == RT_EOK);
+    ST_CHECK(st_io_erases == 0);
+    ST_CHECK(fallbacks > 0);
+    param_tbl_deinit(tbl);
+    tbl->cfg.backend = backend;
+    return(RT_EOK);
+}
+
+static int st_ram(param_tbl_t *tbl)
+{
+    return(st_in_place(&param_tbl_st_ram, param_ram_open(NULL), PARAM_RAM_SIZE));
+}
+
+static int st_eeprom(param_tbl_t *tbl)
+{
+    if (rt_device_find(ST_EEPROM_NAME) == RT_NULL)
+    {
+        st_eeprom_dev.read = st_eeprom_read;
+        st_eeprom_dev.write = st_eeprom_write;
+        ST_CHECK(rt_device_register(&st_eeprom_dev, ST_EEPROM_NAME, 0) == RT_EOK);
+    }
+    return(st_in_place(&param_tbl_st_eeprom, st_eeprom_mem, sizeof(st_eeprom_mem)));
+}
+#endif
+
+typedef struct{
+    const char *name;
+    int (*test)(param_tbl_t *tbl);
+}st_case_t;
+
+static int st_overlap(param_tbl_t *tbl)
+{
+    ST_CHECK(st_start(tbl) == RT_EOK);
+    st_quiet(1);
+    ST_CHECK(param_tbl_init(&param_tbl_st_twin) != RT_EOK);
+    st_quiet(0);
+    ST_CHECK(param_tbl_find("st_twin") == NULL);
+
+    //the storage is free again when the test table is deinitialized
+    param_tbl_deinit(tbl);
+    ST_CHECK(param_tbl_init(&param_tbl_st_twin) == RT_EOK);
+    ST_CHECK(param_tbl_find("st_twin") == &param_tbl_st_twin);
+    param_tbl_deinit(&param_tbl_st_twin);
+    return(RT_EOK);
+}
+
+static const st_case_t st_cases[] = {
+    {"overlap",     st_overlap},
+    #ifdef PARAM_USING_DYNAMIC
+    {"dynamic",     st_dynamic},
+    #endif
+    #ifdef PARAM_USING_MIGRATE
+    {"migrate",     st_migrate},
+    #endif
+    #ifdef PARAM_USING_EXPORT
+    {"export",      st_export},
+    #endif
+    #ifdef PARAM_USING_DELTA
+    {"delta",       st_delta},
+    #endif
+    #ifdef PARAM_USING_TEXT_IMPORT
+    {"text",        st_text},
+    #endif
+    #ifdef PARAM_USING_PRESET
+    {"preset",      st_preset},
+    #endif
+    #if defined(PARAM_USING_DUAL) && defined(PARAM_USING_STATS)
+    {"dual",        st_dual},
+    #endif
+    #if defined(PARAM_USING_BACKEND) && !defined(PARAM_USING_EXT_IMAGE) && !defined(PARAM_USING_PRE_ERASE) && !defined(PARAM_USING_DUAL)
+    {"ram",         st_ram},
+    {"eeprom",      st_eeprom},
+    #endif
+    {NULL,          NULL},
+};
+
+int main(int argc, char **argv)
+{
+    int fails = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "v")) != -1)
+    {
+        switch(opt)
+        {
+        case 'v':
+            st_verbose = 1;
+            break;
+        default:
+            fprintf(stderr, "usage : %s [-v]\n", argv[0]);
+            return(1);
+        }
+    }
+
+    host_flash_open(NULL);
+    printf("cfg : %s\n", SELFTEST_CFG);
+    for (int i = 0; st_cases[i].name != NULL; i++)
+    {
+        int rst = st_cases[i].test(&param_tbl_st);
+
+        st_quiet(0);
+        printf("%-12s %s\n", st_cases[i].name, (rst == RT_EOK) ? "ok" : "FAIL");
+        fails += (rst != RT_EOK);
+    }
+    param_tbl_deinit(&param_tbl_st);
+    return((fails != 0) ? 2 : 0);
+}
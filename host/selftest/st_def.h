@@ -0,0 +1,26 @@
+/*
+ * st_def.h
+ *
+ * table of the behaviour check, one param of each type and persistence class,
+ * no include guard, it is expanded several times with PARAM_USING_COMPACT
+ */
+
+#ifdef PARAM_TABLE_DEF
+
+PARAM_BEGIN()
+PARAM_STRING(name,      15,     unit)
+PARAM_INT   (count,     25)
+PARAM_INT64 (total,     56789123456789)
+PARAM_HEX   (mask,      A001)
+PARAM_FLOAT (ratio,     1.5)
+PARAM_DOUBLE(energy,    87654321.125)
+PARAM_ARRAY (mac,       6,      AB CD EF 01 02 03)
+PARAM_INT   (gain,      5,      PARAM_VOLATILE)
+#ifdef PARAM_USING_JOURNAL
+PARAM_COUNTER(hours,    0)
+#else
+PARAM_INT64 (hours,    0)    //counters need the journal
+#endif
+PARAM_END()
+
+#endif
@@ -0,0 +1,38 @@
+/*
+ * crc16.c
+ *
+ * crc16 modbus of the host build, table driven like the target
+ */
+
+#include <crc16.h>
+
+static u16 crc16_tbl[256];
+
+__attribute__((constructor)) static void crc16_tbl_init(void)//before main, so threads never see a partial table
+{
+    for (int i = 0; i < 256; i++)
+    {
+        u16 crc = i;
+        for (int b = 0; b < 8; b++)
+        {
+            crc = (crc & 1) ? ((crc >> 1) ^ 0xA001) : (crc >> 1);
+        }
+        crc16_tbl[i] = crc;
+    }
+}
+
+u16 crc16_cyc_cal(u16 init_val, u8 *pdata, u32 len)
+{
+    u16 crc = init_val;
+    
+    while (len--)
+    {
+        crc = (crc >> 8) ^ crc16_tbl[(crc ^ *pdata++) & 0xFF];
+    }
+    return(crc);
+}
+
+u16 crc16_cal(u8 *pdata, u32 len)
+{
+    return(crc16_cyc_cal(0xFFFF, pdata, len));
+}
@@ -0,0 +1,15 @@
+/*
+ * crc16.h
+ *
+ * crc16 modbus of the host build, same result as the crc16 package of the target
+ */
+
+#ifndef __CRC16_H__
+#define __CRC16_H__
+
+#include <typedef.h>
+
+u16 crc16_cal(u8 *pdata, u32 len);
+u16 crc16_cyc_cal(u16 init_val, u8 *pdata, u32 len);
+
+#endif
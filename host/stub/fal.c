@@ -0,0 +1,307 @@
+/*
+ * fal.c
+ *
+ * fal partitions of the host build on the nor flash simulator
+ */
+
+#define _GNU_SOURCE
+#include <fal.h>
+#include <host_flash.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define HOST_FLASH_MAGIC        0x45503546  //magic of fal partition
+
+u8 host_flash_mem[HOST_FLASH_SIZE];
+
+static struct fal_flash_dev host_flash_devs[] = {
+    {HOST_FLASH_NAME,       0, HOST_FLASH_SIZE - HOST_FLASH_BAK_SIZE,   HOST_FLASH_SECTOR_SIZE},
+    {HOST_FLASH_BAK_NAME,   0, HOST_FLASH_BAK_SIZE,                     HOST_FLASH_SECTOR_SIZE},
+};
+static const u32 host_flash_bases[] = {0, HOST_FLASH_SIZE - HOST_FLASH_BAK_SIZE};//offset of each device in memory
+
+static const struct fal_partition host_parts[] = {
+    {HOST_FLASH_MAGIC, "param",     HOST_FLASH_NAME,        0,              64 * 1024,  0},
+    {HOST_FLASH_MAGIC, "bench",     HOST_FLASH_NAME,        64 * 1024,      256 * 1024, 0},
+    {HOST_FLASH_MAGIC, "user",      HOST_FLASH_NAME,        320 * 1024,     128 * 1024, 0},
+    {HOST_FLASH_MAGIC, "param_bak", HOST_FLASH_BAK_NAME,    0,              64 * 1024,  0},
+};
+
+static const host_flash_timing_t host_flash_timing_def = {
+    .erase_us = 45000,      //4K sector erase of spi nor flash, typical
+    .prog_us = 8,
+    .prog_byte_ns = 2700,   //256 bytes page in 0.7ms
+    .read_byte_ns = 160,    //50MHz single spi
+    .page_size = 256,
+    .delay = 0,
+};
+
+static pthread_mutex_t host_flash_lock = PTHREAD_MUTEX_INITIALIZER;//memory and statistics
+static pthread_mutex_t host_flash_dev_locks[] = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER};//one operation at a time on a device
+static host_flash_timing_t host_flash_timing = host_flash_timing_def;
+static host_flash_stats_t host_flash_stats;
+static int host_flash_fd = -1;
+static s32 host_flash_cut_steps = -1;       //steps before power is cut, -1 - never
+static u8 host_flash_cut_half;              //the step at power cut is half done
+static u8 host_flash_lost;                  //power was cut
+
+static int host_flash_step(u32 *len)//called with the memory lock before each step, len is cut to the bytes done, 0 - the step fails
+{
+    if (host_flash_lost)
+    {
+        *len = 0;
+        return(0);
+    }
+    if (host_flash_cut_steps > 0)
+    {
+        host_flash_cut_steps--;
+        return(1);
+    }
+    if (host_flash_cut_steps == 0)
+    {
+        host_flash_lost = 1;
+        *len = host_flash_cut_half ? *len / 2 : 0;
+        return(0);
+    }
+    return(1);
+}
+
+static void host_flash_busy(u64 ns)//called with the memory lock, it is released while waiting, the device lock is kept
+{
+    host_flash_stats.busy_ns += ns;
+    if (host_flash_timing.delay)
+    {
+        struct timespec ts = {ns / 1000000000, ns % 1000000000};
+        pthread_mutex_unlock(&host_flash_lock);
+        while ((nanosleep(&ts, &ts) != 0) && (errno == EINTR));
+        pthread_mutex_lock(&host_flash_lock);
+    }
+}
+
+static int host_flash_dev_index(const struct fal_partition *part)
+{
+    return((strcmp(part->flash_name, HOST_FLASH_BAK_NAME) == 0) ? 1 : 0);
+}
+
+static void host_flash_lock_part(const struct fal_partition *part)
+{
+    pthread_mutex_lock(&host_flash_dev_locks[host_flash_dev_index(part)]);
+    pthread_mutex_lock(&host_flash_lock);
+}
+
+static void host_flash_unlock_part(const struct fal_partition *part)
+{
+    pthread_mutex_unlock(&host_flash_lock);
+    pthread_mutex_unlock(&host_flash_dev_locks[host_flash_dev_index(part)]);
+}
+
+static void host_flash_sync(u32 addr, u32 size)//mirror to file
+{
+    if (host_flash_fd >= 0)
+    {
+        if (pwrite(host_flash_fd, host_flash_mem + addr, size, addr) != size)
+        {
+            fprintf(stderr, "host flash write file fail.\n");
+        }
+    }
+}
+
+int host_flash_open(const char *file)
+{
+    host_flash_close();
+    memset(host_flash_mem, 0xFF, sizeof(host_flash_mem));
+    host_flash_reset_stats();
+    if (file == NULL)
+    {
+        return(0);
+    }
+    host_flash_fd = open(file, O_RDWR | O_CREAT, 0644);
+    if (host_flash_fd < 0)
+    {
+        return(-1);
+    }
+    if (pread(host_flash_fd, host_flash_mem, sizeof(host_flash_mem), 0) != sizeof(host_flash_mem))//new file
+    {
+        memset(host_flash_mem, 0xFF, sizeof(host_flash_mem));
+        host_flash_sync(0, sizeof(host_flash_mem));
+    }
+    return(0);
+}
+
+void host_flash_close(void)
+{
+    if (host_flash_fd >= 0)
+    {
+        close(host_flash_fd);
+        host_flash_fd = -1;
+    }
+}
+
+void host_flash_format(void)
+{
+    pthread_mutex_lock(&host_flash_lock);
+    memset(host_flash_mem, 0xFF, sizeof(host_flash_mem));
+    host_flash_sync(0, sizeof(host_flash_mem));
+    pthread_mutex_unlock(&host_flash_lock);
+}
+
+void host_flash_set_timing(const host_flash_timing_t *timing)
+{
+    pthread_mutex_lock(&host_flash_lock);
+    host_flash_timing = (timing != NULL) ? *timing : host_flash_timing_def;
+    pthread_mutex_unlock(&host_flash_lock);
+}
+
+void host_flash_get_stats(host_flash_stats_t *stats)
+{
+    pthread_mutex_lock(&host_flash_lock);
+    *stats = host_flash_stats;
+    pthread_mutex_unlock(&host_flash_lock);
+}
+
+void host_flash_reset_stats(void)
+{
+    pthread_mutex_lock(&host_flash_lock);
+    memset(&host_flash_stats, 0, sizeof(host_flash_stats));
+    pthread_mutex_unlock(&host_flash_lock);
+}
+
+void host_flash_power_cut(s32 steps, u8 half)
+{
+    pthread_mutex_lock(&host_flash_lock);
+    host_flash_cut_steps = steps;
+    host_flash_cut_half = half;
+    host_flash_lost = 0;
+    pthread_mutex_unlock(&host_flash_lock);
+}
+
+int host_flash_power_lost(void)
+{
+    int lost;
+    
+    pthread_mutex_lock(&host_flash_lock);
+    lost = host_flash_lost;
+    pthread_mutex_unlock(&host_flash_lock);
+    return(lost);
+}
+
+const struct fal_flash_dev *fal_flash_device_find(const char *name)
+{
+    for (int i = 0; i < (int)(sizeof(host_flash_devs) / sizeof(host_flash_devs[0])); i++)
+    {
+        if (strcmp(host_flash_devs[i].name, name) == 0)
+        {
+            host_flash_devs[i].addr = (uint32_t)(uintptr_t)(host_flash_mem + host_flash_bases[i]);//needs a non-pie executable, like a 32 bits target
+            return(&host_flash_devs[i]);
+        }
+    }
+    return(NULL);
+}
+
+const struct fal_partition *fal_partition_find(const char *name)
+{
+    for (int i = 0; i < (int)(sizeof(host_parts) / sizeof(host_parts[0])); i++)
+    {
+        if (strcmp(host_parts[i].name, name) == 0)
+        {
+            return(&host_parts[i]);
+        }
+    }
+    return(NULL);
+}
+
+int fal_partition_read(const struct fal_partition *part, uint32_t addr, uint8_t *buf, size_t size)
+{
+    if ((u64)addr + size > part->len)
+    {
+        return(-1);
+    }
+    host_flash_lock_part(part);
+    memcpy(buf, host_flash_mem + host_flash_bases[host_flash_dev_index(part)] + part->offset + addr, size);
+    host_flash_stats.reads++;
+    host_flash_stats.read_bytes += size;
+    host_flash_busy((u64)size * host_flash_timing.read_byte_ns);
+    host_flash_unlock_part(part);
+    return(size);
+}
+
+int fal_partition_write(const struct fal_partition *part, uint32_t addr, const uint8_t *buf, size_t size)
+{
+    u32 pos = host_flash_bases[host_flash_dev_index(part)] + part->offset + addr;
+    u32 page = host_flash_timing.page_size;
+    int rst = size;
+    
+    if ((u64)addr + size > part->len)
+    {
+        return(-1);
+    }
+    host_flash_lock_part(part);
+    for (u32 i = 0; i < size; )
+    {
+        u32 len = page - (pos + i) % page;//split at page boundaries
+        int done;
+        if (len > size - i)
+        {
+            len = size - i;
+        }
+        done = host_flash_step(&len);
+        for (u32 n = i; n < i + len; n++)
+        {
+            u8 *p = host_flash_mem + pos + n;
+            if (buf[n] & ~*p)
+            {
+                host_flash_stats.bit_errors++;
+            }
+            *p &= buf[n];
+        }
+        host_flash_sync(pos + i, len);
+        if (!done)
+        {
+            rst = -1;
+            break;
+        }
+        host_flash_stats.programs++;
+        host_flash_stats.prog_bytes += len;
+        host_flash_busy((u64)host_flash_timing.prog_us * 1000 + (u64)len * host_flash_timing.prog_byte_ns);
+        i += len;
+    }
+    host_flash_unlock_part(part);
+    return(rst);
+}
+
+int fal_partition_erase(const struct fal_partition *part, uint32_t addr, size_t size)
+{
+    u32 begin, end;
+    int rst = size;
+    
+    if ((u64)addr + size > part->len)
+    {
+        return(-1);
+    }
+    addr += host_flash_bases[host_flash_dev_index(part)] + part->offset;
+    begin = addr / HOST_FLASH_SECTOR_SIZE;//whole sectors are erased like fal
+    end = (addr + size + HOST_FLASH_SECTOR_SIZE - 1) / HOST_FLASH_SECTOR_SIZE;
+    host_flash_lock_part(part);
+    for (u32 s = begin; s < end; s++)
+    {
+        u32 len = HOST_FLASH_SECTOR_SIZE;
+        int done = host_flash_step(&len);
+        memset(host_flash_mem + s * HOST_FLASH_SECTOR_SIZE, 0xFF, len);
+        host_flash_sync(s * HOST_FLASH_SECTOR_SIZE, len);
+        if (!done)
+        {
+            rst = -1;
+            break;
+        }
+        host_flash_stats.erases++;
+        host_flash_stats.sector_erases[s]++;
+        host_flash_busy((u64)host_flash_timing.erase_us * 1000);
+    }
+    host_flash_unlock_part(part);
+    return(rst);
+}
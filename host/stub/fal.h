@@ -0,0 +1,40 @@
+/*
+ * fal.h
+ *
+ * fal of the host build, partitions are on a simulated nor flash, see host_flash.h
+ */
+
+#ifndef _FAL_H_
+#define _FAL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define FAL_DEV_NAME_MAX        24
+
+struct fal_flash_dev
+{
+    char name[FAL_DEV_NAME_MAX];
+    uint32_t addr;              //memory mapped address of flash
+    size_t len;
+    size_t blk_size;            //sector size
+};
+
+struct fal_partition
+{
+    uint32_t magic_word;
+    char name[FAL_DEV_NAME_MAX];
+    char flash_name[FAL_DEV_NAME_MAX];
+    long offset;
+    size_t len;
+    uint32_t reserved;
+};
+typedef struct fal_partition *fal_partition_t;
+
+const struct fal_flash_dev *fal_flash_device_find(const char *name);
+const struct fal_partition *fal_partition_find(const char *name);
+int fal_partition_read(const struct fal_partition *part, uint32_t addr, uint8_t *buf, size_t size);
+int fal_partition_write(const struct fal_partition *part, uint32_t addr, const uint8_t *buf, size_t size);
+int fal_partition_erase(const struct fal_partition *part, uint32_t addr, size_t size);
+
+#endif
@@ -0,0 +1,19 @@
+/*
+ * host_clock.h
+ *
+ * virtual clock of the host build, for simulations faster than real time :
+ *  - after host_clock_virtual, rt_tick_get only advances by host_clock_advance
+ *  - timers are not fired by the timer thread, host_clock_advance fires the due timers in order in the calling thread
+ *  - it must be switched on before any timer is created
+ */
+
+#ifndef __HOST_CLOCK_H__
+#define __HOST_CLOCK_H__
+
+#include <typedef.h>
+
+void host_clock_virtual(void);
+u64 host_clock_now(void);                   //ticks of virtual clock, not wrapped
+void host_clock_advance(u64 ticks);
+
+#endif
@@ -0,0 +1,66 @@
+/*
+ * host_flash.h
+ *
+ * nor flash simulator of the host build, fal partitions are on it :
+ *  - programming only clears bits, erasing sets a whole sector to 0xFF
+ *  - the flash is in RAM, or mirrored to a file so it survives runs
+ *  - each operation takes simulated time, it is accumulated, or really waited when delay is set
+ *  - counters of operations and erase count of each sector are kept for wear and cost analysis
+ *  - power can be cut at a chosen step, a step is the erase of one sector or the program of one page,
+ *    the step is left half done and all later erases and programs fail, like the device is off
+ *
+ * devices share one memory, norflash0 is at its beginning and norflash1 at its end, operations on
+ * different devices run in parallel when the simulated time is really waited
+ *
+ * partitions :
+ *  name        device      offset      size
+ *  param       norflash0   0           64K     main table
+ *  bench       norflash0   64K         256K    benchmark tables
+ *  user        norflash0   320K        128K    free for tools
+ *  param_bak   norflash1   0           64K     backup copies on a second device
+ */
+
+#ifndef __HOST_FLASH_H__
+#define __HOST_FLASH_H__
+
+#include <typedef.h>
+
+#define HOST_FLASH_NAME         "norflash0"
+#define HOST_FLASH_BAK_NAME     "norflash1"
+#define HOST_FLASH_SIZE         (512 * 1024)    //memory of all devices
+#define HOST_FLASH_BAK_SIZE     (64 * 1024)     //norflash1, at the end of memory
+#define HOST_FLASH_SECTOR_SIZE  4096
+#define HOST_FLASH_SECTORS      (HOST_FLASH_SIZE / HOST_FLASH_SECTOR_SIZE)
+
+typedef struct{
+    u32 erase_us;           //time of erasing one sector
+    u32 prog_us;            //setup time of each page programmed
+    u32 prog_byte_ns;       //time of programming one byte
+    u32 read_byte_ns;       //time of reading one byte
+    u32 page_size;          //bytes of program page, a write is split at page boundaries
+    u8 delay;               //1 - really wait for the simulated time
+}host_flash_timing_t;
+
+typedef struct{
+    u32 erases;             //sectors erased
+    u32 programs;           //pages programmed
+    u64 prog_bytes;         //bytes programmed
+    u64 read_bytes;         //bytes read
+    u32 reads;              //read operations
+    u32 bit_errors;         //programmed bits which were 0 but written 1, they stay 0 like nor flash
+    u64 busy_ns;            //simulated time of all operations
+    u32 sector_erases[HOST_FLASH_SECTORS];  //erase count of each sector of memory
+}host_flash_stats_t;
+
+extern u8 host_flash_mem[HOST_FLASH_SIZE];  //mapped at its address, for execute-in-place read
+
+int host_flash_open(const char *file);      //file NULL - RAM only, all bytes erased
+void host_flash_close(void);
+void host_flash_format(void);               //erase all without counting
+void host_flash_set_timing(const host_flash_timing_t *timing);  //NULL - default of spi nor flash
+void host_flash_get_stats(host_flash_stats_t *stats);
+void host_flash_reset_stats(void);
+void host_flash_power_cut(s32 steps, u8 half);  //power is cut at the step of number steps from now, half - half of its bytes are done, -1 - never
+int host_flash_power_lost(void);            //1 - power was cut, erases and programs fail until host_flash_power_cut is called
+
+#endif
@@ -0,0 +1,17 @@
+/*
+ * rtconfig.h
+ *
+ * configuration of the host build, param options are given by CFG of the Makefile
+ */
+
+#ifndef RT_CONFIG_H__
+#define RT_CONFIG_H__
+
+#define RT_NAME_MAX             8
+#define RT_TICK_PER_SECOND      1000
+#define RT_THREAD_PRIORITY_MAX  32
+#define RT_USING_DEVICE                 //rt_device api of stub
+#define RT_USING_DFS                    //posix file api of host
+#define PARAM_BOOT_EPOCH()      host_boot_epoch()//differs in each run of a host tool, see rtthread.h
+
+#endif
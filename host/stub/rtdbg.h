@@ -0,0 +1,21 @@
+/*
+ * rtdbg.h
+ *
+ * log of the host build, errors and warnings go to stderr, so benchmark output is kept clean
+ */
+
+#ifndef __RTDBG_H__
+#define __RTDBG_H__
+
+#include <stdio.h>
+
+#ifndef DBG_TAG
+#define DBG_TAG                 "host"
+#endif
+
+#define LOG_E(fmt, ...)         fprintf(stderr, "[E/%s] " fmt "\n", DBG_TAG, ##__VA_ARGS__)
+#define LOG_W(fmt, ...)         fprintf(stderr, "[W/%s] " fmt "\n", DBG_TAG, ##__VA_ARGS__)
+#define LOG_I(fmt, ...)         fprintf(stderr, "[I/%s] " fmt "\n", DBG_TAG, ##__VA_ARGS__)
+#define LOG_D(fmt, ...)
+
+#endif
@@ -0,0 +1,494 @@
+/*
+ * rtthread.c
+ *
+ * rt-thread api of the host build on pthreads :
+ *  - mutex is recursive like rt_mutex
+ *  - timers are fired by one timer thread at 1ms ticks, callbacks run in that thread like soft timers
+ *  - threads are detached pthreads, priority and stack size are ignored
+ *  - with the virtual clock of host_clock.h, ticks and timers only advance by host_clock_advance
+ *  - devices are kept in a list, calls go to the driver functions directly
+ */
+
+#define _GNU_SOURCE
+#include <rtthread.h>
+#include <host_clock.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+struct rt_mutex
+{
+    pthread_mutex_t lock;
+};
+
+struct rt_semaphore
+{
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    rt_uint32_t value;
+};
+
+struct rt_thread
+{
+    pthread_t tid;
+    void (*entry)(void *parameter);
+    void *parameter;
+};
+
+static pthread_mutex_t rt_timer_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t rt_timer_cond = PTHREAD_COND_INITIALIZER;
+static pthread_once_t rt_timer_once = PTHREAD_ONCE_INIT;
+static struct rt_timer *rt_timer_list = RT_NULL;
+static pthread_mutex_t rt_critical_lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;//nested like rt_enter_critical
+static int rt_clock_virtual = 0;
+static u64 rt_clock_ticks = 0;//ticks of virtual clock
+
+static struct timespec rt_time_after(rt_int32_t ms)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += ms / 1000;
+    ts.tv_nsec += (long)(ms % 1000) * 1000000;
+    if (ts.tv_nsec >= 1000000000)
+    {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+    }
+    return(ts);
+}
+
+rt_tick_t rt_tick_get(void)
+{
+    struct timespec ts;
+    if (rt_clock_virtual)
+    {
+        return((rt_tick_t)rt_clock_ticks);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return((rt_tick_t)((uint64_t)ts.tv_sec * RT_TICK_PER_SECOND + ts.tv_nsec / (1000000000 / RT_TICK_PER_SECOND)));
+}
+
+rt_tick_t rt_tick_from_millisecond(rt_int32_t ms)
+{
+    return((rt_tick_t)((int64_t)ms * RT_TICK_PER_SECOND / 1000));
+}
+
+rt_uint32_t host_boot_epoch(void)
+{
+    static rt_uint32_t epoch = 0;
+    
+    if (epoch == 0)//one value for the run, like a seed read once at reset
+    {
+        epoch = (rt_uint32_t)time(NULL) ^ ((rt_uint32_t)getpid() << 16);
+    }
+    return(epoch);
+}
+
+rt_mutex_t rt_mutex_create(const char *name, rt_uint8_t flag)
+{
+    pthread_mutexattr_t attr;
+    rt_mutex_t mutex = malloc(sizeof(struct rt_mutex));
+    
+    if (mutex == RT_NULL)
+    {
+        return(RT_NULL);
+    }
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&mutex->lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+    return(mutex);
+}
+
+rt_err_t rt_mutex_delete(rt_mutex_t mutex)
+{
+    pthread_mutex_destroy(&mutex->lock);
+    free(mutex);
+    return(RT_EOK);
+}
+
+rt_err_t rt_mutex_take(rt_mutex_t mutex, rt_int32_t time)
+{
+    int rst;
+    
+    if (time == RT_WAITING_FOREVER)
+    {
+        rst = pthread_mutex_lock(&mutex->lock);
+    }
+    else if (time == RT_WAITING_NO)
+    {
+        rst = pthread_mutex_trylock(&mutex->lock);
+    }
+    else
+    {
+        struct timespec ts = rt_time_after(time * 1000 / RT_TICK_PER_SECOND);
+        rst = pthread_mutex_timedlock(&mutex->lock, &ts);
+    }
+    return((rst == 0) ? RT_EOK : -RT_ETIMEOUT);
+}
+
+rt_err_t rt_mutex_release(rt_mutex_t mutex)
+{
+    pthread_mutex_unlock(&mutex->lock);
+    return(RT_EOK);
+}
+
+rt_sem_t rt_sem_create(const char *name, rt_uint32_t value, rt_uint8_t flag)
+{
+    rt_sem_t sem = malloc(sizeof(struct rt_semaphore));
+    
+    if (sem == RT_NULL)
+    {
+        return(RT_NULL);
+    }
+    pthread_mutex_init(&sem->lock, RT_NULL);
+    pthread_cond_init(&sem->cond, RT_NULL);
+    sem->value = value;
+    return(sem);
+}
+
+rt_err_t rt_sem_delete(rt_sem_t sem)
+{
+    pthread_cond_destroy(&sem->cond);
+    pthread_mutex_destroy(&sem->lock);
+    free(sem);
+    return(RT_EOK);
+}
+
+rt_err_t rt_sem_take(rt_sem_t sem, rt_int32_t time)
+{
+    struct timespec ts = rt_time_after((time > 0) ? (time * 1000 / RT_TICK_PER_SECOND) : 0);
+    rt_err_t rst = RT_EOK;
+    
+    pthread_mutex_lock(&sem->lock);
+    while ((sem->value == 0) && (rst == RT_EOK))
+    {
+        if (time == RT_WAITING_NO)
+        {
+            rst = -RT_ETIMEOUT;
+        }
+        else if (time == RT_WAITING_FOREVER)
+        {
+            pthread_cond_wait(&sem->cond, &sem->lock);
+        }
+        else if (pthread_cond_timedwait(&sem->cond, &sem->lock, &ts) == ETIMEDOUT)
+        {
+            rst = -RT_ETIMEOUT;
+        }
+    }
+    if (rst == RT_EOK)
+    {
+        sem->value--;
+    }
+    pthread_mutex_unlock(&sem->lock);
+    return(rst);
+}
+
+rt_err_t rt_sem_release(rt_sem_t sem)
+{
+    pthread_mutex_lock(&sem->lock);
+    sem->value++;
+    pthread_cond_signal(&sem->cond);
+    pthread_mutex_unlock(&sem->lock);
+    return(RT_EOK);
+}
+
+static void *rt_timer_thread(void *arg)
+{
+    pthread_mutex_lock(&rt_timer_lock);
+    while (1)
+    {
+        struct rt_timer *timer;
+        rt_tick_t now = rt_tick_get();
+        
+        for (timer = rt_timer_list; timer != RT_NULL; timer = timer->next)
+        {
+            if ((timer->parent.flag & RT_TIMER_FLAG_ACTIVATED) && ((rt_int32_t)(now - timer->timeout_tick) >= 0))
+            {
+                break;
+            }
+        }
+        if (timer == RT_NULL)
+        {
+            struct timespec ts = rt_time_after(1000 / RT_TICK_PER_SECOND);
+            pthread_cond_timedwait(&rt_timer_cond, &rt_timer_lock, &ts);
+            continue;
+        }
+        if (timer->parent.flag & RT_TIMER_FLAG_PERIODIC)
+        {
+            timer->timeout_tick = now + timer->init_tick;
+        }
+        else
+        {
+            timer->parent.flag &= ~RT_TIMER_FLAG_ACTIVATED;
+        }
+        pthread_mutex_unlock(&rt_timer_lock);
+        timer->timeout(timer->parameter);
+        pthread_mutex_lock(&rt_timer_lock);
+    }
+    return(RT_NULL);
+}
+
+static void rt_timer_thread_start(void)
+{
+    pthread_t tid;
+    pthread_create(&tid, RT_NULL, rt_timer_thread, RT_NULL);
+    pthread_detach(tid);
+}
+
+rt_timer_t rt_timer_create(const char *name, void (*timeout)(void *parameter), void *parameter, rt_tick_t time, rt_uint8_t flag)
+{
+    rt_timer_t timer = calloc(1, sizeof(struct rt_timer));
+    
+    if (timer == RT_NULL)
+    {
+        return(RT_NULL);
+    }
+    if ( ! rt_clock_virtual)
+    {
+        pthread_once(&rt_timer_once, rt_timer_thread_start);
+    }
+    timer->timeout = timeout;
+    timer->parameter = parameter;
+    timer->init_tick = time;
+    timer->parent.flag = flag & ~RT_TIMER_FLAG_ACTIVATED;
+    pthread_mutex_lock(&rt_timer_lock);
+    timer->next = rt_timer_list;
+    rt_timer_list = timer;
+    pthread_mutex_unlock(&rt_timer_lock);
+    return(timer);
+}
+
+rt_err_t rt_timer_delete(rt_timer_t timer)
+{
+    struct rt_timer **pnext;
+    
+    pthread_mutex_lock(&rt_timer_lock);
+    for (pnext = &rt_timer_list; *pnext != RT_NULL; pnext = &(*pnext)->next)
+    {
+        if (*pnext == timer)
+        {
+            *pnext = timer->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&rt_timer_lock);
+    free(timer);
+    return(RT_EOK);
+}
+
+rt_err_t rt_timer_start(rt_timer_t timer)
+{
+    pthread_mutex_lock(&rt_timer_lock);
+    timer->timeout_tick = rt_tick_get() + timer->init_tick;
+    timer->parent.flag |= RT_TIMER_FLAG_ACTIVATED;
+    pthread_cond_signal(&rt_timer_cond);
+    pthread_mutex_unlock(&rt_timer_lock);
+    return(RT_EOK);
+}
+
+rt_err_t rt_timer_stop(rt_timer_t timer)
+{
+    pthread_mutex_lock(&rt_timer_lock);
+    timer->parent.flag &= ~RT_TIMER_FLAG_ACTIVATED;
+    pthread_mutex_unlock(&rt_timer_lock);
+    return(RT_EOK);
+}
+
+rt_err_t rt_timer_control(rt_timer_t timer, int cmd, void *arg)
+{
+    if (cmd != RT_TIMER_CTRL_GET_STATE)//only the state is needed by the component
+    {
+        return(-RT_ERROR);
+    }
+    
+    pthread_mutex_lock(&rt_timer_lock);
+    *(rt_uint32_t *)arg = (timer->parent.flag & RT_TIMER_FLAG_ACTIVATED) ? RT_TIMER_FLAG_ACTIVATED : RT_TIMER_FLAG_DEACTIVATED;
+    pthread_mutex_unlock(&rt_timer_lock);
+    return(RT_EOK);
+}
+
+void host_clock_virtual(void)
+{
+    rt_clock_virtual = 1;
+}
+
+u64 host_clock_now(void)
+{
+    return(rt_clock_ticks);
+}
+
+void host_clock_advance(u64 ticks)
+{
+    u64 end = rt_clock_ticks + ticks;
+    
+    pthread_mutex_lock(&rt_timer_lock);
+    while (1)
+    {
+        struct rt_timer *timer, *first = RT_NULL;
+        u64 due = end;
+        
+        for (timer = rt_timer_list; timer != RT_NULL; timer = timer->next)//earliest timer due before the end
+        {
+            u64 tick;
+            if ((timer->parent.flag & RT_TIMER_FLAG_ACTIVATED) == 0)
+            {
+                continue;
+            }
+            tick = rt_clock_ticks + (u64)(rt_int32_t)(timer->timeout_tick - (rt_tick_t)rt_clock_ticks);
+            if ((tick <= due) && ((first == RT_NULL) || (tick < due)))
+            {
+                first = timer;
+                due = tick;
+            }
+        }
+        if (due > rt_clock_ticks)
+        {
+            rt_clock_ticks = due;
+        }
+        if (first == RT_NULL)
+        {
+            break;
+        }
+        if (first->parent.flag & RT_TIMER_FLAG_PERIODIC)
+        {
+            first->timeout_tick = (rt_tick_t)rt_clock_ticks + first->init_tick;
+        }
+        else
+        {
+            first->parent.flag &= ~RT_TIMER_FLAG_ACTIVATED;
+        }
+        pthread_mutex_unlock(&rt_timer_lock);
+        first->timeout(first->parameter);
+        pthread_mutex_lock(&rt_timer_lock);
+    }
+    pthread_mutex_unlock(&rt_timer_lock);
+}
+
+static void *rt_thread_entry(void *arg)
+{
+    rt_thread_t thread = arg;
+    thread->entry(thread->parameter);
+    free(thread);
+    return(RT_NULL);
+}
+
+rt_thread_t rt_thread_create(const char *name, void (*entry)(void *parameter), void *parameter,
+                             rt_uint32_t stack_size, rt_uint8_t priority, rt_uint32_t tick)
+{
+    rt_thread_t thread = calloc(1, sizeof(struct rt_thread));
+    
+    if (thread == RT_NULL)
+    {
+        return(RT_NULL);
+    }
+    thread->entry = entry;
+    thread->parameter = parameter;
+    return(thread);
+}
+
+rt_err_t rt_thread_startup(rt_thread_t thread)
+{
+    if (pthread_create(&thread->tid, RT_NULL, rt_thread_entry, thread) != 0)
+    {
+        return(-RT_ERROR);
+    }
+    pthread_detach(thread->tid);
+    return(RT_EOK);
+}
+
+rt_err_t rt_thread_delay(rt_tick_t tick)
+{
+    struct timespec ts;
+    ts.tv_sec = tick / RT_TICK_PER_SECOND;
+    ts.tv_nsec = (long)(tick % RT_TICK_PER_SECOND) * (1000000000 / RT_TICK_PER_SECOND);
+    while ((nanosleep(&ts, &ts) != 0) && (errno == EINTR));
+    return(RT_EOK);
+}
+
+rt_err_t rt_thread_mdelay(rt_int32_t ms)
+{
+    return(rt_thread_delay(rt_tick_from_millisecond(ms)));
+}
+
+rt_err_t rt_thread_yield(void)
+{
+    sched_yield();
+    return(RT_EOK);
+}
+
+static rt_device_t rt_device_list = RT_NULL;
+
+rt_err_t rt_device_register(rt_device_t dev, const char *name, rt_uint16_t flags)
+{
+    if (rt_device_find(name) != RT_NULL)
+    {
+        return(-RT_ERROR);
+    }
+    snprintf(dev->parent.name, sizeof(dev->parent.name), "%s", name);
+    dev->parent.flag = (rt_uint8_t)flags;
+    dev->next = rt_device_list;
+    rt_device_list = dev;
+    return(RT_EOK);
+}
+
+rt_err_t rt_device_unregister(rt_device_t dev)
+{
+    rt_device_t *pp = &rt_device_list;
+    
+    while (*pp != RT_NULL)
+    {
+        if (*pp == dev)
+        {
+            *pp = dev->next;
+            return(RT_EOK);
+        }
+        pp = &(*pp)->next;
+    }
+    return(-RT_ERROR);
+}
+
+rt_device_t rt_device_find(const char *name)
+{
+    for (rt_device_t dev = rt_device_list; dev != RT_NULL; dev = dev->next)
+    {
+        if (strncmp(dev->parent.name, name, RT_NAME_MAX) == 0)
+        {
+            return(dev);
+        }
+    }
+    return(RT_NULL);
+}
+
+rt_err_t rt_device_open(rt_device_t dev, rt_uint16_t oflag)
+{
+    return((dev->open != RT_NULL) ? dev->open(dev, oflag) : RT_EOK);
+}
+
+rt_err_t rt_device_close(rt_device_t dev)
+{
+    return((dev->close != RT_NULL) ? dev->close(dev) : RT_EOK);
+}
+
+rt_size_t rt_device_read(rt_device_t dev, rt_off_t pos, void *buffer, rt_size_t size)
+{
+    return((dev->read != RT_NULL) ? dev->read(dev, pos, buffer, size) : 0);
+}
+
+rt_size_t rt_device_write(rt_device_t dev, rt_off_t pos, const void *buffer, rt_size_t size)
+{
+    return((dev->write != RT_NULL) ? dev->write(dev, pos, buffer, size) : 0);
+}
+
+void rt_enter_critical(void)
+{
+    pthread_mutex_lock(&rt_critical_lock);
+}
+
+void rt_exit_critical(void)
+{
+    pthread_mutex_unlock(&rt_critical_lock);
+}
@@ -0,0 +1,185 @@
+/*
+ * rtthread.h
+ *
+ * the part of rt-thread api used by qparam, implemented on pthreads by rtthread.c for the host build
+ */
+
+#ifndef __RT_THREAD_H__
+#define __RT_THREAD_H__
+
+#include <rtconfig.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef int                     rt_err_t;
+typedef uint8_t                 rt_uint8_t;
+typedef uint32_t                rt_uint32_t;
+typedef int32_t                 rt_int32_t;
+typedef uint32_t                rt_tick_t;
+typedef size_t                  rt_size_t;
+typedef uintptr_t               rt_ubase_t;
+typedef uint16_t                rt_uint16_t;
+typedef long                    rt_off_t;
+
+#define RT_NULL                 0
+#define RT_EOK                  0
+#define RT_ERROR                1
+#define RT_ETIMEOUT             2
+#define RT_EFULL                3
+#define RT_EEMPTY               4
+#define RT_ENOMEM               5
+#define RT_ENOSYS               6
+#define RT_EBUSY                7
+#define RT_EIO                  8
+#define RT_EINTR                9
+#define RT_EINVAL               10
+
+#define RT_WAITING_FOREVER      -1
+#define RT_WAITING_NO           0
+
+#define RT_IPC_FLAG_FIFO        0x00
+#define RT_IPC_FLAG_PRIO        0x01
+
+#define RT_DEVICE_OFLAG_RDWR        0x003
+
+#define RT_TIMER_FLAG_DEACTIVATED   0x0
+#define RT_TIMER_FLAG_ACTIVATED     0x1
+#define RT_TIMER_FLAG_ONE_SHOT      0x0
+#define RT_TIMER_FLAG_PERIODIC      0x2
+#define RT_TIMER_FLAG_HARD_TIMER    0x0
+#define RT_TIMER_FLAG_SOFT_TIMER    0x4
+
+#define RT_TIMER_CTRL_GET_STATE     0x4
+
+#define RT_ALIGN(size, align)       (((size) + (align) - 1) & ~((align) - 1))
+#define RT_ALIGN_DOWN(size, align)  ((size) & ~((align) - 1))
+
+struct rt_object
+{
+    char name[RT_NAME_MAX];
+    rt_uint8_t type;
+    rt_uint8_t flag;
+};
+
+struct rt_timer
+{
+    struct rt_object parent;
+    struct rt_timer *next;          //list of the timer thread
+    void (*timeout)(void *parameter);
+    void *parameter;
+    rt_tick_t init_tick;
+    rt_tick_t timeout_tick;
+};
+typedef struct rt_timer *rt_timer_t;
+
+typedef struct rt_mutex *rt_mutex_t;
+typedef struct rt_semaphore *rt_sem_t;
+typedef struct rt_thread *rt_thread_t;
+
+//device with byte address like eeprom, drivers fill read and write, open and close are optional
+struct rt_device
+{
+    struct rt_object parent;
+    struct rt_device *next;         //list of registered devices
+    rt_err_t (*open)(struct rt_device *dev, rt_uint16_t oflag);
+    rt_err_t (*close)(struct rt_device *dev);
+    rt_size_t (*read)(struct rt_device *dev, rt_off_t pos, void *buffer, rt_size_t size);
+    rt_size_t (*write)(struct rt_device *dev, rt_off_t pos, const void *buffer, rt_size_t size);
+    void *user_data;
+};
+typedef struct rt_device *rt_device_t;
+
+rt_mutex_t rt_mutex_create(const char *name, rt_uint8_t flag);
+rt_err_t rt_mutex_delete(rt_mutex_t mutex);
+rt_err_t rt_mutex_take(rt_mutex_t mutex, rt_int32_t time);
+rt_err_t rt_mutex_release(rt_mutex_t mutex);
+
+rt_sem_t rt_sem_create(const char *name, rt_uint32_t value, rt_uint8_t flag);
+rt_err_t rt_sem_delete(rt_sem_t sem);
+rt_err_t rt_sem_take(rt_sem_t sem, rt_int32_t time);
+rt_err_t rt_sem_release(rt_sem_t sem);
+
+rt_timer_t rt_timer_create(const char *name, void (*timeout)(void *parameter), void *parameter, rt_tick_t time, rt_uint8_t flag);
+rt_err_t rt_timer_delete(rt_timer_t timer);
+rt_err_t rt_timer_start(rt_timer_t timer);
+rt_err_t rt_timer_stop(rt_timer_t timer);
+rt_err_t rt_timer_control(rt_timer_t timer, int cmd, void *arg);
+
+rt_thread_t rt_thread_create(const char *name, void (*entry)(void *parameter), void *parameter,
+                             rt_uint32_t stack_size, rt_uint8_t priority, rt_uint32_t tick);
+rt_err_t rt_thread_startup(rt_thread_t thread);
+rt_err_t rt_thread_delay(rt_tick_t tick);
+rt_err_t rt_thread_mdelay(rt_int32_t ms);
+rt_err_t rt_thread_yield(void);
+
+rt_tick_t rt_tick_get(void);
+rt_tick_t rt_tick_from_millisecond(rt_int32_t ms);
+rt_uint32_t host_boot_epoch(void);         //seed of PARAM_BOOT_EPOCH, time and process id of the run
+
+rt_err_t rt_device_register(rt_device_t dev, const char *name, rt_uint16_t flags);
+rt_err_t rt_device_unregister(rt_device_t dev);
+rt_device_t rt_device_find(const char *name);
+rt_err_t rt_device_open(rt_device_t dev, rt_uint16_t oflag);
+rt_err_t rt_device_close(rt_device_t dev);
+rt_size_t rt_device_read(rt_device_t dev, rt_off_t pos, void *buffer, rt_size_t size);
+rt_size_t rt_device_write(rt_device_t dev, rt_off_t pos, const void *buffer, rt_size_t size);
+
+void rt_enter_critical(void);
+void rt_exit_critical(void);
+
+#define rt_kprintf              printf
+#define rt_malloc               malloc
+#define rt_calloc               calloc
+#define rt_realloc              realloc
+#define rt_free                 free
+
+//commands and automatic initialization are not registered on host, tools call the functions directly
+#define MSH_CMD_EXPORT(cmd, desc)
+#define MSH_CMD_EXPORT_ALIAS(cmd, alias, desc)  int alias##_cmd_entry(int argc, char **argv) { cmd(argc, argv); return(0); }
+#define INIT_ENV_EXPORT(fn)
+#define INIT_APP_EXPORT(fn)
+
+struct rt_slist_node
+{
+    struct rt_slist_node *next;
+};
+typedef struct rt_slist_node rt_slist_t;
+
+#define RT_SLIST_OBJECT_INIT(object)        { RT_NULL }
+#define rt_container_of(ptr, type, member)  ((type *)((char *)(ptr) - (unsigned long)(&((type *)0)->member)))
+#define rt_slist_entry(node, type, member)  rt_container_of(node, type, member)
+#define rt_slist_for_each(pos, head)        for (pos = (head)->next; pos != RT_NULL; pos = pos->next)
+
+static inline void rt_slist_init(rt_slist_t *l)
+{
+    l->next = RT_NULL;
+}
+
+static inline void rt_slist_append(rt_slist_t *l, rt_slist_t *n)
+{
+    struct rt_slist_node *node = l;
+    while (node->next)
+    {
+        node = node->next;
+    }
+    node->next = n;
+    n->next = RT_NULL;
+}
+
+static inline rt_slist_t *rt_slist_remove(rt_slist_t *l, rt_slist_t *n)
+{
+    struct rt_slist_node *node = l;
+    while (node->next && (node->next != n))
+    {
+        node = node->next;
+    }
+    if (node->next != RT_NULL)
+    {
+        node->next = node->next->next;
+    }
+    return(l);
+}
+
+#endif
@@ -11,13 +11,74 @@
 
 #include <typedef.h>
 #include <rtconfig.h>
+#include <rtthread.h>
 #include <param_index.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 //#define PKG_USING_QPARAM
 //#define PARAM_USING_INDEX       //using index fast read/write param
 //#define PARAM_USING_CLI         //using command line list/read/write... param
 //#define PARAM_USING_AUTO_INIT   //using automatic initialize and load from flash
 //#define PARAM_USING_AUTO_SAVE   //using automatic save into flash
+//#define PARAM_USING_OVERLAY     //using default layer and user overlay, only non-default params are saved
+//#define PARAM_USING_COMPRESS    //using run length compression for the image saved in flash
+//#define PARAM_USING_JOURNAL     //using journal sectors for counter params, updates never erase the image
+//#define PARAM_USING_DYNAMIC     //using dynamic key/value params created at run time
+//#define PARAM_USING_COMPACT     //using compact table, definitions and offsets are built at compile time, datas are allocated statically
+//#define PARAM_USING_INDEX_ONLY  //using index access only, names are not stored in compact table, need PARAM_USING_INDEX, not with PARAM_USING_CLI
+//#define PARAM_USING_XIP         //using params read from memory mapped flash, only modified params have RAM shadows
+//#define PARAM_USING_MIGRATE     //using name directory in saved image, params are migrated by name when the table layout changes
+//#define PARAM_USING_EXPORT      //using binary export/import of all params, for provisioning and backup
+//#define PARAM_USING_TEXT_IMPORT //using streaming import of name=value text, applied as one batch, not with PARAM_USING_INDEX_ONLY
+//#define PARAM_USING_STATS       //using run time statistics of calls, lock waits, saves, loads and flash wear
+//#define PARAM_USING_PROFILE     //using read and write counters of each param, to find hot params and suggest a layout
+//#define PARAM_USING_PACED_WRITE //using paced flash writes, the writing thread yields when a budget of flash time is used up
+//#define PARAM_USING_PRE_ERASE   //using 3 rotating image slots, the next slot is erased in background so saves only program
+//#define PARAM_USING_BACKEND     //using storage backend of each table, fal, RAM, file or EEPROM, instead of fal only
+//#define PARAM_USING_DUAL        //using backup copy on a second partition or device, both copies are written in parallel
+//#define PARAM_USING_PRESET      //using named presets stored beside the image, switching the live image writes a small selector record
+//#define PARAM_USING_DELTA       //using change generation of each param, params changed since a generation are exported as records
+
+#ifdef PARAM_USING_INDEX_ONLY
+#if !defined(PARAM_USING_COMPACT) || !defined(PARAM_USING_INDEX) || defined(PARAM_USING_CLI)
+#error "PARAM_USING_INDEX_ONLY needs PARAM_USING_COMPACT and PARAM_USING_INDEX, and can not be used with PARAM_USING_CLI"
+#endif
+#endif
+
+#ifdef PARAM_USING_XIP
+#if defined(PARAM_USING_OVERLAY) || defined(PARAM_USING_COMPRESS) || defined(PARAM_USING_COMPACT)
+#error "PARAM_USING_XIP maps a raw image, it can not be used with PARAM_USING_OVERLAY, PARAM_USING_COMPRESS or PARAM_USING_COMPACT"
+#endif
+#endif
+
+#if defined(PARAM_USING_TEXT_IMPORT) && defined(PARAM_USING_INDEX_ONLY)
+#error "PARAM_USING_TEXT_IMPORT finds params by name, it can not be used with PARAM_USING_INDEX_ONLY"
+#endif
+
+#if defined(PARAM_USING_PRE_ERASE) && defined(PARAM_USING_XIP)
+#error "PARAM_USING_PRE_ERASE rotates image slots, it can not be used with PARAM_USING_XIP"
+#endif
+
+#if defined(PARAM_USING_DUAL) && (defined(PARAM_USING_XIP) || defined(PARAM_USING_PRE_ERASE))
+#error "PARAM_USING_DUAL keeps one copy on each storage, it can not be used with PARAM_USING_XIP or PARAM_USING_PRE_ERASE"
+#endif
+
+#ifdef PARAM_USING_MIGRATE
+#if defined(PARAM_USING_XIP) || defined(PARAM_USING_INDEX_ONLY)
+#error "PARAM_USING_MIGRATE matches params by name, it can not be used with PARAM_USING_XIP or PARAM_USING_INDEX_ONLY"
+#endif
+#endif
+
+#if defined(PARAM_USING_DELTA) && !defined(PARAM_USING_EXPORT)
+#error "PARAM_USING_DELTA exports records of PARAM_USING_EXPORT, it needs PARAM_USING_EXPORT"
+#endif
+
+#if defined(PARAM_USING_DELTA) && !defined(PARAM_BOOT_EPOCH)
+#error "PARAM_USING_DELTA needs PARAM_BOOT_EPOCH() of the port, a value that differs in each boot, ticks since reset repeat in each boot"
+#endif
 
 #ifndef PARAM_AUTO_SAVE_DELAY
 #define PARAM_AUTO_SAVE_DELAY   2000
@@ -35,11 +96,428 @@
 #define PARAM_SAVE_ADDR         0       //save address for parameters 
 #endif
 
+#ifndef PARAM_PART_NAME_BAK
+#define PARAM_PART_NAME_BAK     "param_bak"//partition name for backup parameters, with PARAM_USING_DUAL
+#endif
+
 #ifndef PARAM_SAVE_ADDR_BAK
+#ifdef PARAM_USING_DUAL
+#define PARAM_SAVE_ADDR_BAK     PARAM_SAVE_ADDR//save address for backup parameters, in backup partition
+#else
 #define PARAM_SAVE_ADDR_BAK     (PARAM_SAVE_ADDR + PARAM_SECTOR_SIZE)//save address for backup parameters 
 #endif
+#endif
+
+#ifndef PARAM_SPARE_ADDR
+#define PARAM_SPARE_ADDR        (PARAM_SAVE_ADDR_BAK + PARAM_SECTOR_SIZE)//address of the third image slot, with PARAM_USING_PRE_ERASE
+#endif
+
+#ifndef PARAM_JOURNAL_ADDR
+#ifdef PARAM_USING_PRE_ERASE
+#define PARAM_JOURNAL_ADDR      (PARAM_SPARE_ADDR + PARAM_SECTOR_SIZE)//save address for journal sectors
+#elif defined(PARAM_USING_DUAL)
+#define PARAM_JOURNAL_ADDR      (PARAM_SAVE_ADDR + PARAM_SECTOR_SIZE * 2)//save address for journal sectors
+#else
+#define PARAM_JOURNAL_ADDR      (PARAM_SAVE_ADDR_BAK + PARAM_SECTOR_SIZE)//save address for journal sectors
+#endif
+#endif
+
+#ifndef PARAM_JOURNAL_SECTORS
+#define PARAM_JOURNAL_SECTORS   2       //sectors used by journal, at least 2
+#endif
+
+#ifndef PARAM_DYN_ADDR
+#define PARAM_DYN_ADDR          (PARAM_JOURNAL_ADDR + PARAM_JOURNAL_SECTORS * PARAM_SECTOR_SIZE)//save address for dynamic params
+#endif
+
+#ifndef PARAM_DYN_SECTORS
+#define PARAM_DYN_SECTORS       1       //sectors used by dynamic params, the arena size is a little smaller
+#endif
+
+#ifndef PARAM_DYN_ADDR_BAK
+#define PARAM_DYN_ADDR_BAK      (PARAM_DYN_ADDR + PARAM_DYN_SECTORS * PARAM_SECTOR_SIZE)//save address for backup dynamic params
+#endif
+
+#ifndef PARAM_PRESET_ADDR
+#define PARAM_PRESET_ADDR       (PARAM_DYN_ADDR_BAK + PARAM_DYN_SECTORS * PARAM_SECTOR_SIZE)//save address for 2 selector sectors, then one sector of each preset
+#endif
+
+#ifndef PARAM_PRESET_NAMES
+#define PARAM_PRESET_NAMES      "normal", "commission", "low_power"//names of presets, with PARAM_USING_PRESET
+#endif
+
+#ifndef PARAM_DYN_SLOTS
+#define PARAM_DYN_SLOTS         128     //slots of dynamic params hash index, must be power of 2 up to 32768, 3/4 of it can be used, 96 params by default
+#endif
+
+#ifndef PARAM_DYN_KEY_MAX
+#define PARAM_DYN_KEY_MAX       32      //max length of dynamic param name
+#endif
+
+#ifndef PARAM_XIP_SHADOW_SIZE
+#define PARAM_XIP_SHADOW_SIZE   256     //bytes of shadow pool, params modified since saved are kept in it
+#endif
+
+#ifndef PARAM_TEXT_LINE_MAX
+#define PARAM_TEXT_LINE_MAX     128     //max length of one line of text import, longer line is reported as error
+#endif
+
+#ifndef PARAM_STATS_SECTORS
+#define PARAM_STATS_SECTORS     16      //sectors of each table whose erase counts are kept by statistics
+#endif
+
+#ifndef PARAM_STATS_TIME_US
+#define PARAM_STATS_TIME_US()   ((u32)rt_tick_get() * (1000000 / RT_TICK_PER_SECOND))//time source of statistics and paced writes, a cycle counter may be used
+#endif
+
+#ifndef PARAM_PROG_STEP
+#define PARAM_PROG_STEP         64      //bytes of one program operation, a power of 2 not more than flash page, steps never cross a page
+#endif
+
+#if (PARAM_PROG_STEP & (PARAM_PROG_STEP - 1)) != 0
+#error "PARAM_PROG_STEP must be a power of 2"
+#endif
+
+#ifndef PARAM_WRITE_BUDGET_US
+#define PARAM_WRITE_BUDGET_US   2000    //flash time of paced writes between two yields, erase of one sector may exceed it
+#endif
+
+//#define PARAM_BOOT_EPOCH()    rand()  //seed of the run epoch of PARAM_USING_DELTA, given by the port, must differ in each boot : a random number, RTC time or a boot counter in storage
+
+#ifndef PARAM_WRITE_YIELD
+#define PARAM_WRITE_YIELD()     rt_thread_delay(1)//yield of paced writes, lower priority threads may run too
+#endif
+
+#ifndef PARAM_ERASE_THREAD_PRIORITY
+#define PARAM_ERASE_THREAD_PRIORITY (RT_THREAD_PRIORITY_MAX - 2)//priority of background erase thread, 0 - no thread, call param_tbl_pre_erase in idle time
+#endif
+
+#ifndef PARAM_ERASE_THREAD_STACK
+#define PARAM_ERASE_THREAD_STACK    1024    //stack size of background erase thread
+#endif
+
+#ifndef PARAM_DUAL_THREAD_PRIORITY
+#define PARAM_DUAL_THREAD_PRIORITY  (RT_THREAD_PRIORITY_MAX / 2)//priority of backup copy writing thread, 0 - no thread, copies are written one by one
+#endif
+
+#ifndef PARAM_DUAL_THREAD_STACK
+#define PARAM_DUAL_THREAD_STACK     2048    //stack size of backup copy writing thread
+#endif
+
+#ifndef PARAM_PROF_TOP
+#define PARAM_PROF_TOP          10      //params listed by param hot by default
+#endif
+
+#ifndef PARAM_BACKEND
+#define PARAM_BACKEND           (&param_backend_fal)//storage backend of tables, with PARAM_USING_BACKEND
+#endif
+
+#ifndef PARAM_RAM_SIZE
+#define PARAM_RAM_SIZE          (16 * 1024)//bytes of RAM backend storage, shared by all tables using it
+#endif
+
+#ifndef PARAM_EEPROM_PAGE_SIZE
+#define PARAM_EEPROM_PAGE_SIZE  32      //bytes of EEPROM write page, one write never crosses a page
+#endif
+
+#ifndef PARAM_CLI_LINE_MAX
+#define PARAM_CLI_LINE_MAX      128     //bytes of command line output buffer, one row is printed at once, longer row in pieces
+#endif
 
 #define PARAM_MAGIC_WORD        0xCC33
+#define PARAM_MAGIC_EXT         0xCC3C  //image with extended head, supports sparse or compressed data
+#define PARAM_MAGIC_JOURNAL     0xCC5A  //journal sector
+#define PARAM_MAGIC_DYN         0xCC6D  //dynamic params
+#define PARAM_MAGIC_SLOT        0xCC6A  //tag of image slot, at the end of the sector
+#define PARAM_MAGIC_PRESET      0xCC7A  //record of preset selector
+#define PARAM_MAGIC_EXPORT      0xCCE0  //exported params
+
+#define PARAM_EXPORT_VERSION    1       //version of export format
+#define PARAM_EXPORT_SPARSE     0x01    //flag of export, only params differ from default are exported
+#define PARAM_EXPORT_DELTA      0x02    //flag of export, records of params changed since a generation, data begins with epoch and current generation
+
+typedef enum{
+    PTYPE_STR = 0,      //0-string
+    PTYPE_ARRAY,        //1-unsigned char array
+    PTYPE_INT,          //2-32/64 bits signed int
+    PTYPE_HEX,          //3-32/64 bits unsigned int
+    PTYPE_FLOAT         //4-float/double
+}param_type_t;
+
+typedef enum{
+    PSTORE_IMAGE = 0,   //0-saved in parameter image, saves are coalesced
+    PSTORE_JOURNAL,     //1-saved in journal sectors at once
+    PSTORE_NONE         //2-only lives in RAM, never saved
+}param_store_t;
+
+typedef struct
+{
+    #ifdef PARAM_USING_COMPACT
+    #ifndef PARAM_USING_INDEX_ONLY
+    u16 name;           //offset of name in string pool
+    #endif
+    u16 defval;         //offset of default value in string pool
+    #else
+    char *name;
+    char *defval;
+    #endif
+    u8  type;
+    u8  size;
+    u8  store;
+}param_msg_t;
+
+#ifdef PARAM_USING_STATS
+#define PARAM_STATS_HIST        8       //buckets of latency histogram, bucket n counts less than 2^n ms, the last counts the rest
+
+typedef enum{
+    PSTAT_READ_INDEX = 0,   //0-param_tbl_read_by_index, reads by name are counted too
+    PSTAT_READ_NAME,        //1-param_tbl_read_by_name
+    PSTAT_WRITE_INDEX,      //2-param_tbl_write_by_index, writes by name are counted too
+    PSTAT_WRITE_NAME,       //3-param_tbl_write_by_name
+    PSTAT_RESUME,           //4-param_tbl_resume_xxx
+    PSTAT_NOTIFY,           //5-param_tbl_notify
+    PSTAT_API_TOTAL
+}param_stat_api_t;
+
+typedef enum{
+    PSTAT_RGN_IMAGE = 0,    //0-parameter image
+    PSTAT_RGN_BACKUP,       //1-backup parameter image
+    PSTAT_RGN_JOURNAL,      //2-journal sectors
+    PSTAT_RGN_DYNAMIC,      //3-dynamic params and their backup
+    PSTAT_RGN_SPARE,        //4-third image slot of PARAM_USING_PRE_ERASE
+    PSTAT_RGN_PRESET,       //5-selector and images of PARAM_USING_PRESET
+    PSTAT_RGN_TOTAL
+}param_stat_rgn_t;
+
+//statistics of a table, counters are not atomic, calls of other threads may rarely be lost
+typedef struct
+{
+    u32 calls[PSTAT_API_TOTAL];         //calls of each api
+    u32 locks;                          //mutex takes
+    u32 lock_waits;                     //takes waited for other thread
+    u32 lock_wait_us;                   //total time waited
+    u32 lock_wait_max_us;               //longest wait
+    u32 save_requests;                  //automatic saves requested by writes
+    u32 save_coalesced;                 //requests covered by a pending automatic save
+    u32 saves;                          //saves done
+    u32 save_fails;                     //saves failed
+    u32 save_max_us;                    //longest save
+    u32 save_hist[PARAM_STATS_HIST];    //save latency histogram
+    u32 loads;                          //loads done
+    u32 load_fails;                     //loads failed
+    u32 load_max_us;                    //longest load
+    u32 load_hist[PARAM_STATS_HIST];    //load latency histogram
+    u32 backup_loads;                   //loads fall back to backup image
+    u32 crc_fails;                      //images or records with broken crc, blank flash is not counted
+    u32 write_yields;                   //yields of paced writes
+    u32 write_step_max_us;              //longest flash time between two yields of paced writes
+    u32 erase_bytes[PSTAT_RGN_TOTAL];   //bytes erased in each region
+    u32 prog_bytes[PSTAT_RGN_TOTAL];    //bytes programmed in each region
+    struct
+    {
+        u32 addr;                       //sector address in partition
+        u32 erases;                     //erase count
+    }sectors[PARAM_STATS_SECTORS];      //erase count of each sector, in order of first erase
+}param_stats_t;
+#endif
+
+#ifdef PARAM_USING_PROFILE
+//access counters of a param, counted without lock, increments of other threads may rarely be lost
+typedef struct
+{
+    u32 reads;                          //reads by index or name
+    u32 writes;                         //writes by index or name
+}param_prof_t;
+#endif
+
+#ifdef PARAM_USING_DELTA
+//change generation of a param, params are linked from the latest changed one
+typedef struct
+{
+    u32 gen;                            //generation of the last change
+    u16 prev;                           //param changed later, PARAM_GEN_NONE - the latest
+    u16 next;                           //param changed earlier, PARAM_GEN_NONE - the earliest
+}param_gen_t;
+#endif
+
+#ifdef PARAM_USING_MIGRATE
+//saved param mapped to current table, only while loading an image of other layout
+typedef struct
+{
+    u16 idx;                            //index in current table, PARAM_MIG_NONE - param is removed
+    u8  type;                           //type in saved image
+    u8  size;                           //size in saved image
+}param_mig_t;
+#endif
+
+#ifdef PARAM_USING_BACKEND
+//storage backend, addresses are offsets in the storage opened by name, like fal partition
+typedef struct
+{
+    const char *name;                   //backend name
+    u32 erase_size;                     //bytes of erase unit, 0 - no erase, erasing only fills 0xFF
+    u32 write_size;                     //bytes of write page, one write never crosses a page, 1 - no limit
+    u8 in_place;                        //1 - bytes can be written again without erase, images are updated in place
+    void *(*open)(const char *name);    //return storage handle, NULL - fail
+    void (*close)(void *dev);
+    int (*read)(void *dev, u32 addr, u8 *buf, u32 size);       //return bytes read, <0 - error
+    int (*write)(void *dev, u32 addr, const u8 *buf, u32 size);//return bytes written, <0 - error
+    int (*erase)(void *dev, u32 addr, u32 size);               //return bytes erased, <0 - error
+    const u8 *(*map)(void *dev, u32 addr);                     //memory mapped address for PARAM_USING_XIP, NULL - not mapped
+}param_backend_t;
+
+extern const param_backend_t param_backend_fal;     //fal partition, sector erase
+extern const param_backend_t param_backend_ram;     //RAM buffer, for tests and volatile tables, name is ignored
+extern const param_backend_t param_backend_file;    //file of POSIX or DFS, name is path, needs RT_USING_DFS
+extern const param_backend_t param_backend_eeprom;  //rt_device of EEPROM or FRAM, name is device name, no erase
+#endif
+
+typedef struct
+{
+    #ifdef PARAM_USING_BACKEND
+    const param_backend_t *backend;     //storage backend
+    #endif
+    const char *part_name;      //flash partition name, or storage name of backend
+    const char *part_name_bak;  //partition name for backup parameters, with PARAM_USING_DUAL
+    u32 save_addr;              //save address for parameters
+    u32 save_addr_bak;          //save address for backup parameters
+    u32 spare_addr;             //address of the third image slot, with PARAM_USING_PRE_ERASE
+    u32 journal_addr;           //save address for journal sectors
+    u16 journal_sectors;        //sectors used by journal
+    u32 auto_save_delay;        //automatic save delay, 0 - the table is never saved automatically
+    u32 dyn_addr;               //save address for dynamic params
+    u32 dyn_addr_bak;           //save address for backup dynamic params
+    u16 dyn_sectors;            //sectors used by dynamic params
+    u16 dyn_slots;              //slots of dynamic params hash index
+    u32 preset_addr;            //save address for preset selector and images
+    #ifdef PARAM_USING_PRESET
+    const char *const *presets; //names of presets
+    u8 preset_total;            //presets total
+    #endif
+}param_tbl_cfg_t;
+
+struct fal_partition;
+
+/* parameter table, defined by including param_table.h, see readme.md */
+typedef struct
+{
+    const char *name;                   //table name
+    const param_msg_t *msgs;            //parameter definitions
+    u16 total;                          //parameter total
+    const u16 *offsets;                 //data offset of each parameter
+    #ifdef PARAM_USING_COMPACT
+    const char *pool;                   //string pool of names and default values
+    #endif
+    param_tbl_cfg_t cfg;                //storage configuration
+    
+    //run time state, managed by parameter module
+    rt_slist_t list;                    //node of registered tables
+    #ifdef PARAM_USING_BACKEND
+    void *dev;                          //storage opened by backend
+    #ifdef PARAM_USING_DUAL
+    void *dev_bak;                      //storage of backup copy
+    #endif
+    #else
+    const struct fal_partition *part;
+    #ifdef PARAM_USING_DUAL
+    const struct fal_partition *part_bak;//partition of backup copy
+    #endif
+    #endif
+    rt_mutex_t mutex;
+    u8 *datas;
+    u16 size;
+    u8 comp;                            //compression type of saved image
+    #ifdef PARAM_USING_AUTO_SAVE
+    rt_timer_t auto_save_timer;
+    #endif
+    #ifdef PARAM_USING_OVERLAY
+    u8 *defaults;                       //default layer, parsed once when initialize
+    u8 *overlay_map;                    //bit set - parameter differs from its default
+    #endif
+    #ifdef PARAM_USING_JOURNAL
+    int jnl_sector;                     //sector in use, -1 - journal is empty
+    u32 jnl_seq;                        //newest sequence in journal, the next snapshot has one more
+    u32 jnl_pos;                        //offset of the next record in sector
+    u16 jnl_total;                      //params saved in journal, 0 - the journal is never written
+    #endif
+    #ifdef PARAM_USING_DYNAMIC
+    u8 *dyn_arena;                      //records of dynamic params
+    u16 *dyn_index;                     //hash index, slot value is record position in arena
+    u32 dyn_size;                       //arena size
+    u32 dyn_used;                       //bytes used in arena, include deleted records
+    u32 dyn_garbage;                    //bytes of deleted records
+    u16 dyn_count;                      //dynamic params total
+    u16 dyn_tombs;                      //deleted slots in hash index
+    u8 dyn_dirty;                       //dynamic params changed since saved
+    #endif
+    #ifdef PARAM_USING_XIP
+    const u8 *xip_base;                 //mapped data of the verified image, NULL - params read default
+    u32 xip_addr;                       //save address of the mapped image
+    u16 xip_size;                       //data size of the mapped image
+    u16 xip_used;                       //bytes used in shadow pool
+    u8 *xip_shadow;                     //shadow pool, records of index and value
+    u8 *xip_dirty;                      //bit set - parameter has a shadow
+    #endif
+    #ifdef PARAM_USING_MIGRATE
+    param_mig_t *mig;                   //saved layout mapped to current, only while loading an image of other layout
+    u16 mig_total;                      //params total of saved layout
+    u8 mig_dup;                         //names of current table share a hash, images of other layout are not migrated
+    #endif
+    #ifdef PARAM_USING_STATS
+    param_stats_t stats;                //run time statistics
+    #endif
+    #ifdef PARAM_USING_PROFILE
+    param_prof_t *prof;                 //access counters of each param, allocated statically by param_table.h
+    #endif
+    #ifdef PARAM_USING_DELTA
+    param_gen_t *gens;                  //change generations of each param, allocated statically by param_table.h
+    u32 gen;                            //current generation, increased by each change
+    u32 epoch;                          //epoch of the run, chosen at first use, 0 - not chosen
+    u16 gen_head;                       //the latest changed param
+    #endif
+    #ifdef PARAM_USING_PACED_WRITE
+    u32 write_us;                       //flash time since the last yield
+    #endif
+    #ifdef PARAM_USING_DUAL
+    u32 dual_seq;                       //sequence of the newest copy
+    #endif
+    #ifdef PARAM_USING_PRE_ERASE
+    u32 slot_seq;                       //sequence of the newest image
+    s8 slot_cur;                        //slot of the newest image, -1 - none
+    u8 slot_ready;                      //next slot is erased
+    u8 slot_pending;                    //next slot is waiting for background erase
+    #endif
+    #ifdef PARAM_USING_PRESET
+    s16 preset_cur;                     //preset of the live image, -1 - the saved image
+    s8 sel_sector;                      //selector sector in use, -1 - none, -2 - not read yet
+    u16 sel_pos;                        //next record in selector sector
+    u16 sel_seq;                        //sequence of the last selector record
+    #endif
+}param_tbl_t;
+
+#ifdef PARAM_USING_TEXT_IMPORT
+//state of a streaming text import, see param_tbl_text_begin
+typedef struct
+{
+    param_tbl_t *tbl;
+    void *index;                        //name hash index of table
+    u8 *stage;                          //staged values, same layout as table
+    u8 *staged;                         //bit set - parameter is staged
+    int slots;                          //slots of name index
+    int line;                           //number of current line
+    int len;                            //chars of current line
+    int count;                          //lines staged
+    int errors;                         //lines with error
+    int first_error;                    //number of first line with error, 0 - no error
+    u8 skip;                            //current line is too long, skipped until its end
+    char buf[PARAM_TEXT_LINE_MAX];
+}param_text_t;
+#endif
+
+//declare a table defined in other file
+#define PARAM_TABLE_DECLARE(name)   extern param_tbl_t param_tbl_##name
+
+PARAM_TABLE_DECLARE(main);//the table defined by param_def.h, used by all param_xxx functions
 
 /* 
  * @brief   initialize parameter module
@@ -76,6 +554,7 @@ int param_save_to_flash(void);
  */
 int param_resume_all(void);
 
+#ifndef PARAM_USING_INDEX_ONLY
 /* 
  * @brief   resume default by name
  * @param   name - parameter name
@@ -100,15 +579,18 @@ int param_read_by_name(char *name, void *addr, int size);
  * @retval  0 - success, <0 - error
  */
 int param_write_by_name(char *name, const void *addr, int size);
+#endif
 
 #ifdef PARAM_USING_INDEX
 
+#ifndef PARAM_USING_INDEX_ONLY
 /* 
  * @brief   get parameter name by index
  * @param   idx - parameter index
  * @retval  pointer to parameter name , NULL - parameter is not exist
  */
 const char *param_get_name(int idx);
+#endif
 
 /* 
  * @brief   resume default by index
@@ -136,5 +618,461 @@ int param_read_by_index(int idx, void *addr, int size);
 int param_write_by_index(int idx, const void *addr, int size);
 
 #endif
+
+/* 
+ * @brief   initialize parameter table, the table is registered for finding by name
+ * @param   tbl - parameter table
+ * @retval  0 - success, <0 - error
+ */
+int param_tbl_init(param_tbl_t *tbl);
+
+/* 
+ * @brief   deinitialize parameter table
+ * @param   tbl - parameter table
+ * @retval  none
+ */
+void param_tbl_deinit(param_tbl_t *tbl);
+
+/* 
+ * @brief   find initialized parameter table by name
+ * @param   name - table name
+ * @retval  pointer to parameter table, NULL - table is not exist
+ */
+param_tbl_t *param_tbl_find(const char *name);
+
+/* 
+ * @brief   load parameter table from flash
+ * @param   tbl - parameter table
+ * @retval  0 - success, <0 - error
+ */
+int param_tbl_load(param_tbl_t *tbl);
+
+/* 
+ * @brief   save parameter table to flash
+ * @param   tbl - parameter table
+ * @retval  0 - success, <0 - error
+ */
+int param_tbl_save(param_tbl_t *tbl);
+
+/* 
+ * @brief   resume all parameter of table to default
+ * @param   tbl - parameter table
+ * @retval  0 - success, <0 - error
+ */
+int param_tbl_resume_all(param_tbl_t *tbl);
+
+#ifndef PARAM_USING_INDEX_ONLY
+/* 
+ * @brief   resume default by name
+ * @param   tbl - parameter table
+ * @param   name - parameter name
+ * @retval  0 - success, <0 - error
+ */
+int param_tbl_resume_by_name(param_tbl_t *tbl, char *name);
+
+/* 
+ * @brief   read parameter by name
+ * @param   tbl - parameter table
+ * @param   name - parameter name
+ * @param   addr - address of the variable that save parameter 
+ * @param   size - size of the variable that save parameter
+ * @retval  0 - success, <0 - error
+ */
+int param_tbl_read_by_name(param_tbl_t *tbl, char *name, void *addr, int size);
+
+/* 
+ * @brief   write parameter by name
+ * @param   tbl - parameter table
+ * @param   name - parameter name
+ * @param   addr - address of the variable that save parameter 
+ * @param   size - size of the variable that save parameter
+ * @retval  0 - success, <0 - error
+ */
+int param_tbl_write_by_name(param_tbl_t *tbl, char *name, const void *addr, int size);
+#endif
+
+#ifdef PARAM_USING_INDEX
+
+#ifndef PARAM_USING_INDEX_ONLY
+/* 
+ * @brief   get parameter name by index
+ * @param   tbl - parameter table
+ * @param   idx - parameter index
+ * @retval  pointer to parameter name , NULL - parameter is not exist
+ */
+const char *param_tbl_get_name(param_tbl_t *tbl, int idx);
+#endif
+
+/* 
+ * @brief   resume default by index
+ * @param   tbl - parameter table
+ * @param   idx - parameter index
+ * @retval  0 - success, <0 - error
+ */
+int param_tbl_resume_by_index(param_tbl_t *tbl, int idx);
+
+/* 
+ * @brief   read parameter by index
+ * @param   tbl - parameter table
+ * @param   idx - parameter index
+ * @param   addr - address of the variable that save parameter 
+ * @param   size - size of the variable that save parameter
+ * @retval  0 - success, <0 - error
+ */
+int param_tbl_read_by_index(param_tbl_t *tbl, int idx, void *addr, int size);
+
+/* 
+ * @brief   write param by index
+ * @param   tbl - parameter table
+ * @param   idx - parameter index
+ * @param   addr - address of the variable that save parameter 
+ * @param   size - size of the variable that save parameter
+ * @retval  0 - success, <0 - error
+ */
+int param_tbl_write_by_index(param_tbl_t *tbl, int idx, const void *addr, int size);
+
+/* 
+ * @brief   notify the param was modified in place, used by typed access of param.hpp
+ * @param   tbl - parameter table
+ * @param   idx - parameter index
+ * @retval  0 - success, <0 - error
+ */
+int param_tbl_notify(param_tbl_t *tbl, int idx);
+
+#endif
+
+#ifdef PARAM_USING_DYNAMIC
+
+/* 
+ * @brief   create or update dynamic parameter of table
+ * @param   tbl - parameter table
+ * @param   key - dynamic parameter name
+ * @param   val - value of dynamic parameter
+ * @param   len - value length
+ * @retval  0 - success, <0 - error
+ */
+int param_tbl_dyn_set(param_tbl_t *tbl, const char *key, const void *val, int len);
+
+/* 
+ * @brief   read dynamic parameter of table
+ * @param   tbl - parameter table
+ * @param   key - dynamic parameter name
+ * @param   buf - buffer for value
+ * @param   size - buffer size, longer value is truncated
+ * @retval  >=0 - value length, <0 - error
+ */
+int param_tbl_dyn_get(param_tbl_t *tbl, const char *key, void *buf, int size);
+
+/* 
+ * @brief   delete dynamic parameter of table
+ * @param   tbl - parameter table
+ * @param   key - dynamic parameter name
+ * @retval  0 - success, <0 - error
+ */
+int param_tbl_dyn_delete(param_tbl_t *tbl, const char *key);
+
+/* 
+ * @brief   get dynamic parameters total of table
+ * @param   tbl - parameter table
+ * @retval  dynamic parameters total
+ */
+int param_tbl_dyn_count(param_tbl_t *tbl);
+
+/* 
+ * @brief   create or update dynamic parameter
+ * @param   key - dynamic parameter name
+ * @param   val - value of dynamic parameter
+ * @param   len - value length
+ * @retval  0 - success, <0 - error
+ */
+int param_dyn_set(const char *key, const void *val, int len);
+
+/* 
+ * @brief   read dynamic parameter
+ * @param   key - dynamic parameter name
+ * @param   buf - buffer for value
+ * @param   size - buffer size, longer value is truncated
+ * @retval  >=0 - value length, <0 - error
+ */
+int param_dyn_get(const char *key, void *buf, int size);
+
+/* 
+ * @brief   delete dynamic parameter
+ * @param   key - dynamic parameter name
+ * @retval  0 - success, <0 - error
+ */
+int param_dyn_delete(const char *key);
+
+#endif
+
+#ifdef PARAM_USING_EXPORT
+
+/* 
+ * @brief   export params of table to a binary blob
+ * @param   tbl - parameter table
+ * @param   buf - buffer for blob, NULL - only get the blob size
+ * @param   size - buffer size
+ * @param   flags - 0 - all params, PARAM_EXPORT_SPARSE - only params differ from default
+ * @retval  >0 - blob size, <0 - error
+ */
+int param_tbl_export(param_tbl_t *tbl, void *buf, int size, int flags);
+
+/* 
+ * @brief   import a blob exported by param_tbl_export or param_tbl_delta_export, it is checked before any param is changed,
+ *          then saved once, params without record are resumed to default, except in a delta blob.
+ *          with PARAM_USING_XIP a blob changing more params than the shadow pool holds is refused
+ * @param   tbl - parameter table
+ * @param   buf - blob
+ * @param   size - blob size
+ * @retval  0 - success, <0 - error, no param is changed
+ */
+int param_tbl_import(param_tbl_t *tbl, const void *buf, int size);
+
+/* 
+ * @brief   export params to a binary blob
+ * @param   buf - buffer for blob, NULL - only get the blob size
+ * @param   size - buffer size
+ * @param   flags - 0 - all params, PARAM_EXPORT_SPARSE - only params differ from default
+ * @retval  >0 - blob size, <0 - error
+ */
+int param_export(void *buf, int size, int flags);
+
+/* 
+ * @brief   import a blob exported by param_export, it is checked before any param is changed, then saved once
+ * @param   buf - blob
+ * @param   size - blob size
+ * @retval  0 - success, <0 - error
+ */
+int param_import(const void *buf, int size);
+
+#ifdef PARAM_USING_DELTA
+
+/* 
+ * @brief   export params of table changed since a generation, as records of PARAM_EXPORT_DELTA,
+ *          generations restart at init, so they are only compared in the epoch of the same run,
+ *          the blob begins with the epoch and generation to be given by the next sync
+ * @param   tbl - parameter table
+ * @param   epoch - epoch of last sync, an epoch of other run - all params
+ * @param   since - generation of last sync, 0 or a generation newer than current - all params
+ * @param   buf - buffer for blob, NULL - only get the blob size
+ * @param   size - buffer size
+ * @retval  >0 - blob size, <0 - error
+ */
+int param_tbl_delta_export(param_tbl_t *tbl, u32 epoch, u32 since, void *buf, int size);
+
+/* 
+ * @brief   get current generation of table, it is changed only if a param is changed
+ * @param   tbl - parameter table
+ * @retval  generation
+ */
+u32 param_tbl_generation(param_tbl_t *tbl);
+
+/* 
+ * @brief   get the epoch of the run of table, it is chosen at first use after init from PARAM_BOOT_EPOCH
+ * @param   tbl - parameter table
+ * @retval  epoch, 0 - error
+ */
+u32 param_tbl_epoch(param_tbl_t *tbl);
+
+/* 
+ * @brief   export params changed since a generation, see param_tbl_delta_export
+ * @param   epoch - epoch of last sync
+ * @param   since - generation of last sync
+ * @param   buf - buffer for blob, NULL - only get the blob size
+ * @param   size - buffer size
+ * @retval  >0 - blob size, <0 - error
+ */
+int param_delta_export(u32 epoch, u32 since, void *buf, int size);
+
+/* 
+ * @brief   get current generation of main table
+ * @retval  generation
+ */
+u32 param_generation(void);
+
+/* 
+ * @brief   get the epoch of the run of main table
+ * @retval  epoch, 0 - error
+ */
+u32 param_epoch(void);
+
+#endif
+
+#endif
+
+#ifdef PARAM_USING_TEXT_IMPORT
+
+/* 
+ * @brief   begin a streaming import of text lines "name=value", empty lines and lines begin with '#' are ignored
+ * @param   tbl - parameter table
+ * @param   ctx - import state, kept by caller until end or abort
+ * @retval  0 - success, <0 - error
+ */
+int param_tbl_text_begin(param_tbl_t *tbl, param_text_t *ctx);
+
+/* 
+ * @brief   feed a chunk of text, lines may be split between chunks, values are staged and params are not changed
+ * @param   ctx - import state
+ * @param   text - chunk of text
+ * @param   len - chunk length
+ * @retval  0 - success, <0 - error
+ */
+int param_text_feed(param_text_t *ctx, const char *text, int len);
+
+/* 
+ * @brief   end the import, all staged values are applied in one locked pass, then params are saved once,
+ *          a line with unknown param or a value that is not fully parsed or does not fit is an error line.
+ *          with PARAM_USING_XIP staged values more than the shadow pool holds are refused
+ * @param   ctx - import state
+ * @retval  >=0 - lines with error, they are skipped, <0 - error, no param is changed
+ */
+int param_text_end(param_text_t *ctx);
+
+/* 
+ * @brief   abort the import, staged values are dropped
+ * @param   ctx - import state
+ */
+void param_text_abort(param_text_t *ctx);
+
+/* 
+ * @brief   begin a streaming import of text lines into main table, see param_tbl_text_begin
+ * @param   ctx - import state, kept by caller until end or abort
+ * @retval  0 - success, <0 - error
+ */
+int param_text_begin(param_text_t *ctx);
+
+#endif
+
+#ifdef PARAM_USING_STATS
+
+/* 
+ * @brief   get a copy of the statistics of table
+ * @param   tbl - parameter table
+ * @param   stats - buffer of statistics
+ * @retval  0 - success, <0 - error
+ */
+int param_tbl_stats_get(param_tbl_t *tbl, param_stats_t *stats);
+
+/* 
+ * @brief   clear the statistics of table
+ * @param   tbl - parameter table
+ * @retval  none
+ */
+void param_tbl_stats_reset(param_tbl_t *tbl);
+
+/* 
+ * @brief   get a copy of the statistics of main table
+ * @param   stats - buffer of statistics
+ * @retval  0 - success, <0 - error
+ */
+int param_stats_get(param_stats_t *stats);
+
+/* 
+ * @brief   clear the statistics of main table
+ * @retval  none
+ */
+void param_stats_reset(void);
+
+#endif
+
+#ifdef PARAM_USING_PRE_ERASE
+
+/* 
+ * @brief   erase the next image slot of table if it is waiting, for idle time or a low priority thread
+ * @param   tbl - parameter table
+ * @retval  1 - a slot is erased, 0 - nothing to do, <0 - error
+ */
+int param_tbl_pre_erase(param_tbl_t *tbl);
+
+#endif
+
+#ifdef PARAM_USING_PRESET
+
+/* 
+ * @brief   store the live values of table as a preset, the preset sector is rewritten,
+ *          with PARAM_USING_XIP the live preset is mapped and can not be stored over itself
+ * @param   tbl - parameter table
+ * @param   name - preset name, one of the table presets
+ * @retval  0 - success, <0 - error
+ */
+int param_tbl_preset_store(param_tbl_t *tbl, const char *name);
+
+/* 
+ * @brief   switch the live image of table to a stored preset, a selector record is written after the journal
+ *          snapshot of the preset with PARAM_USING_JOURNAL, without PARAM_USING_XIP the whole preset image is read,
+ *          unsaved changes are dropped, volatile params keep their values
+ * @param   tbl - parameter table
+ * @param   name - preset name, one of the table presets
+ * @retval  0 - success, <0 - error, the live image is not changed
+ */
+int param_tbl_preset_switch(param_tbl_t *tbl, const char *name);
+
+/* 
+ * @brief   get the preset of the live image, a save of table makes the saved image live again
+ * @param   tbl - parameter table
+ * @retval  preset name, NULL - the saved image is live
+ */
+const char *param_tbl_preset_active(param_tbl_t *tbl);
+
+/* 
+ * @brief   store the live values of main table as a preset, see param_tbl_preset_store
+ * @param   name - preset name
+ * @retval  0 - success, <0 - error
+ */
+int param_preset_store(const char *name);
+
+/* 
+ * @brief   switch the live image of main table to a stored preset, see param_tbl_preset_switch
+ * @param   name - preset name
+ * @retval  0 - success, <0 - error
+ */
+int param_preset_switch(const char *name);
+
+/* 
+ * @brief   get the preset of the live image of main table
+ * @retval  preset name, NULL - the saved image is live
+ */
+const char *param_preset_active(void);
+
+#endif
+
+#ifdef PARAM_USING_PROFILE
+
+/* 
+ * @brief   rank params of table by access count, most accessed first
+ * @param   tbl - parameter table
+ * @param   order - buffer of param indexes
+ * @param   count - size of buffer, the hottest count params are filled
+ * @retval  >=0 - params filled, <0 - error
+ */
+int param_tbl_prof_rank(param_tbl_t *tbl, u16 *order, int count);
+
+/* 
+ * @brief   clear the access counters of table
+ * @param   tbl - parameter table
+ * @retval  none
+ */
+void param_tbl_prof_reset(param_tbl_t *tbl);
+
+/* 
+ * @brief   rank params of main table by access count, see param_tbl_prof_rank
+ * @param   order - buffer of param indexes
+ * @param   count - size of buffer
+ * @retval  >=0 - params filled, <0 - error
+ */
+int param_prof_rank(u16 *order, int count);
+
+/* 
+ * @brief   clear the access counters of main table
+ * @retval  none
+ */
+void param_prof_reset(void);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif
 
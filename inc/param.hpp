@@ -0,0 +1,194 @@
+/*
+ * param.hpp
+ *
+ * Change Logs:
+ * Date           Author            Notes
+ * 2020-06-07     qiyongzhong       first version
+ */
+
+/*
+ * typed access of the main table for c++, sample :
+ *
+ *  f32 v = param::get<PIDX_VOLTAGE>();     //direct load, no type dispatch at run time
+ *  param::set<PIDX_VOLTAGE>(3.3f);         //direct store, then the same bookkeeping as param_write_by_index
+ *  param::set<PIDX_CAR>("bus");            //string is truncated and zero filled
+ *
+ * the offset and type of each param are computed at compile time from param_def.h,
+ * a value of other kind or wider than the param is rejected by static_assert.
+ * get/set do not take the table mutex, a param shared by threads is accessed like a global variable,
+ * strings and arrays are returned as pointers to the param data.
+ */
+
+#ifndef __PARAM_HPP__
+#define __PARAM_HPP__
+
+#include <param.h>
+#include <string.h>
+#include <type_traits>
+
+#ifndef PARAM_USING_INDEX
+#error "param.hpp needs PARAM_USING_INDEX"
+#endif
+
+#ifdef PARAM_USING_XIP
+#error "param.hpp stores params in place, it can not be used with PARAM_USING_XIP"
+#endif
+
+namespace param {
+namespace detail {
+
+struct desc
+{
+    param_type_t type;
+    unsigned char size;
+};
+
+#define PARAM_BEGIN()                           constexpr desc table[] = {
+#define PARAM_END()                             };
+#define PARAM_STRING(name, size, defval, ...)   {PTYPE_STR,     size+1},
+#define PARAM_ARRAY(name, size, defval, ...)    {PTYPE_ARRAY,   size},
+#define PARAM_INT(name, defval, ...)            {PTYPE_INT,     sizeof(u32)},
+#define PARAM_INT64(name, defval, ...)          {PTYPE_INT,     sizeof(u64)},
+#define PARAM_HEX(name, defval, ...)            {PTYPE_HEX,     sizeof(u32)},
+#define PARAM_HEX64(name, defval, ...)          {PTYPE_HEX,     sizeof(u64)},
+#define PARAM_FLOAT(name, defval, ...)          {PTYPE_FLOAT,   sizeof(f32)},
+#define PARAM_DOUBLE(name, defval, ...)         {PTYPE_FLOAT,   sizeof(f64)},
+#define PARAM_COUNTER(name, defval)             {PTYPE_INT,     sizeof(u64)},
+#define PARAM_COUNTER_DOUBLE(name, defval)      {PTYPE_FLOAT,   sizeof(f64)},
+
+#define PARAM_TABLE_DEF
+#undef __PARAM_DEF_H__
+#include <param_def.h>
+#undef PARAM_TABLE_DEF
+
+#undef PARAM_BEGIN
+#undef PARAM_END
+#undef PARAM_STRING
+#undef PARAM_ARRAY
+#undef PARAM_INT
+#undef PARAM_INT64
+#undef PARAM_HEX
+#undef PARAM_HEX64
+#undef PARAM_FLOAT
+#undef PARAM_DOUBLE
+#undef PARAM_COUNTER
+#undef PARAM_COUNTER_DOUBLE
+
+constexpr unsigned total = sizeof(table) / sizeof(table[0]);
+
+constexpr unsigned offset(unsigned idx)
+{
+    return (idx == 0) ? 0 : (offset(idx - 1) + table[idx - 1].size);
+}
+
+template<int type, unsigned size> struct value;
+template<unsigned size> struct value<PTYPE_STR, size>   { typedef const char *type; };
+template<unsigned size> struct value<PTYPE_ARRAY, size> { typedef const u8 *type; };
+template<> struct value<PTYPE_INT, sizeof(u32)>         { typedef s32 type; };
+template<> struct value<PTYPE_INT, sizeof(u64)>         { typedef s64 type; };
+template<> struct value<PTYPE_HEX, sizeof(u32)>         { typedef u32 type; };
+template<> struct value<PTYPE_HEX, sizeof(u64)>         { typedef u64 type; };
+template<> struct value<PTYPE_FLOAT, sizeof(f32)>       { typedef f32 type; };
+template<> struct value<PTYPE_FLOAT, sizeof(f64)>       { typedef f64 type; };
+
+template<int type> using kind = std::integral_constant<int, type>;
+
+template<unsigned idx>
+inline u8 *data()
+{
+    return(param_tbl_main.datas + offset(idx));
+}
+
+template<typename T>
+inline T load(const u8 *p, std::true_type)//scalar, copied by constant size, so unaligned data is safe
+{
+    T v;
+    memcpy(&v, p, sizeof(T));
+    return(v);
+}
+
+template<typename T>
+inline T load(const u8 *p, std::false_type)//string or array
+{
+    return(reinterpret_cast<T>(p));
+}
+
+template<unsigned idx, typename V>
+inline void store(const V &v, kind<PTYPE_STR>)
+{
+    static_assert(std::is_convertible<const V &, const char *>::value, "type mismatch, the param is a string");
+    const char *str = v;
+    u8 *p = data<idx>();
+    size_t len = strlen(str);
+
+    if (len > table[idx].size - 1u)
+    {
+        len = table[idx].size - 1u;
+    }
+    memcpy(p, str, len);
+    memset(p + len, 0, table[idx].size - len);
+}
+
+template<unsigned idx, typename V>
+inline void store(const V &v, kind<PTYPE_ARRAY>)
+{
+    static_assert(std::is_array<V>::value && (sizeof(typename std::remove_extent<V>::type) == 1), "type mismatch, the param is a byte array");
+    static_assert(sizeof(V) <= table[idx].size, "type mismatch, the array is bigger than the param");
+    memcpy(data<idx>(), v, sizeof(V));
+}
+
+template<unsigned idx, typename T, typename V>
+inline void store_scalar(const V &v)
+{
+    static_assert(std::is_arithmetic<V>::value, "type mismatch, the param is a number");
+    static_assert(std::is_floating_point<T>::value == std::is_floating_point<V>::value,
+                  "type mismatch, integer and floating point are not mixed");
+    static_assert(sizeof(V) <= sizeof(T), "type mismatch, the value is wider than the param");
+    T tv = static_cast<T>(v);
+    memcpy(data<idx>(), &tv, sizeof(T));
+}
+
+template<unsigned idx, typename V>
+inline void store(const V &v, kind<PTYPE_INT>)
+{
+    store_scalar<idx, typename value<PTYPE_INT, table[idx].size>::type>(v);
+}
+
+template<unsigned idx, typename V>
+inline void store(const V &v, kind<PTYPE_HEX>)
+{
+    store_scalar<idx, typename value<PTYPE_HEX, table[idx].size>::type>(v);
+}
+
+template<unsigned idx, typename V>
+inline void store(const V &v, kind<PTYPE_FLOAT>)
+{
+    store_scalar<idx, typename value<PTYPE_FLOAT, table[idx].size>::type>(v);
+}
+
+}//namespace detail
+
+static_assert(detail::total == PIDX_TOTAL, "param_index.h is not consistent with param_def.h");
+
+//value type of param, string - const char *, array - const u8 *
+template<param_idx_t idx>
+using type = typename detail::value<detail::table[idx].type, detail::table[idx].size>::type;
+
+template<param_idx_t idx>
+inline type<idx> get()
+{
+    static_assert((unsigned)idx < detail::total, "param index is out of range");
+    return(detail::load<type<idx>>(detail::data<idx>(), std::is_arithmetic<type<idx>>()));
+}
+
+template<param_idx_t idx, typename V>
+inline void set(const V &v)
+{
+    static_assert((unsigned)idx < detail::total, "param index is out of range");
+    detail::store<idx>(v, detail::kind<detail::table[idx].type>());
+    param_tbl_notify(&param_tbl_main, idx);
+}
+
+}//namespace param
+
+#endif
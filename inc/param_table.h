@@ -0,0 +1,321 @@
+/*
+ * param_table.h
+ *
+ * Change Logs:
+ * Date           Author            Notes
+ * 2020-06-07     qiyongzhong       first version
+ */
+
+/*
+ * parameter table generator, it is included once for each table, sample :
+ *
+ *  #define PARAM_TABLE_NAME            motor               //table name, the table is param_tbl_motor
+ *  #define PARAM_TABLE_FILE            <motor_def.h>       //parameter definition file, same format as param_def.h
+ *  #define PARAM_TABLE_PART_NAME       "motor"             //optional, default PARAM_PART_NAME, storage name of the backend
+ *  #define PARAM_TABLE_BACKEND         &param_backend_ram  //optional with PARAM_USING_BACKEND, default PARAM_BACKEND
+ *  #define PARAM_TABLE_SAVE_ADDR       0                   //save address, storage of tables on one partition must not overlap
+ *  #define PARAM_TABLE_SAVE_ADDR_BAK   4096                //optional, default PARAM_TABLE_SAVE_ADDR + PARAM_SECTOR_SIZE, PARAM_TABLE_SAVE_ADDR with PARAM_USING_DUAL
+ *  #define PARAM_TABLE_PART_NAME_BAK   "motor_bak"         //optional with PARAM_USING_DUAL, default PARAM_PART_NAME_BAK
+ *  #define PARAM_TABLE_SPARE_ADDR      8192                //optional with PARAM_USING_PRE_ERASE, default PARAM_TABLE_SAVE_ADDR_BAK + PARAM_SECTOR_SIZE
+ *  #define PARAM_TABLE_JOURNAL_ADDR    8192                //optional, default the sector after the last image slot
+ *  #define PARAM_TABLE_JOURNAL_SECTORS 2                   //optional, default PARAM_JOURNAL_SECTORS
+ *  #define PARAM_TABLE_AUTO_SAVE_DELAY 5000                //optional, default PARAM_AUTO_SAVE_DELAY, 0 - no automatic save
+ *  #define PARAM_TABLE_DYN_ADDR        16384               //optional, default PARAM_TABLE_JOURNAL_ADDR + journal size
+ *  #define PARAM_TABLE_DYN_SECTORS     1                   //optional, default PARAM_DYN_SECTORS
+ *  #define PARAM_TABLE_DYN_ADDR_BAK    20480               //optional, default PARAM_TABLE_DYN_ADDR + dynamic params size
+ *  #define PARAM_TABLE_DYN_SLOTS       128                 //optional, default PARAM_DYN_SLOTS
+ *  #define PARAM_TABLE_PRESET_ADDR     24576               //optional with PARAM_USING_PRESET, default PARAM_TABLE_DYN_ADDR_BAK + dynamic params size
+ *  #define PARAM_TABLE_PRESET_NAMES    "run", "idle"       //optional with PARAM_USING_PRESET, default PARAM_PRESET_NAMES
+ *  #include <param_table.h>
+ *
+ * the storage of each table must not overlap others.
+ * with PARAM_USING_COMPACT the definition file is included several times, it must not have
+ * an include guard, except __PARAM_DEF_H__ of the template which is released here.
+ */
+
+#include <param.h>
+
+#ifndef PARAM_TABLE_NAME
+#error "please define PARAM_TABLE_NAME before including param_table.h"
+#endif
+
+#ifndef PARAM_TABLE_FILE
+#error "please define PARAM_TABLE_FILE before including param_table.h"
+#endif
+
+#ifndef PARAM_TABLE_PART_NAME
+#define PARAM_TABLE_PART_NAME       PARAM_PART_NAME
+#endif
+
+#ifndef PARAM_TABLE_BACKEND
+#define PARAM_TABLE_BACKEND         PARAM_BACKEND
+#endif
+
+#ifndef PARAM_TABLE_SAVE_ADDR
+#error "please define PARAM_TABLE_SAVE_ADDR before including param_table.h, tables must not share storage"
+#endif
+
+#ifndef PARAM_TABLE_PART_NAME_BAK
+#define PARAM_TABLE_PART_NAME_BAK   PARAM_PART_NAME_BAK
+#endif
+
+#ifndef PARAM_TABLE_SAVE_ADDR_BAK
+#ifdef PARAM_USING_DUAL
+#define PARAM_TABLE_SAVE_ADDR_BAK   PARAM_TABLE_SAVE_ADDR
+#else
+#define PARAM_TABLE_SAVE_ADDR_BAK   (PARAM_TABLE_SAVE_ADDR + PARAM_SECTOR_SIZE)
+#endif
+#endif
+
+#ifndef PARAM_TABLE_SPARE_ADDR
+#define PARAM_TABLE_SPARE_ADDR      (PARAM_TABLE_SAVE_ADDR_BAK + PARAM_SECTOR_SIZE)
+#endif
+
+#ifndef PARAM_TABLE_JOURNAL_ADDR
+#ifdef PARAM_USING_PRE_ERASE
+#define PARAM_TABLE_JOURNAL_ADDR    (PARAM_TABLE_SPARE_ADDR + PARAM_SECTOR_SIZE)
+#elif defined(PARAM_USING_DUAL)
+#define PARAM_TABLE_JOURNAL_ADDR    (PARAM_TABLE_SAVE_ADDR + PARAM_SECTOR_SIZE * 2)
+#else
+#define PARAM_TABLE_JOURNAL_ADDR    (PARAM_TABLE_SAVE_ADDR_BAK + PARAM_SECTOR_SIZE)
+#endif
+#endif
+
+#ifndef PARAM_TABLE_JOURNAL_SECTORS
+#define PARAM_TABLE_JOURNAL_SECTORS PARAM_JOURNAL_SECTORS
+#endif
+
+#ifndef PARAM_TABLE_AUTO_SAVE_DELAY
+#define PARAM_TABLE_AUTO_SAVE_DELAY PARAM_AUTO_SAVE_DELAY
+#endif
+
+#ifndef PARAM_TABLE_DYN_ADDR
+#define PARAM_TABLE_DYN_ADDR        (PARAM_TABLE_JOURNAL_ADDR + PARAM_TABLE_JOURNAL_SECTORS * PARAM_SECTOR_SIZE)
+#endif
+
+#ifndef PARAM_TABLE_DYN_SECTORS
+#define PARAM_TABLE_DYN_SECTORS     PARAM_DYN_SECTORS
+#endif
+
+#ifndef PARAM_TABLE_DYN_ADDR_BAK
+#define PARAM_TABLE_DYN_ADDR_BAK    (PARAM_TABLE_DYN_ADDR + PARAM_TABLE_DYN_SECTORS * PARAM_SECTOR_SIZE)
+#endif
+
+#ifndef PARAM_TABLE_DYN_SLOTS
+#define PARAM_TABLE_DYN_SLOTS       PARAM_DYN_SLOTS
+#endif
+
+#ifndef PARAM_TABLE_PRESET_ADDR
+#define PARAM_TABLE_PRESET_ADDR     (PARAM_TABLE_DYN_ADDR_BAK + PARAM_TABLE_DYN_SECTORS * PARAM_SECTOR_SIZE)
+#endif
+
+#ifndef PARAM_TABLE_PRESET_NAMES
+#define PARAM_TABLE_PRESET_NAMES    PARAM_PRESET_NAMES
+#endif
+
+#ifndef __PARAM_TABLE_H__
+#define __PARAM_TABLE_H__
+
+#define PARAM_TBL_CAT_(a, b)        a##b
+#define PARAM_TBL_CAT(a, b)         PARAM_TBL_CAT_(a, b)
+#define PARAM_TBL_STR_(a)           #a
+#define PARAM_TBL_STR(a)            PARAM_TBL_STR_(a)
+#define PARAM_TBL_SYM(suffix)       PARAM_TBL_CAT(PARAM_TBL_CAT(param_tbl_, PARAM_TABLE_NAME), suffix)
+#endif
+
+//persistence class, optional last argument of parameter definition, default is PARAM_DEFERRED
+#define PARAM_DEFERRED                      PSTORE_IMAGE    //saved in image by coalesced saves
+#ifdef PARAM_USING_JOURNAL
+#define PARAM_IMMEDIATE                     PSTORE_JOURNAL  //saved in journal at once
+#else
+#define PARAM_IMMEDIATE                     PARAM_IMMEDIATE_need_PARAM_USING_JOURNAL  //undeclared, fails the build without journal
+#endif
+#define PARAM_VOLATILE                      PSTORE_NONE     //only lives in RAM, never saved
+
+//each definition is expanded by PARAM_TBL_ITEM(name, defval, type, size, store)
+#define PARAM_STRING(name, size, defval, ...)   PARAM_TBL_ITEM(name, defval, PTYPE_STR,     size+1,         __VA_ARGS__)
+#define PARAM_ARRAY(name, size, defval, ...)    PARAM_TBL_ITEM(name, defval, PTYPE_ARRAY,   size,           __VA_ARGS__)
+#define PARAM_INT(name, defval, ...)            PARAM_TBL_ITEM(name, defval, PTYPE_INT,     sizeof(u32),    __VA_ARGS__)
+#define PARAM_INT64(name, defval, ...)          PARAM_TBL_ITEM(name, defval, PTYPE_INT,     sizeof(u64),    __VA_ARGS__)
+#define PARAM_HEX(name, defval, ...)            PARAM_TBL_ITEM(name, defval, PTYPE_HEX,     sizeof(u32),    __VA_ARGS__)
+#define PARAM_HEX64(name, defval, ...)          PARAM_TBL_ITEM(name, defval, PTYPE_HEX,     sizeof(u64),    __VA_ARGS__)
+#define PARAM_FLOAT(name, defval, ...)          PARAM_TBL_ITEM(name, defval, PTYPE_FLOAT,   sizeof(f32),    __VA_ARGS__)
+#define PARAM_DOUBLE(name, defval, ...)         PARAM_TBL_ITEM(name, defval, PTYPE_FLOAT,   sizeof(f64),    __VA_ARGS__)
+#define PARAM_COUNTER(name, defval)             PARAM_TBL_ITEM(name, defval, PTYPE_INT,     sizeof(u64),    PARAM_IMMEDIATE)
+#define PARAM_COUNTER_DOUBLE(name, defval)      PARAM_TBL_ITEM(name, defval, PTYPE_FLOAT,   sizeof(f64),    PARAM_IMMEDIATE)
+
+#define PARAM_END()                 };
+#define PARAM_TABLE_DEF
+
+#ifdef PARAM_USING_COMPACT
+/*
+ * compact table, the definition file is expanded several times, so its include guard is released before each pass :
+ *  - layout struct of byte arrays, the compiler computes offsets and size, they are in ROM
+ *  - string pool of names and default values, definitions refer to it by 16 bits offsets
+ *  - datas and defaults are allocated statically
+ */
+#include <stddef.h>
+
+#define PARAM_BEGIN()               struct PARAM_TBL_SYM(_layout) {
+#define PARAM_TBL_ITEM(name, defval, type, size, ...)   u8 name[size];
+#undef __PARAM_DEF_H__
+#include PARAM_TABLE_FILE
+#undef PARAM_BEGIN
+#undef PARAM_TBL_ITEM
+
+#define PARAM_BEGIN()               struct PARAM_TBL_SYM(_pool) {
+#ifdef PARAM_USING_INDEX_ONLY
+#define PARAM_TBL_ITEM(name, defval, type, size, ...)   char name##_d[sizeof(#defval)];
+#else
+#define PARAM_TBL_ITEM(name, defval, type, size, ...)   char name##_n[sizeof(#name)]; char name##_d[sizeof(#defval)];
+#endif
+#undef __PARAM_DEF_H__
+#include PARAM_TABLE_FILE
+#undef PARAM_BEGIN
+#undef PARAM_TBL_ITEM
+
+#define PARAM_BEGIN()               static const struct PARAM_TBL_SYM(_pool) PARAM_TBL_SYM(_pool) = {
+#ifdef PARAM_USING_INDEX_ONLY
+#define PARAM_TBL_ITEM(name, defval, type, size, ...)   #defval,
+#else
+#define PARAM_TBL_ITEM(name, defval, type, size, ...)   #name, #defval,
+#endif
+#undef __PARAM_DEF_H__
+#include PARAM_TABLE_FILE
+#undef PARAM_BEGIN
+#undef PARAM_TBL_ITEM
+
+#define PARAM_BEGIN()               static const u16 PARAM_TBL_SYM(_offsets)[] = {
+#define PARAM_TBL_ITEM(name, defval, type, size, ...)   offsetof(struct PARAM_TBL_SYM(_layout), name),
+#undef __PARAM_DEF_H__
+#include PARAM_TABLE_FILE
+#undef PARAM_BEGIN
+#undef PARAM_TBL_ITEM
+
+#define PARAM_BEGIN()               static const param_msg_t PARAM_TBL_SYM(_msgs)[] = {
+#ifdef PARAM_USING_INDEX_ONLY
+#define PARAM_TBL_ITEM(name, defval, type, size, ...)   {offsetof(struct PARAM_TBL_SYM(_pool), name##_d), type, size, __VA_ARGS__},
+#else
+#define PARAM_TBL_ITEM(name, defval, type, size, ...)   {offsetof(struct PARAM_TBL_SYM(_pool), name##_n), \
+                                                         offsetof(struct PARAM_TBL_SYM(_pool), name##_d), type, size, __VA_ARGS__},
+#endif
+#undef __PARAM_DEF_H__
+#include PARAM_TABLE_FILE
+
+#define PARAM_TBL_DATA_SIZE         sizeof(struct PARAM_TBL_SYM(_layout))
+static u8 PARAM_TBL_SYM(_datas)[PARAM_TBL_DATA_SIZE];
+#ifdef PARAM_USING_OVERLAY
+static u8 PARAM_TBL_SYM(_defaults)[PARAM_TBL_DATA_SIZE];
+#endif
+#else
+#define PARAM_BEGIN()               static const param_msg_t PARAM_TBL_SYM(_msgs)[] = {
+#define PARAM_TBL_ITEM(name, defval, type, size, ...)   {#name, #defval, type, size, __VA_ARGS__},
+#undef __PARAM_DEF_H__
+#include PARAM_TABLE_FILE
+#endif
+
+#undef PARAM_TABLE_DEF
+
+#define PARAM_TBL_TOTAL             (sizeof(PARAM_TBL_SYM(_msgs))/sizeof(PARAM_TBL_SYM(_msgs)[0]))
+
+#ifndef PARAM_USING_COMPACT
+static u16 PARAM_TBL_SYM(_offsets)[PARAM_TBL_TOTAL];
+#endif
+#ifdef PARAM_USING_OVERLAY
+static u8 PARAM_TBL_SYM(_overlay_map)[(PARAM_TBL_TOTAL + 7) / 8];
+#endif
+#ifdef PARAM_USING_XIP
+static u8 PARAM_TBL_SYM(_xip_dirty)[(PARAM_TBL_TOTAL + 7) / 8];
+#endif
+#ifdef PARAM_USING_PROFILE
+static param_prof_t PARAM_TBL_SYM(_prof)[PARAM_TBL_TOTAL];
+#endif
+#ifdef PARAM_USING_DELTA
+static param_gen_t PARAM_TBL_SYM(_gens)[PARAM_TBL_TOTAL];
+#endif
+#ifdef PARAM_USING_PRESET
+static const char *const PARAM_TBL_SYM(_presets)[] = {PARAM_TABLE_PRESET_NAMES};
+#endif
+
+param_tbl_t PARAM_TBL_CAT(param_tbl_, PARAM_TABLE_NAME) = {
+    .name = PARAM_TBL_STR(PARAM_TABLE_NAME),
+    .msgs = PARAM_TBL_SYM(_msgs),
+    .total = PARAM_TBL_TOTAL,
+    .offsets = PARAM_TBL_SYM(_offsets),
+    #ifdef PARAM_USING_COMPACT
+    .pool = (const char *)&PARAM_TBL_SYM(_pool),
+    .datas = PARAM_TBL_SYM(_datas),
+    .size = PARAM_TBL_DATA_SIZE,
+    #ifdef PARAM_USING_OVERLAY
+    .defaults = PARAM_TBL_SYM(_defaults),
+    #endif
+    #endif
+    .cfg = {
+        #ifdef PARAM_USING_BACKEND
+        .backend = PARAM_TABLE_BACKEND,
+        #endif
+        .part_name = PARAM_TABLE_PART_NAME,
+        .part_name_bak = PARAM_TABLE_PART_NAME_BAK,
+        .save_addr = PARAM_TABLE_SAVE_ADDR,
+        .save_addr_bak = PARAM_TABLE_SAVE_ADDR_BAK,
+        .spare_addr = PARAM_TABLE_SPARE_ADDR,
+        .journal_addr = PARAM_TABLE_JOURNAL_ADDR,
+        .journal_sectors = PARAM_TABLE_JOURNAL_SECTORS,
+        .auto_save_delay = PARAM_TABLE_AUTO_SAVE_DELAY,
+        .dyn_addr = PARAM_TABLE_DYN_ADDR,
+        .dyn_addr_bak = PARAM_TABLE_DYN_ADDR_BAK,
+        .dyn_sectors = PARAM_TABLE_DYN_SECTORS,
+        .dyn_slots = PARAM_TABLE_DYN_SLOTS,
+        .preset_addr = PARAM_TABLE_PRESET_ADDR,
+        #ifdef PARAM_USING_PRESET
+        .presets = PARAM_TBL_SYM(_presets),
+        .preset_total = sizeof(PARAM_TBL_SYM(_presets)) / sizeof(PARAM_TBL_SYM(_presets)[0]),
+        #endif
+    },
+    #ifdef PARAM_USING_OVERLAY
+    .overlay_map = PARAM_TBL_SYM(_overlay_map),
+    #endif
+    #ifdef PARAM_USING_XIP
+    .xip_dirty = PARAM_TBL_SYM(_xip_dirty),
+    #endif
+    #ifdef PARAM_USING_PROFILE
+    .prof = PARAM_TBL_SYM(_prof),
+    #endif
+    #ifdef PARAM_USING_DELTA
+    .gens = PARAM_TBL_SYM(_gens),
+    #endif
+};
+
+#undef PARAM_BEGIN
+#undef PARAM_END
+#undef PARAM_TBL_ITEM
+#undef PARAM_STRING
+#undef PARAM_ARRAY
+#undef PARAM_INT
+#undef PARAM_INT64
+#undef PARAM_HEX
+#undef PARAM_HEX64
+#undef PARAM_FLOAT
+#undef PARAM_DOUBLE
+#undef PARAM_COUNTER
+#undef PARAM_COUNTER_DOUBLE
+#undef PARAM_TBL_TOTAL
+#undef PARAM_TBL_DATA_SIZE
+
+#undef PARAM_TABLE_NAME
+#undef PARAM_TABLE_FILE
+#undef PARAM_TABLE_PART_NAME
+#undef PARAM_TABLE_BACKEND
+#undef PARAM_TABLE_PART_NAME_BAK
+#undef PARAM_TABLE_SAVE_ADDR
+#undef PARAM_TABLE_SAVE_ADDR_BAK
+#undef PARAM_TABLE_SPARE_ADDR
+#undef PARAM_TABLE_JOURNAL_ADDR
+#undef PARAM_TABLE_JOURNAL_SECTORS
+#undef PARAM_TABLE_AUTO_SAVE_DELAY
+#undef PARAM_TABLE_DYN_ADDR
+#undef PARAM_TABLE_DYN_SECTORS
+#undef PARAM_TABLE_DYN_ADDR_BAK
+#undef PARAM_TABLE_DYN_SLOTS
+#undef PARAM_TABLE_PRESET_ADDR
+#undef PARAM_TABLE_PRESET_NAMES
@@ -26,6 +26,10 @@ PARAM_HEX   (reg_addr,    A001)
 PARAM_HEX64 (reg_value,   12345678ABCDEF)
 PARAM_FLOAT (voltage,     12.34)
 PARAM_DOUBLE(energy,      87654321.123)
+PARAM_COUNTER(run_time,   0)            //64 bits counter, saved in journal, need PARAM_USING_JOURNAL
+PARAM_COUNTER_DOUBLE(total_energy, 0.0) //double counter, saved in journal, need PARAM_USING_JOURNAL
+PARAM_INT   (gain,        5,      PARAM_VOLATILE)   //only lives in RAM
+PARAM_STRING(token,       31,     none,   PARAM_IMMEDIATE)  //saved in journal at once, need PARAM_USING_JOURNAL
 
 //param definition end
 PARAM_END()
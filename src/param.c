@@ -13,12 +13,19 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <stddef.h>
+#include <float.h>
+#if defined(PARAM_USING_BACKEND) && defined(RT_USING_DFS)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 #define DBG_TAG "param"
 #define DBG_LVL DBG_INFO
 #include <rtdbg.h>
 
 #define PARAM_CRC16_CAL(p, l)                   crc16_cal(p, l)
+#define PARAM_CRC16_CYC_CAL(crc, p, l)          crc16_cyc_cal(crc, p, l)
 
 #define PARAM_MUTEX_CREATE()                    rt_mutex_create("param", RT_IPC_FLAG_FIFO)
 #define PARAM_MUTEX_DELETE(p)                   rt_mutex_delete(p)
@@ -29,16 +36,56 @@
 #define PARAM_FLASH_ERASE(p, addr, size)        fal_partition_erase(p, addr, size)
 #define PARAM_FLASH_READ(p, addr, buf, size)    fal_partition_read(p, addr, buf, size)
 #define PARAM_FLASH_WRITE(p, addr, buf, size)   fal_partition_write(p, addr, buf, size)
+#define PARAM_FLASH_DEV_FIND(name)              fal_flash_device_find(name)
 
 #define PARAM_PRINT                             rt_kprintf
 
-typedef enum{
-    PTYPE_STR = 0,      //0-string
-    PTYPE_ARRAY,        //1-unsigned char array
-    PTYPE_INT,          //2-32/64 bits signed int
-    PTYPE_HEX,          //3-32/64 bits unsigned int
-    PTYPE_FLOAT         //4-float/double
-}param_type_t;
+#ifdef PARAM_USING_BACKEND
+#define PARAM_TBL_STORAGE(tbl)                  ((tbl)->dev)
+#define PARAM_TBL_STORAGE_BAK(tbl)              ((tbl)->dev_bak)
+#define PARAM_TBL_IN_PLACE(tbl)                 ((tbl)->cfg.backend->in_place)
+typedef void *param_storage_t;
+#else
+#define PARAM_TBL_STORAGE(tbl)                  ((tbl)->part)
+#define PARAM_TBL_STORAGE_BAK(tbl)              ((tbl)->part_bak)
+#define PARAM_TBL_IN_PLACE(tbl)                 0
+typedef const struct fal_partition *param_storage_t;
+#endif
+
+#ifdef PARAM_USING_DUAL
+#define PARAM_ADDR_BAK                          0x80000000  //flag of address in the storage of backup copy
+#endif
+
+#define PARAM_MUTEX_TRY(p)                      rt_mutex_take(p, RT_WAITING_NO)
+
+#ifdef PARAM_USING_STATS
+#define PARAM_STAT_INC(tbl, field)              ((tbl)->stats.field++)
+#define PARAM_STAT_ADD(tbl, field, n)           ((tbl)->stats.field += (n))
+#else
+#define PARAM_STAT_INC(tbl, field)
+#define PARAM_STAT_ADD(tbl, field, n)
+#endif
+
+#ifdef PARAM_USING_PROFILE
+#define PARAM_PROF_INC(tbl, idx, field)         ((tbl)->prof[idx].field++)//no lock, counters only guide the layout
+#else
+#define PARAM_PROF_INC(tbl, idx, field)
+#endif
+
+#ifdef PARAM_USING_DELTA
+#define PARAM_GEN_NONE                          0xFFFF  //end of the list of changed params
+#define PARAM_GEN_STAMP(tbl, idx)               param_gen_stamp(tbl, idx)//the table is locked
+#define PARAM_GEN_STAMP_ALL(tbl)                param_gen_stamp_all(tbl)
+#else
+#define PARAM_GEN_STAMP(tbl, idx)
+#define PARAM_GEN_STAMP_ALL(tbl)
+#endif
+
+#if defined(PARAM_USING_OVERLAY) || defined(PARAM_USING_COMPRESS) || defined(PARAM_USING_XIP) || defined(PARAM_USING_MIGRATE)
+#define PARAM_USING_EXT_IMAGE                   //image with extended head
+#endif
+
+#define PARAM_VALUE_MAX                         255     //max size of one parameter
 
 typedef struct
 {
@@ -48,1000 +95,7146 @@ typedef struct
     u16 head_crc16;
 }param_head_t;
 
+typedef enum{
+    PFMT_RAW = 0,       //0-whole image
+    PFMT_SPARSE         //1-records of non-default params
+}param_fmt_t;
+
+#define PFMT_DIR            0x80    //flag of format, data begins with directory of params
+
+typedef enum{
+    PCOMP_NONE = 0,     //0-no compression
+    PCOMP_RLE           //1-run length encoding
+}param_comp_t;
+
+typedef struct
+{
+    u16 magic;          //PARAM_MAGIC_EXT
+    u8  format;         //data format, see param_fmt_t
+    u8  comp;           //compression type, see param_comp_t
+    u16 size;           //data size in flash
+    u16 raw_size;       //data size before compression
+    u16 crc16;          //crc of data before compression
+    u16 head_crc16;
+}param_ext_head_t;
+
+#ifdef PARAM_USING_PRE_ERASE
+#define PARAM_SLOTS                         3       //image slots : save_addr, save_addr_bak, spare_addr
+#endif
+
+#if defined(PARAM_USING_PRE_ERASE) || defined(PARAM_USING_DUAL)
 typedef struct
 {
-    char *name;
-    char *defval;
-    u8  type;
-    u8  size;
-}param_msg_t;
+    u32 seq;            //sequence of image, the newest is loaded first
+    u16 magic;          //PARAM_MAGIC_SLOT
+    u16 crc16;
+}param_slot_tag_t;      //written after the image at the end of the sector
 
-#define PARAM_BEGIN()   static const param_msg_t param_msg_table[] = {
-#define PARAM_END()     };
+#define PARAM_IMAGE_MAX                     (PARAM_SECTOR_SIZE - sizeof(param_slot_tag_t))
+#else
+#define PARAM_IMAGE_MAX                     PARAM_SECTOR_SIZE
+#endif
 
-#define PARAM_STRING(name, size, defval)    {#name, #defval,    PTYPE_STR,      size+1},
-#define PARAM_ARRAY(name, size, defval)     {#name, #defval,    PTYPE_ARRAY,    size},
-#define PARAM_INT(name, defval)             {#name, #defval,    PTYPE_INT,      sizeof(u32)},
-#define PARAM_INT64(name, defval)           {#name, #defval,    PTYPE_INT,      sizeof(u64)},
-#define PARAM_HEX(name, defval)             {#name, #defval,    PTYPE_HEX,      sizeof(u32)},
-#define PARAM_HEX64(name, defval)           {#name, #defval,    PTYPE_HEX,      sizeof(u64)},
-#define PARAM_FLOAT(name, defval)           {#name, #defval,    PTYPE_FLOAT,    sizeof(f32)},
-#define PARAM_DOUBLE(name, defval)          {#name, #defval,    PTYPE_FLOAT,    sizeof(f64)},
+#ifdef PARAM_USING_PRESET
+#define PARAM_SEL_SECTORS                   2       //selector sectors, a new sector is erased while the other keeps the last record
+#endif
 
-#define PARAM_TABLE_DEF
-#include <param_def.h>
+//the main table, used by all param_xxx functions
+#define PARAM_TABLE_NAME                    main
+#define PARAM_TABLE_FILE                    <param_def.h>
+#define PARAM_TABLE_SAVE_ADDR               PARAM_SAVE_ADDR
+#define PARAM_TABLE_SAVE_ADDR_BAK           PARAM_SAVE_ADDR_BAK
+#define PARAM_TABLE_SPARE_ADDR              PARAM_SPARE_ADDR
+#define PARAM_TABLE_JOURNAL_ADDR            PARAM_JOURNAL_ADDR
+#define PARAM_TABLE_DYN_ADDR                PARAM_DYN_ADDR
+#define PARAM_TABLE_DYN_ADDR_BAK            PARAM_DYN_ADDR_BAK
+#define PARAM_TABLE_PRESET_ADDR             PARAM_PRESET_ADDR
+#include <param_table.h>
 
-#define PARAM_TOTAL                         (sizeof(param_msg_table)/sizeof(param_msg_table[0]))
+static rt_slist_t param_tbl_list = RT_SLIST_OBJECT_INIT(param_tbl_list);
 
-static fal_partition_t part = NULL;
-static rt_mutex_t param_mutex = NULL;
-static u8 *param_datas = NULL;
-static u16 param_size;
-static param_head_t param_head;
-static u16 param_offset_table[PARAM_TOTAL];
+#ifdef PARAM_USING_EXT_IMAGE
+#ifndef PARAM_WRITE_BUF_SIZE
+#define PARAM_WRITE_BUF_SIZE                PARAM_PROG_STEP //staging buffer of image writer, flushed at step boundaries
+#endif
 
-#ifdef PARAM_USING_AUTO_SAVE
-static rt_timer_t param_auto_save_timer = NULL;
+#if (PARAM_WRITE_BUF_SIZE & (PARAM_WRITE_BUF_SIZE - 1)) != 0
+#error "PARAM_WRITE_BUF_SIZE must be a power of 2"
+#endif
+
+#define PARAM_RLE_LIT_MAX                   128     //max literal bytes of one rle block
+#define PARAM_RLE_RUN_MIN                   3       //min repeat bytes worth a rle run block
+#define PARAM_RLE_RUN_MAX                   (0x7F + PARAM_RLE_RUN_MIN)
+
+typedef struct
+{
+    param_tbl_t *tbl;   //table whose partition is written to
+    u32 addr;           //flash address of the next flush
+    u16 size;           //total bytes put, before compression
+    u16 out;            //total bytes output to flash
+    u16 crc16;          //crc of all bytes put
+    u8  comp;           //compression type
+    int len;            //bytes pending in buffer
+    int rst;            //first flash write error
+    u8  buf[PARAM_WRITE_BUF_SIZE];
+    #ifdef PARAM_USING_COMPRESS
+    u8  run_byte;       //byte of current run
+    int run_len;        //length of current run
+    int lit_len;        //bytes pending in literal buffer
+    u8  lit[PARAM_RLE_LIT_MAX];
+    #endif
+}param_writer_t;
+
+typedef struct
+{
+    param_tbl_t *tbl;   //table whose storage is read
+    u32 addr;           //flash address of the next read
+    int remain;         //bytes not yet filled, after decompression
+    u16 crc16;          //crc of all bytes filled
+    u8  comp;           //compression type
+    int len;            //bytes in buffer
+    int pos;            //read position in buffer
+    int rst;            //first flash read error
+    u8  buf[PARAM_WRITE_BUF_SIZE];
+    #ifdef PARAM_USING_COMPRESS
+    int zremain;        //compressed bytes not yet read from flash
+    int zlen;           //compressed bytes in buffer
+    int zpos;           //read position in compressed buffer
+    int lit;            //literal bytes left in current rle block
+    int rep;            //repeat bytes left in current rle block
+    u8  rep_byte;       //byte of current repeat block
+    u8  zbuf[PARAM_WRITE_BUF_SIZE];
+    #endif
+}param_reader_t;
+#endif
+
+#ifdef PARAM_USING_JOURNAL
+#define PARAM_JOURNAL_ALIGN                 4       //records are aligned in journal sector
+#define PARAM_JOURNAL_EMPTY                 0xFFFF  //index of erased space
+#define PARAM_JOURNAL_SEL                   0xFFFE  //index of the selector sequence a snapshot of preset switch waits for
+
+typedef struct
+{
+    u16 magic;          //PARAM_MAGIC_JOURNAL
+    u16 crc16;          //crc of seq
+    u32 seq;            //sector sequence, the biggest is the newest
+}param_jnl_head_t;
+
+typedef struct
+{
+    u16 idx;            //parameter index
+    u16 len;            //value length
+    u16 crc16;          //crc of index, length and value
+}param_jnl_rec_t;
+#endif
+
+#ifdef PARAM_USING_DYNAMIC
+#define PARAM_DYN_ALIGN                     4       //records are aligned in arena
+#define PARAM_DYN_LIVE                      0x5A    //flag of live record
+#define PARAM_DYN_DELETED                   0x00    //flag of deleted record
+#define PARAM_DYN_SLOT_EMPTY                0       //hash index slot never used
+#define PARAM_DYN_SLOT_DELETED              0xFFFF  //hash index slot of deleted record
+#define PARAM_DYN_REC(tbl, slot)            ((param_dyn_rec_t *)((tbl)->dyn_arena + ((slot) - 1) * PARAM_DYN_ALIGN))
+
+typedef struct
+{
+    u16 magic;          //PARAM_MAGIC_DYN
+    u16 count;          //dynamic params total
+    u32 size;           //bytes of records
+    u16 crc16;          //crc of records
+    u16 head_crc16;
+}param_dyn_head_t;
+
+typedef struct
+{
+    u16 vlen;           //value length
+    u8  klen;           //name length, the name and its terminator follow, then the value
+    u8  flag;           //PARAM_DYN_LIVE or PARAM_DYN_DELETED
+}param_dyn_rec_t;
+#endif
+
+#ifdef PARAM_USING_XIP
+#define PARAM_XIP_ALIGN                     4       //shadows are aligned in pool
+
+typedef struct
+{
+    u16 idx;            //parameter index, the value follows
+    u16 resv;
+}param_shadow_t;
+#endif
+
+#ifdef PARAM_USING_EXPORT
+#define PARAM_EXPORT_REC_SIZE               3       //index and length before value of sparse export
+#define PARAM_DELTA_HEAD_SIZE               8       //epoch and generation before records of delta export
+
+typedef struct
+{
+    u16 magic;          //PARAM_MAGIC_EXPORT
+    u8  version;        //PARAM_EXPORT_VERSION
+    u8  flags;          //0 - all params, PARAM_EXPORT_SPARSE - records of non-default params, with PARAM_EXPORT_DELTA - of changed params
+    u16 total;          //params total of table
+    u16 layout;         //crc of types and sizes of all params
+    u16 size;           //data size
+    u16 crc16;          //crc of data
+    u16 head_crc16;
+}param_export_head_t;
+#endif
+
+#ifdef PARAM_USING_MIGRATE
+#define PARAM_DIR_ENTRY_SIZE                6       //name hash, type, size, offsets follow the order of entries
+#define PARAM_DIR_SIZE(total)               (sizeof(u16) + (total) * PARAM_DIR_ENTRY_SIZE)
+#define PARAM_MIG_NONE                      0xFFFF  //saved param is removed from table
+#endif
+
+#if defined(PARAM_USING_MIGRATE) || defined(PARAM_USING_TEXT_IMPORT)
+#define PARAM_NAME_SLOT_EMPTY               0xFFFF  //index of empty slot
+
+typedef struct
+{
+    u32 hash;           //name hash of param
+    u16 idx;            //param index, PARAM_NAME_SLOT_EMPTY - empty slot
+    u16 resv;
+}param_name_slot_t;
+#endif
+
+#if defined(PARAM_USING_EXPORT) || defined(PARAM_USING_TEXT_IMPORT)
+typedef struct
+{
+    u8  apply;          //0 - only count the shadows needed, 1 - store values
+    int need;           //bytes of shadows needed by the batch, with PARAM_USING_XIP
+    int fails;          //values not stored
+}param_batch_t;
 #endif
 
-static void param_size_init(void)
+#if defined(PARAM_USING_OVERLAY) || defined(PARAM_USING_XIP)
+#define PARAM_MAP_SIZE(tbl)                 (((tbl)->total + 7) / 8)
+#endif
+
+#ifdef PARAM_USING_COMPACT
+//definitions are in string pool, offsets and size are computed at compile time
+#define PARAM_MSG_NAME(tbl, idx)            ((tbl)->pool + (tbl)->msgs[idx].name)
+#define PARAM_MSG_DEFVAL(tbl, idx)          ((tbl)->pool + (tbl)->msgs[idx].defval)
+#else
+#define PARAM_MSG_NAME(tbl, idx)            ((tbl)->msgs[idx].name)
+#define PARAM_MSG_DEFVAL(tbl, idx)          ((tbl)->msgs[idx].defval)
+#endif
+
+#ifdef PARAM_USING_COMPACT
+static int param_datas_init(param_tbl_t *tbl)//datas are allocated statically by param_table.h
+{
+    return(RT_EOK);
+}
+
+static void param_datas_deinit(param_tbl_t *tbl)
 {
+}
+#else
+static void param_size_init(param_tbl_t *tbl)
+{
+    u16 *offsets = (u16 *)tbl->offsets;//offsets are in RAM when not compact
     int size = 0;
 
-    for (int i = 0; i < PARAM_TOTAL; i++)
+    for (int i = 0; i < tbl->total; i++)
     {
-        param_offset_table[i] = size;
-        size += param_msg_table[i].size;
+        offsets[i] = size;
+        size += tbl->msgs[i].size;
     }
 
-    param_size = size;
+    tbl->size = size;
 }
 
-static int param_datas_init(void)
+#ifdef PARAM_USING_XIP
+static int param_datas_init(param_tbl_t *tbl)//params are read from mapped flash, only the shadow pool is allocated
 {
-    param_size_init();
+    param_size_init(tbl);
     
-    if ((param_size > 0) && (param_datas == NULL))
+    if (tbl->xip_shadow == NULL)
     {
-        param_datas = malloc(param_size);
+        tbl->xip_shadow = malloc(PARAM_XIP_SHADOW_SIZE);
     }
+    tbl->xip_base = NULL;
+    tbl->xip_used = 0;
     
-    return ((param_datas != NULL) ? RT_EOK : -RT_ENOMEM);
+    return ((tbl->xip_shadow != NULL) ? RT_EOK : -RT_ENOMEM);
 }
 
-static void param_datas_deinit(void)
+static void param_datas_deinit(param_tbl_t *tbl)
 {
-    if (param_datas != NULL)
+    if (tbl->xip_shadow != NULL)
     {
-        free(param_datas);
-        param_datas = NULL;
+        free(tbl->xip_shadow);
+        tbl->xip_shadow = NULL;
     }
+    tbl->xip_base = NULL;
 }
-
-static int param_mutex_init(void)
+#else
+static int param_datas_init(param_tbl_t *tbl)
 {
-    if (param_mutex == NULL)
+    param_size_init(tbl);
+    
+    if ((tbl->size > 0) && (tbl->datas == NULL))
+    {
+        tbl->datas = malloc(tbl->size);
+    }
+    
+    #ifdef PARAM_USING_OVERLAY
+    if ((tbl->size > 0) && (tbl->defaults == NULL))
+    {
+        tbl->defaults = malloc(tbl->size);
+    }
+    
+    if (tbl->defaults == NULL)
     {
-        param_mutex = PARAM_MUTEX_CREATE();
+        return(-RT_ENOMEM);
     }
+    #endif
     
-    return ((param_mutex != NULL) ? RT_EOK : -RT_ENOMEM);
+    return ((tbl->datas != NULL) ? RT_EOK : -RT_ENOMEM);
 }
 
-static void param_mutex_deinit(void)
+static void param_datas_deinit(param_tbl_t *tbl)
 {
-    if (param_mutex != NULL)
+    if (tbl->datas != NULL)
+    {
+        free(tbl->datas);
+        tbl->datas = NULL;
+    }
+    
+    #ifdef PARAM_USING_OVERLAY
+    if (tbl->defaults != NULL)
     {
-        PARAM_MUTEX_DELETE(param_mutex);
-        param_mutex = NULL;
+        free(tbl->defaults);
+        tbl->defaults = NULL;
     }
+    #endif
 }
+#endif
+#endif
 
-static void param_mutex_take(void)
+static int param_mutex_init(param_tbl_t *tbl)
 {
-    PARAM_MUTEX_TAKE(param_mutex);
+    if (tbl->mutex == NULL)
+    {
+        tbl->mutex = PARAM_MUTEX_CREATE();
+    }
+    
+    return ((tbl->mutex != NULL) ? RT_EOK : -RT_ENOMEM);
 }
 
-static void param_mutex_release(void)
+static void param_mutex_deinit(param_tbl_t *tbl)
 {
-    PARAM_MUTEX_RELEASE(param_mutex);
+    if (tbl->mutex != NULL)
+    {
+        PARAM_MUTEX_DELETE(tbl->mutex);
+        tbl->mutex = NULL;
+    }
 }
 
-static int param_part_init(void)
+#if defined(PARAM_USING_DUAL) && (PARAM_DUAL_THREAD_PRIORITY > 0)
+static param_tbl_t *param_dual_tbl;         //table of the request, NULL when the thread is idle
+#ifdef PARAM_USING_STATS
+static param_stats_t param_dual_stats;      //flash counters of the thread, added to the table when the copy is written
+#endif
+#ifdef PARAM_USING_PACED_WRITE
+static u32 param_dual_write_us;             //flash time of the thread since its last yield
+#endif
+#define PARAM_IO_DUAL(tbl, addr)            (((addr) & PARAM_ADDR_BAK) && (param_dual_tbl == (tbl)))//operation of the thread
+#endif
+
+#ifdef PARAM_USING_STATS
+static void param_stat_hist(u32 *hist, u32 *max_us, u32 us)
 {
-    if (part == NULL)
+    int n = 0;
+    
+    while ((n < PARAM_STATS_HIST - 1) && (us >= (1000u << n)))
     {
-        part = (fal_partition_t)PARAM_FLASH_FIND(PARAM_PART_NAME);
+        n++;
+    }
+    hist[n]++;
+    if (us > *max_us)
+    {
+        *max_us = us;
     }
-    
-    return ((part != NULL) ? RT_EOK : -RT_ENOMEM);
 }
 
-#ifdef PARAM_USING_AUTO_SAVE
-static int param_auto_save_timer_init(void)
+static int param_stat_region(param_tbl_t *tbl, u32 addr)
 {
-    if (param_auto_save_timer == NULL)
+    #ifdef PARAM_USING_DUAL
+    if (addr & PARAM_ADDR_BAK)
     {
-        param_auto_save_timer = rt_timer_create("par_save", 
-                                                (void(*)(void*))param_save_to_flash,
-                                                NULL, 
-                                                PARAM_AUTO_SAVE_DELAY, 
-                                                (RT_TIMER_FLAG_ONE_SHOT | RT_TIMER_FLAG_SOFT_TIMER));
+        return(PSTAT_RGN_BACKUP);
     }
-    
-    return ((param_auto_save_timer != NULL) ? RT_EOK : -RT_ENOMEM);
+    if ((addr >= tbl->cfg.save_addr) && (addr < tbl->cfg.save_addr + PARAM_SECTOR_SIZE * 2))
+    {
+        return(PSTAT_RGN_IMAGE);
+    }
+    #endif
+    if ((addr >= tbl->cfg.save_addr) && (addr < tbl->cfg.save_addr + PARAM_SECTOR_SIZE))
+    {
+        return(PSTAT_RGN_IMAGE);
+    }
+    if ((addr >= tbl->cfg.save_addr_bak) && (addr < tbl->cfg.save_addr_bak + PARAM_SECTOR_SIZE))
+    {
+        return(PSTAT_RGN_BACKUP);
+    }
+    if ((addr >= tbl->cfg.journal_addr) && (addr < tbl->cfg.journal_addr + tbl->cfg.journal_sectors * PARAM_SECTOR_SIZE))
+    {
+        return(PSTAT_RGN_JOURNAL);
+    }
+    #ifdef PARAM_USING_PRE_ERASE
+    if ((addr >= tbl->cfg.spare_addr) && (addr < tbl->cfg.spare_addr + PARAM_SECTOR_SIZE))
+    {
+        return(PSTAT_RGN_SPARE);
+    }
+    #endif
+    #ifdef PARAM_USING_PRESET
+    if ((addr >= tbl->cfg.preset_addr) && (addr < tbl->cfg.preset_addr + (PARAM_SEL_SECTORS + tbl->cfg.preset_total) * PARAM_SECTOR_SIZE))
+    {
+        return(PSTAT_RGN_PRESET);
+    }
+    #endif
+    return(PSTAT_RGN_DYNAMIC);
 }
 
-static void param_auto_save_timer_deinit(void)
+static param_stats_t *param_io_stats(param_tbl_t *tbl, u32 addr)//counters of a flash operation
 {
-    if (param_auto_save_timer != NULL)
+    #if defined(PARAM_USING_DUAL) && (PARAM_DUAL_THREAD_PRIORITY > 0)
+    if (PARAM_IO_DUAL(tbl, addr))
     {
-        rt_timer_delete(param_auto_save_timer);
-        param_auto_save_timer = NULL;
+        return(&param_dual_stats);
     }
+    #endif
+    return(&tbl->stats);
 }
 
-static void param_auto_save_start(void)
+static void param_stat_sector(param_stats_t *st, u32 sector, u32 erases)
 {
-    rt_timer_start(param_auto_save_timer);
+    for (int i = 0; i < PARAM_STATS_SECTORS; i++)
+    {
+        if ((st->sectors[i].erases == 0) || (st->sectors[i].addr == sector))//the first free slot or the sector
+        {
+            st->sectors[i].addr = sector;
+            st->sectors[i].erases += erases;
+            break;
+        }
+    }
 }
 
-static void param_auto_save_stop(void)
+static void param_stat_erase(param_tbl_t *tbl, u32 addr, u32 size)
 {
-    rt_timer_stop(param_auto_save_timer);
+    param_stats_t *st = param_io_stats(tbl, addr);
+    
+    st->erase_bytes[param_stat_region(tbl, addr)] += size;
+    for (u32 sector = addr - addr % PARAM_SECTOR_SIZE; sector < addr + size; sector += PARAM_SECTOR_SIZE)
+    {
+        param_stat_sector(st, sector, 1);
+    }
 }
 #endif
 
-static void param_head_update(void)
+static void param_mutex_take(param_tbl_t *tbl)
 {
-    param_head.magic = PARAM_MAGIC_WORD;
-    param_head.size = param_size;
-    param_head.crc16 = PARAM_CRC16_CAL((u8*)param_datas, param_size);
-    param_head.head_crc16 = PARAM_CRC16_CAL((u8*)&param_head, sizeof(param_head)-2);
+    #ifdef PARAM_USING_STATS
+    if (PARAM_MUTEX_TRY(tbl->mutex) != RT_EOK)//only a contended take is timed
+    {
+        u32 us = PARAM_STATS_TIME_US();
+        PARAM_MUTEX_TAKE(tbl->mutex);
+        us = PARAM_STATS_TIME_US() - us;
+        tbl->stats.lock_waits++;
+        tbl->stats.lock_wait_us += us;
+        if (us > tbl->stats.lock_wait_max_us)
+        {
+            tbl->stats.lock_wait_max_us = us;
+        }
+    }
+    tbl->stats.locks++;
+    #else
+    PARAM_MUTEX_TAKE(tbl->mutex);
+    #endif
+}
+
+static void param_mutex_release(param_tbl_t *tbl)
+{
+    PARAM_MUTEX_RELEASE(tbl->mutex);
 }
 
-static int param_head_check(void)
+#ifdef PARAM_USING_PACED_WRITE
+static void param_write_pace(param_tbl_t *tbl, u32 addr, u32 us)//us - flash time of last operation at addr, yields when the budget is used up
 {
-    if (param_head.magic != PARAM_MAGIC_WORD)
+    u32 *write_us = &tbl->write_us;
+    #ifdef PARAM_USING_STATS
+    param_stats_t *st = param_io_stats(tbl, addr);
+    #endif
+    
+    #if defined(PARAM_USING_DUAL) && (PARAM_DUAL_THREAD_PRIORITY > 0)
+    if (PARAM_IO_DUAL(tbl, addr))//the thread has its own budget
     {
-        return(-RT_ERROR);
+        write_us = &param_dual_write_us;
     }
-    if (PARAM_CRC16_CAL((u8*)&param_head, sizeof(param_head)-2) != param_head.head_crc16)
+    #endif
+    *write_us += us;
+    #ifdef PARAM_USING_STATS
+    if (*write_us > st->write_step_max_us)
     {
-        return(-RT_ERROR);
+        st->write_step_max_us = *write_us;
     }
-    return(RT_EOK);
+    #endif
+    if (*write_us < PARAM_WRITE_BUDGET_US)
+    {
+        return;
+    }
+    #ifdef PARAM_USING_STATS
+    st->write_yields++;
+    #endif
+    PARAM_WRITE_YIELD();
+    *write_us = 0;
+}
+#endif
+
+#ifdef PARAM_USING_BACKEND
+static void *param_fal_open(const char *name)
+{
+    return((void *)PARAM_FLASH_FIND(name));
+}
+
+static void param_fal_close(void *dev)
+{
+}
+
+static int param_fal_read(void *dev, u32 addr, u8 *buf, u32 size)
+{
+    return(PARAM_FLASH_READ((const struct fal_partition *)dev, addr, buf, size));
+}
+
+static int param_fal_write(void *dev, u32 addr, const u8 *buf, u32 size)
+{
+    return(PARAM_FLASH_WRITE((const struct fal_partition *)dev, addr, buf, size));
 }
 
-static int param_check(void)
+static int param_fal_erase(void *dev, u32 addr, u32 size)
 {
-    if (PARAM_CRC16_CAL(param_datas, param_head.size) != param_head.crc16)
+    return(PARAM_FLASH_ERASE((const struct fal_partition *)dev, addr, size));
+}
+
+static const u8 *param_fal_map(void *dev, u32 addr)
+{
+    const struct fal_partition *part = (const struct fal_partition *)dev;
+    const struct fal_flash_dev *flash = PARAM_FLASH_DEV_FIND(part->flash_name);
+    
+    if (flash == NULL)
     {
-        return(-RT_ERROR);
+        return(NULL);
     }
-    return(RT_EOK);
+    return((const u8 *)(rt_ubase_t)(flash->addr + part->offset + addr));
 }
 
-static int param_write_to_addr(u32 addr)
+const param_backend_t param_backend_fal = {
+    .name = "fal",
+    .erase_size = PARAM_SECTOR_SIZE,
+    .write_size = 1,
+    .in_place = 0,
+    .open = param_fal_open,
+    .close = param_fal_close,
+    .read = param_fal_read,
+    .write = param_fal_write,
+    .erase = param_fal_erase,
+    .map = param_fal_map,
+};
+
+static u8 *param_ram_storage = NULL;//allocated by the first open, kept until reset, so tables may be loaded again
+
+static void *param_ram_open(const char *name)
 {
-    if (PARAM_FLASH_ERASE(part, addr, PARAM_SECTOR_SIZE) < 0)
+    if (param_ram_storage == NULL)
     {
-        LOG_E("param sector erease fail. addr : %d", addr);
-        return(-RT_ERROR);
+        param_ram_storage = malloc(PARAM_RAM_SIZE);
+        if (param_ram_storage != NULL)
+        {
+            memset(param_ram_storage, 0xFF, PARAM_RAM_SIZE);
+        }
     }
-    if (PARAM_FLASH_WRITE(part, addr, (u8*)&param_head, sizeof(param_head)) < 0)
+    return(param_ram_storage);
+}
+
+static void param_ram_close(void *dev)
+{
+}
+
+static int param_ram_read(void *dev, u32 addr, u8 *buf, u32 size)
+{
+    if ((addr > PARAM_RAM_SIZE) || (size > PARAM_RAM_SIZE - addr))
     {
-        LOG_E("param head write fail. addr : %d", addr);
         return(-RT_ERROR);
     }
-    if (PARAM_FLASH_WRITE(part, addr+sizeof(param_head), (u8*)param_datas, param_size) < 0)
+    memcpy(buf, (u8 *)dev + addr, size);
+    return(size);
+}
+
+static int param_ram_write(void *dev, u32 addr, const u8 *buf, u32 size)
+{
+    if ((addr > PARAM_RAM_SIZE) || (size > PARAM_RAM_SIZE - addr))
     {
-        LOG_E("param write fail. addr : %d", addr);
         return(-RT_ERROR);
     }
-    LOG_D("param write success. addr : %d", addr);
-    return(RT_EOK);
+    memcpy((u8 *)dev + addr, buf, size);
+    return(size);
 }
 
-static int param_read_from_addr(u32 addr)
+static int param_ram_erase(void *dev, u32 addr, u32 size)
 {
-    if (PARAM_FLASH_READ(part, addr, (u8*)&param_head, sizeof(param_head)) < 0)
+    if ((addr > PARAM_RAM_SIZE) || (size > PARAM_RAM_SIZE - addr))
     {
-        LOG_E("param head read fail. addr : %d", addr);
         return(-RT_ERROR);
     }
-    if (param_head_check() < 0)
+    memset((u8 *)dev + addr, 0xFF, size);
+    return(size);
+}
+
+static const u8 *param_ram_map(void *dev, u32 addr)
+{
+    return((const u8 *)dev + addr);
+}
+
+const param_backend_t param_backend_ram = {
+    .name = "ram",
+    .erase_size = 0,
+    .write_size = 1,
+    .in_place = 1,
+    .open = param_ram_open,
+    .close = param_ram_close,
+    .read = param_ram_read,
+    .write = param_ram_write,
+    .erase = param_ram_erase,
+    .map = param_ram_map,
+};
+
+#ifdef RT_USING_DFS
+#ifndef O_SYNC
+#define O_SYNC      0
+#endif
+
+//handle is fd + 1, so a failed open is NULL
+#define PARAM_FILE_FD(dev)                      ((int)(rt_ubase_t)(dev) - 1)
+
+static void *param_file_open(const char *name)
+{
+    int fd = open(name, O_RDWR | O_CREAT | O_SYNC, 0644);//each write is on the media before the next, so the head is written at last
+    
+    return((fd >= 0) ? (void *)(rt_ubase_t)(fd + 1) : NULL);
+}
+
+static void param_file_close(void *dev)
+{
+    close(PARAM_FILE_FD(dev));
+}
+
+static int param_file_read(void *dev, u32 addr, u8 *buf, u32 size)
+{
+    int len;
+    
+    if (lseek(PARAM_FILE_FD(dev), addr, SEEK_SET) < 0)
     {
-        LOG_E("param head check fail. addr : %d", addr);
         return(-RT_ERROR);
     }
-    if (param_head.size > param_size)
+    len = read(PARAM_FILE_FD(dev), buf, size);
+    if (len < 0)
     {
-        LOG_E("param size check fail. addr : %d", addr);
         return(-RT_ERROR);
     }
-    if (PARAM_FLASH_READ(part, addr+sizeof(param_head), (u8*)param_datas, param_head.size) < 0)
+    memset(buf + len, 0xFF, size - len);//bytes beyond the end of file read as erased
+    return(size);
+}
+
+static int param_file_write(void *dev, u32 addr, const u8 *buf, u32 size)
+{
+    int len;
+    
+    if (lseek(PARAM_FILE_FD(dev), addr, SEEK_SET) < 0)
     {
-        LOG_E("param read fail. addr : %d", addr);
         return(-RT_ERROR);
     }
-    if (param_check() < 0)
+    len = write(PARAM_FILE_FD(dev), buf, size);
+    return((len == (int)size) ? len : -RT_ERROR);
+}
+
+static int param_file_erase(void *dev, u32 addr, u32 size)
+{
+    u8 buf[PARAM_PROG_STEP];
+    
+    memset(buf, 0xFF, sizeof(buf));
+    for (u32 pos = 0; pos < size; pos += sizeof(buf))
     {
-        LOG_E("param check fail. addr : %d", addr);
-        return(-RT_ERROR);
+        u32 len = (size - pos < sizeof(buf)) ? (size - pos) : sizeof(buf);
+        if (param_file_write(dev, addr + pos, buf, len) < 0)
+        {
+            return(-RT_ERROR);
+        }
     }
-    LOG_D("param read success. addr : %d", addr);
-    return(RT_EOK);
+    return(size);
 }
 
-static param_type_t param_get_type(int idx)
+const param_backend_t param_backend_file = {
+    .name = "file",
+    .erase_size = 0,
+    .write_size = 1,
+    .in_place = 1,
+    .open = param_file_open,
+    .close = param_file_close,
+    .read = param_file_read,
+    .write = param_file_write,
+    .erase = param_file_erase,
+    .map = NULL,
+};
+#endif
+
+#ifdef RT_USING_DEVICE
+static void *param_eeprom_open(const char *name)
 {
-    return(param_msg_table[idx].type);
+    rt_device_t dev = rt_device_find(name);
+    
+    if ((dev == RT_NULL) || (rt_device_open(dev, RT_DEVICE_OFLAG_RDWR) != RT_EOK))
+    {
+        return(NULL);
+    }
+    return(dev);
 }
 
-static int param_get_size(int idx)
+static void param_eeprom_close(void *dev)
 {
-    return(param_msg_table[idx].size);
+    rt_device_close((rt_device_t)dev);
 }
 
-static int param_find_by_name(const char *name)
+static int param_eeprom_read(void *dev, u32 addr, u8 *buf, u32 size)
 {
-    for (int i=0; i<PARAM_TOTAL; i++)
-    {
-        if (strcmp(param_msg_table[i].name, name) == 0)
-        {
-            return(i);
-        }
-    }
-    return(-1);
+    return((rt_device_read((rt_device_t)dev, addr, buf, size) == size) ? (int)size : -RT_ERROR);
 }
 
-static int param_input_value(void *buf, int type, int size, const char *input_str)
+static int param_eeprom_write(void *dev, u32 addr, const u8 *buf, u32 size)
 {
-    switch(type)
+    return((rt_device_write((rt_device_t)dev, addr, buf, size) == size) ? (int)size : -RT_ERROR);
+}
+
+static int param_eeprom_erase(void *dev, u32 addr, u32 size)//only journal and slot tags need erased bytes, images never erase
+{
+    u8 buf[PARAM_EEPROM_PAGE_SIZE];
+    
+    memset(buf, 0xFF, sizeof(buf));
+    for (u32 pos = 0; pos < size; pos += sizeof(buf))
     {
-    case PTYPE_STR:
-        strncpy(buf, input_str, size-1);
-        break;
-    case PTYPE_ARRAY:
-        {
-            u8 *pbyte = buf;
-            char *p = (char *)input_str;
-            char *pn = NULL;
-            while(1)
-            {
-                *pbyte++ = strtol(p, &pn, 16);
-                if (*pn == 0) break;
-                p = pn+1;
-            }
-        }
-        break;
-    case PTYPE_INT:
+        u32 len = (size - pos < sizeof(buf)) ? (size - pos) : sizeof(buf);
+        if (param_eeprom_write(dev, addr + pos, buf, len) < 0)
         {
-            s64 lval = strtoll(input_str, NULL, 0);
-            memcpy(buf, (u8 *)&lval, size);
+            return(-RT_ERROR);
         }
-        break;
-    case PTYPE_HEX:
+    }
+    return(size);
+}
+
+const param_backend_t param_backend_eeprom = {
+    .name = "eeprom",
+    .erase_size = 0,
+    .write_size = PARAM_EEPROM_PAGE_SIZE,
+    .in_place = 1,
+    .open = param_eeprom_open,
+    .close = param_eeprom_close,
+    .read = param_eeprom_read,
+    .write = param_eeprom_write,
+    .erase = param_eeprom_erase,
+    .map = NULL,
+};
+#endif
+#endif
+
+static param_storage_t param_flash_storage(param_tbl_t *tbl, u32 *addr)//storage of the address, the flag of backup copy is removed
+{
+    #ifdef PARAM_USING_DUAL
+    if (*addr & PARAM_ADDR_BAK)
+    {
+        *addr &= ~PARAM_ADDR_BAK;
+        return(PARAM_TBL_STORAGE_BAK(tbl));
+    }
+    #endif
+    return(PARAM_TBL_STORAGE(tbl));
+}
+
+static int param_flash_read(param_tbl_t *tbl, u32 addr, u8 *buf, u32 size)
+{
+    param_storage_t dev = param_flash_storage(tbl, &addr);
+    
+    #ifdef PARAM_USING_BACKEND
+    return(tbl->cfg.backend->read(dev, addr, buf, size));
+    #else
+    return(PARAM_FLASH_READ(dev, addr, buf, size));
+    #endif
+}
+
+static int param_flash_erase(param_tbl_t *tbl, u32 addr, u32 size)
+{
+    int rst;
+    u32 pos = addr;
+    param_storage_t dev = param_flash_storage(tbl, &pos);
+    #ifdef PARAM_USING_PACED_WRITE
+    u32 us = PARAM_STATS_TIME_US();
+    #endif
+    
+    #ifdef PARAM_USING_BACKEND
+    rst = tbl->cfg.backend->erase(dev, pos, size);
+    #else
+    rst = PARAM_FLASH_ERASE(dev, pos, size);
+    #endif
+    #ifdef PARAM_USING_STATS
+    if (rst >= 0)
+    {
+        param_stat_erase(tbl, addr, size);
+    }
+    #endif
+    #ifdef PARAM_USING_PACED_WRITE
+    param_write_pace(tbl, addr, PARAM_STATS_TIME_US() - us);
+    #endif
+    return(rst);
+}
+
+#ifdef PARAM_USING_BACKEND
+static int param_backend_write(param_tbl_t *tbl, void *dev, u32 addr, const u8 *buf, u32 size)//split at write pages of backend
+{
+    u32 page = tbl->cfg.backend->write_size;
+    
+    while (size > 0)
+    {
+        u32 len = (page > 1) ? (page - (addr % page)) : size;
+        if (len > size)
         {
-            u64 lval = strtoll(input_str, NULL, 16);
-            memcpy(buf, (u8 *)&lval, size);
+            len = size;
         }
-        break;
-    case PTYPE_FLOAT:
+        if (tbl->cfg.backend->write(dev, addr, buf, len) < 0)
         {
-            if (size == sizeof(f32))
-            {
-                f32 fval = atof(input_str);
-                memcpy(buf, (u8 *)&fval, size);
-            }
-            else
-            {
-                f64 fval = atof(input_str);
-                memcpy(buf, (u8 *)&fval, size);
-            }
+            return(-RT_ERROR);
         }
-        break;
-    default:
-        return(0);
+        addr += len;
+        buf += len;
+        size -= len;
     }
+    return(RT_EOK);
+}
+#endif
+
+static int param_flash_write(param_tbl_t *tbl, u32 addr, const u8 *buf, u32 size)
+{
+    int rst;
+    u32 pos = addr;
+    param_storage_t dev = param_flash_storage(tbl, &pos);
+    #ifdef PARAM_USING_PACED_WRITE
+    u32 us = PARAM_STATS_TIME_US();
+    #endif
     
-    return(size);
+    #ifdef PARAM_USING_BACKEND
+    rst = param_backend_write(tbl, dev, pos, buf, size);
+    #else
+    rst = PARAM_FLASH_WRITE(dev, pos, buf, size);
+    #endif
+    #ifdef PARAM_USING_STATS
+    param_io_stats(tbl, addr)->prog_bytes[param_stat_region(tbl, addr)] += (rst >= 0) ? size : 0;
+    #endif
+    #ifdef PARAM_USING_PACED_WRITE
+    param_write_pace(tbl, addr, PARAM_STATS_TIME_US() - us);
+    #endif
+    return(rst);
 }
 
-static int _param_resume_all(void)
+#ifdef PARAM_USING_BACKEND
+static int param_flash_update(param_tbl_t *tbl, u32 addr, const u8 *buf, u32 len)//in place, only the changed bytes of a step are written
 {
-    if (param_datas == NULL || param_mutex == NULL)
+    u8 old[PARAM_PROG_STEP];
+    u32 first = 0, last = len;
+    
+    if (param_flash_read(tbl, addr, old, len) < 0)
     {
-        LOG_E("param resume all fail. param no initialized.");
         return(-RT_ERROR);
     }
-    
-    param_mutex_take();
-    memset(param_datas, 0, param_size);
-    for (int i = 0; i < PARAM_TOTAL; i++)
+    while ((first < len) && (old[first] == buf[first]))
     {
-        int type = param_msg_table[i].type;
-        int size = param_msg_table[i].size;
-        char *str = param_msg_table[i].defval;
-        u8 *paddr = param_datas + param_offset_table[i];
-
-        param_input_value(paddr, type, size, str);
+        first++;
+    }
+    if (first == len)
+    {
+        return(RT_EOK);
     }
-    param_mutex_release();
+    while (old[last - 1] == buf[last - 1])
+    {
+        last--;
+    }
+    return(param_flash_write(tbl, addr + first, buf + first, last - first));
+}
+#endif
 
+static int param_flash_program(param_tbl_t *tbl, u32 addr, const u8 *buf, u32 size)//in aligned steps, a step never crosses a page
+{
+    while (size > 0)
+    {
+        int rst;
+        u32 len = PARAM_PROG_STEP - (addr & (PARAM_PROG_STEP - 1));
+        if (len > size)
+        {
+            len = size;
+        }
+        #ifdef PARAM_USING_BACKEND
+        if (PARAM_TBL_IN_PLACE(tbl))
+        {
+            rst = param_flash_update(tbl, addr, buf, len);
+        }
+        else
+        #endif
+        {
+            rst = param_flash_write(tbl, addr, buf, len);
+        }
+        if (rst < 0)
+        {
+            return(-RT_ERROR);
+        }
+        addr += len;
+        buf += len;
+        size -= len;
+    }
     return(RT_EOK);
 }
 
-int param_init(void)
+static int param_part_init(param_tbl_t *tbl)
 {
-    param_deinit();
+    #ifdef PARAM_USING_BACKEND
+    u32 erase_size = tbl->cfg.backend->erase_size;
     
-    if (param_part_init() != RT_EOK)
+    if ((erase_size != 0) && ((PARAM_SECTOR_SIZE % erase_size) != 0))//a sector must be erased alone
     {
-        LOG_E("param fal partition initialize fail.");
+        LOG_E("param sector size is not a multiple of erase size %d of backend %s.", erase_size, tbl->cfg.backend->name);
         return(-RT_ERROR);
     }
-    
-    if (param_mutex_init() != RT_EOK)
+    if (tbl->dev == NULL)
     {
-        LOG_E("param mutex init error. no memory for create mutex.");
-        return(-RT_ERROR);
+        tbl->dev = tbl->cfg.backend->open(tbl->cfg.part_name);
     }
-    
-    if (param_datas_init() != RT_EOK)
+    #ifdef PARAM_USING_DUAL
+    if (tbl->dev_bak == NULL)
     {
-        param_mutex_deinit();
-        LOG_E("param datas init error. no memory for create param datas.");
-        return(-RT_ERROR);
+        tbl->dev_bak = tbl->cfg.backend->open(tbl->cfg.part_name_bak);
     }
-    
-    #ifdef PARAM_USING_AUTO_SAVE
-    if (param_auto_save_timer_init() != RT_EOK)
+    #endif
+    #else
+    if (tbl->part == NULL)
     {
-        param_mutex_deinit();
-        param_datas_deinit();
-        LOG_E("param datas init error. no memory for create param datas.");
-        return(-RT_ERROR);
+        tbl->part = PARAM_FLASH_FIND(tbl->cfg.part_name);
+    }
+    #ifdef PARAM_USING_DUAL
+    if (tbl->part_bak == NULL)
+    {
+        tbl->part_bak = PARAM_FLASH_FIND(tbl->cfg.part_name_bak);
     }
     #endif
+    #endif
     
-    _param_resume_all();
-    
-    return(RT_EOK);
+    #ifdef PARAM_USING_DUAL
+    if (PARAM_TBL_STORAGE_BAK(tbl) == NULL)
+    {
+        return(-RT_ENOMEM);
+    }
+    #endif
+    return ((PARAM_TBL_STORAGE(tbl) != NULL) ? RT_EOK : -RT_ENOMEM);
 }
 
-void param_deinit(void)
+#ifdef PARAM_USING_BACKEND
+static void param_part_deinit(param_tbl_t *tbl)
 {
-    param_mutex_deinit();
-    param_datas_deinit();
-    #ifdef PARAM_USING_AUTO_SAVE
-    param_auto_save_timer_deinit();
+    if (tbl->dev != NULL)
+    {
+        tbl->cfg.backend->close(tbl->dev);
+        tbl->dev = NULL;
+    }
+    #ifdef PARAM_USING_DUAL
+    if (tbl->dev_bak != NULL)
+    {
+        tbl->cfg.backend->close(tbl->dev_bak);
+        tbl->dev_bak = NULL;
+    }
     #endif
 }
+#endif
 
-int param_load_from_flash(void)
+#ifdef PARAM_USING_AUTO_SAVE
+static void param_auto_save_entry(void *parameter)
 {
-    int rst;
+    param_tbl_save((param_tbl_t *)parameter);
+}
+
+static int param_auto_save_timer_init(param_tbl_t *tbl)
+{
+    if (tbl->cfg.auto_save_delay == 0)//automatic save is disabled for this table
+    {
+        return(RT_EOK);
+    }
     
-    if (part == NULL || param_datas == NULL || param_mutex == NULL)
+    if (tbl->auto_save_timer == NULL)
     {
-        LOG_E("param load failed. param no initialized.");
-        return(-RT_ERROR);
+        tbl->auto_save_timer = rt_timer_create("par_save", 
+                                                param_auto_save_entry,
+                                                tbl, 
+                                                tbl->cfg.auto_save_delay, 
+                                                (RT_TIMER_FLAG_ONE_SHOT | RT_TIMER_FLAG_SOFT_TIMER));
     }
-
-    param_mutex_take();
-    rst = param_read_from_addr(PARAM_SAVE_ADDR);
-    param_mutex_release();
     
-    if (rst == RT_EOK)
+    return ((tbl->auto_save_timer != NULL) ? RT_EOK : -RT_ENOMEM);
+}
+
+static void param_auto_save_timer_deinit(param_tbl_t *tbl)
+{
+    if (tbl->auto_save_timer != NULL)
     {
-        LOG_D("param load success from flash partition.");
-        return(RT_EOK);
+        rt_timer_delete(tbl->auto_save_timer);
+        tbl->auto_save_timer = NULL;
     }
+}
+
+static void param_auto_save_start(param_tbl_t *tbl)
+{
+    rt_uint32_t state = RT_TIMER_FLAG_DEACTIVATED;
     
-    param_mutex_take();
-    rst = param_read_from_addr(PARAM_SAVE_ADDR_BAK);
-    param_mutex_release();
+    if (tbl->auto_save_timer == NULL)
+    {
+        return;
+    }
     
-    if (rst == RT_EOK)
+    //coalesce: a pending save already covers this change, do not postpone it
+    PARAM_STAT_INC(tbl, save_requests);
+    if ((rt_timer_control(tbl->auto_save_timer, RT_TIMER_CTRL_GET_STATE, &state) != RT_EOK) || (state != RT_TIMER_FLAG_ACTIVATED))
     {
-        LOG_D("param load success from flash backup partition.");
-        return(RT_EOK);
+        rt_timer_start(tbl->auto_save_timer);
     }
+    else
+    {
+        PARAM_STAT_INC(tbl, save_coalesced);
+    }
+}
 
-    LOG_E("param load failed .");
-    return(-RT_ERROR);
+static void param_auto_save_stop(param_tbl_t *tbl)
+{
+    if (tbl->auto_save_timer != NULL)
+    {
+        rt_timer_stop(tbl->auto_save_timer);
+    }
 }
+#endif
 
-int param_save_to_flash(void)
+#ifndef PARAM_USING_EXT_IMAGE
+static void param_head_update(param_tbl_t *tbl, param_head_t *head)
 {
-    int rst1, rst2;
-    
-    if (part == NULL || param_datas == NULL || param_mutex == NULL)
+    head->magic = PARAM_MAGIC_WORD;
+    head->size = tbl->size;
+    head->crc16 = PARAM_CRC16_CAL((u8*)tbl->datas, tbl->size);
+    head->head_crc16 = PARAM_CRC16_CAL((u8*)head, sizeof(param_head_t)-2);
+}
+#endif
+
+static int param_head_check(param_head_t *head)
+{
+    if (head->magic != PARAM_MAGIC_WORD)
     {
-        LOG_E("param save failed . param no initialized.");
         return(-RT_ERROR);
     }
-    
-    param_mutex_take();
-    param_head_update();
-    rst1 = param_write_to_addr(PARAM_SAVE_ADDR);
-    rst2 = param_write_to_addr(PARAM_SAVE_ADDR_BAK);
-    param_mutex_release();
-
-    #ifdef PARAM_USING_AUTO_SAVE
-    param_auto_save_stop();
-    #endif
-    
-    if ((rst1 != RT_EOK) && (rst2 != RT_EOK))
+    if (PARAM_CRC16_CAL((u8*)head, sizeof(param_head_t)-2) != head->head_crc16)
     {
-        LOG_E("param save failed . param write flash error.");
         return(-RT_ERROR);
     }
-    
     return(RT_EOK);
 }
 
-int param_resume_all(void)
+#ifndef PARAM_USING_XIP
+static int param_check(param_tbl_t *tbl, param_head_t *head)
 {
-    int rst = _param_resume_all();
-    
-    #ifdef PARAM_USING_AUTO_SAVE
-    if (rst == RT_EOK)
+    if (PARAM_CRC16_CAL(tbl->datas, head->size) != head->crc16)
     {
-        param_auto_save_start();
+        return(-RT_ERROR);
     }
-    #endif
+    return(RT_EOK);
+}
+#endif
 
-    return(rst);
+static int param_get_store(param_tbl_t *tbl, int idx)
+{
+    return(tbl->msgs[idx].store);
 }
 
-const char *param_get_name(int idx)
+#ifdef PARAM_USING_JOURNAL
+static int param_is_journal(param_tbl_t *tbl, int idx)
+{
+    return(param_get_store(tbl, idx) == PSTORE_JOURNAL);
+}
+#endif
+
+static int param_is_volatile(param_tbl_t *tbl, int idx)
+{
+    return(param_get_store(tbl, idx) == PSTORE_NONE);
+}
+
+#ifdef PARAM_USING_DELTA
+static void param_gen_stamp(param_tbl_t *tbl, int idx)//the param becomes the head of list with a new generation
 {
-    if ((u32)idx >= PARAM_TOTAL)
+    param_gen_t *g = tbl->gens;
+    
+    if (idx != tbl->gen_head)
     {
-        return(NULL);
+        g[g[idx].prev].next = g[idx].next;//not the head, so it has a previous one
+        if (g[idx].next != PARAM_GEN_NONE)
+        {
+            g[g[idx].next].prev = g[idx].prev;
+        }
+        g[idx].prev = PARAM_GEN_NONE;
+        g[idx].next = tbl->gen_head;
+        g[tbl->gen_head].prev = idx;
+        tbl->gen_head = idx;
     }
-    return(param_msg_table[idx].name);
+    g[idx].gen = ++tbl->gen;
 }
 
-int param_resume_by_index(int idx)
+static void param_gen_stamp_all(param_tbl_t *tbl)//all params may be changed, they share a new generation
 {
-    if (param_datas == NULL || param_mutex == NULL)
+    tbl->gen++;
+    for (int i = 0; i < tbl->total; i++)
     {
-        LOG_E("param resume fail by index. param no initialized.");
-        return(-RT_ERROR);
+        tbl->gens[i].gen = tbl->gen;
+        tbl->gens[i].prev = (i == 0) ? PARAM_GEN_NONE : i - 1;
+        tbl->gens[i].next = (i == tbl->total - 1) ? PARAM_GEN_NONE : i + 1;
     }
-    
-    if ((u32)idx < PARAM_TOTAL)
-    {
-        int type = param_msg_table[idx].type;
-        int size = param_msg_table[idx].size;
-        char *str = param_msg_table[idx].defval;
-        u8 *paddr = param_datas + param_offset_table[idx];
-        
-        param_mutex_take();
-        param_input_value(paddr, type, size, str);
-        param_mutex_release();
+    tbl->gen_head = 0;
+}
+#endif
 
-        #ifdef PARAM_USING_AUTO_SAVE
-        param_auto_save_start();
-        #endif
+#ifdef PARAM_USING_PRE_ERASE
+static int param_slot_save(param_tbl_t *tbl);
+#endif
+#ifdef PARAM_USING_DUAL
+static int param_dual_save(param_tbl_t *tbl);
+#endif
+#ifdef PARAM_USING_PRESET
+static int param_preset_write(param_tbl_t *tbl, int preset);
+static void param_preset_release(param_tbl_t *tbl);
+static int param_sel_scan(param_tbl_t *tbl);
+#endif
 
-        return(RT_EOK);
-    }
+#ifdef PARAM_USING_XIP
+static int param_input_value(void *buf, int type, int size, const char *input_str);
+static int param_xip_flush(param_tbl_t *tbl);
 
-    return(-RT_ERROR);
+static int param_xip_rec_size(int size)
+{
+    return(RT_ALIGN(sizeof(param_shadow_t) + size, PARAM_XIP_ALIGN));
 }
 
-int param_read_by_index(int idx, void *addr, int size)
+static int param_xip_test(param_tbl_t *tbl, int idx)
 {
-    param_type_t ptype;
-    int psize;
-    u8 *paddr;
+    return((tbl->xip_dirty[idx / 8] >> (idx % 8)) & 0x01);
+}
+
+static void param_xip_reset(param_tbl_t *tbl)//release all shadows
+{
+    tbl->xip_used = 0;
+    memset(tbl->xip_dirty, 0, PARAM_MAP_SIZE(tbl));
+}
+
+static void param_xip_release(param_tbl_t *tbl)//release shadows of saved params, volatile params keep theirs
+{
+    u32 pos = 0;
+    u32 used = 0;
     
-    if (param_datas == NULL || param_mutex == NULL)
+    memset(tbl->xip_dirty, 0, PARAM_MAP_SIZE(tbl));
+    while (pos < tbl->xip_used)
     {
-        LOG_E("param read fail by index. param no initialized.");
-        return(-RT_ERROR);
+        param_shadow_t *sh = (param_shadow_t *)(tbl->xip_shadow + pos);
+        int idx = sh->idx;
+        int rec_size = param_xip_rec_size(tbl->msgs[idx].size);
+        
+        if (param_is_volatile(tbl, idx))
+        {
+            memmove(tbl->xip_shadow + used, sh, rec_size);
+            tbl->xip_dirty[idx / 8] |= (1 << (idx % 8));
+            used += rec_size;
+        }
+        pos += rec_size;
     }
+    tbl->xip_used = used;
+}
+
+static const u8 *param_xip_addr(param_tbl_t *tbl, u32 addr)//address of flash in memory map
+{
+    #ifdef PARAM_USING_BACKEND
+    return((tbl->cfg.backend->map != NULL) ? tbl->cfg.backend->map(tbl->dev, addr) : NULL);
+    #else
+    const struct fal_flash_dev *dev = PARAM_FLASH_DEV_FIND(tbl->part->flash_name);
     
-    if (((u32)idx >= PARAM_TOTAL) || (addr == NULL) || (size <= 0))
+    if (dev == NULL)
     {
-        LOG_E("param write fail. input parameter error.");
-        return(-RT_ERROR);
+        return(NULL);
     }
+    return((const u8 *)(rt_ubase_t)(dev->addr + tbl->part->offset + addr));
+    #endif
+}
+
+static u8 *param_xip_shadow_find(param_tbl_t *tbl, int idx)
+{
+    u32 pos = 0;
     
-    ptype = param_msg_table[idx].type;
-    psize = param_msg_table[idx].size;
-    paddr = param_datas + param_offset_table[idx];
-    
-    param_mutex_take();
+    if (param_xip_test(tbl, idx) == 0)//clean params never search the pool
+    {
+        return(NULL);
+    }
     
-    switch (ptype)
+    while (pos < tbl->xip_used)
     {
-    case PTYPE_STR:
-        psize = strlen((const char *)paddr);
-        if (psize > (size - 1))
+        param_shadow_t *sh = (param_shadow_t *)(tbl->xip_shadow + pos);
+        if (sh->idx == idx)
         {
-            psize = (size - 1);
+            return((u8 *)(sh + 1));
         }
-        memcpy(addr, paddr, psize);
-        ((u8*)addr)[psize] = 0;
-        break;
-    case PTYPE_ARRAY:
-        if (psize > size)
+        pos += param_xip_rec_size(tbl->msgs[sh->idx].size);
+    }
+    
+    return(NULL);
+}
+
+/* 
+ * value of a parameter : the shadow if modified, else the mapped image,
+ * volatile params and params out of the image read default, which is parsed into buf
+ */
+static const u8 *param_xip_image_value(param_tbl_t *tbl, int idx, u8 *buf)//value of the mapped image, shadows are not looked up
+{
+    int size = tbl->msgs[idx].size;
+    
+    if ((tbl->xip_base != NULL) && (tbl->offsets[idx] + size <= tbl->xip_size) && (param_is_volatile(tbl, idx) == 0))
+    {
+        return(tbl->xip_base + tbl->offsets[idx]);
+    }
+    
+    memset(buf, 0, size);
+    param_input_value(buf, tbl->msgs[idx].type, size, PARAM_MSG_DEFVAL(tbl, idx));
+    return(buf);
+}
+
+static const u8 *param_xip_value(param_tbl_t *tbl, int idx, u8 *buf)
+{
+    u8 *shadow = param_xip_shadow_find(tbl, idx);
+    
+    if (shadow != NULL)
+    {
+        return(shadow);
+    }
+    return(param_xip_image_value(tbl, idx, buf));
+}
+
+static u8 *param_xip_shadow(param_tbl_t *tbl, int idx)//shadow of a parameter to be modified, created with its value
+{
+    int size = tbl->msgs[idx].size;
+    int rec_size = param_xip_rec_size(size);
+    u8 *shadow = param_xip_shadow_find(tbl, idx);
+    param_shadow_t *sh;
+    
+    if (shadow != NULL)
+    {
+        return(shadow);
+    }
+    
+    if (rec_size > PARAM_XIP_SHADOW_SIZE)
+    {
+        LOG_E("param shadow pool is too small. index : %d", idx);
+        return(NULL);
+    }
+    
+    if (tbl->xip_used + rec_size > PARAM_XIP_SHADOW_SIZE)//pool is full, modified params are saved to free it
+    {
+        if (param_xip_flush(tbl) != RT_EOK)
         {
-            psize = size;
+            return(NULL);
         }
-        memcpy(addr, paddr, psize);
-        break;
-    case PTYPE_INT:
+        if (tbl->xip_used + rec_size > PARAM_XIP_SHADOW_SIZE)
         {
-            s64 lval;
-            
-            if (size != sizeof(u8) && size != sizeof(u16) && size != sizeof(u32) && size != sizeof(u64))
-            {
-                psize = 0;
-                break;
-            }
-            
-            if (psize == sizeof(u32))
-            {
-                s32 tv;
-                memcpy((u8 *)&tv, paddr, psize);
-                lval = (s64)tv;
-            }
-            else
-            {
-                memcpy((u8 *)&lval, paddr, psize);
-            }
-            
-            memcpy(addr, (u8 *)&lval, size);
-            psize = size;
+            LOG_E("param shadow pool is full of volatile params. index : %d", idx);
+            return(NULL);
         }
-        break;
-    case PTYPE_HEX:
+    }
+    
+    sh = (param_shadow_t *)(tbl->xip_shadow + tbl->xip_used);
+    sh->idx = idx;
+    sh->resv = 0;
+    memmove(sh + 1, param_xip_value(tbl, idx, (u8 *)(sh + 1)), size);
+    tbl->xip_used += rec_size;
+    tbl->xip_dirty[idx / 8] |= (1 << (idx % 8));
+    
+    return((u8 *)(sh + 1));
+}
+#endif
+
+#ifdef PARAM_USING_JOURNAL
+#ifdef PARAM_USING_MIGRATE
+static void param_migrate_value(param_tbl_t *tbl, int mig_idx, const u8 *val);
+#endif
+
+static u32 param_journal_addr(param_tbl_t *tbl, int sector)
+{
+    return(tbl->cfg.journal_addr + sector * PARAM_SECTOR_SIZE);
+}
+
+static int param_journal_rec_size(int len)
+{
+    return(RT_ALIGN(sizeof(param_jnl_rec_t) + len, PARAM_JOURNAL_ALIGN));
+}
+
+static int param_journal_snapshot_size(param_tbl_t *tbl)
+{
+    int size = sizeof(param_jnl_head_t);
+    
+    #ifdef PARAM_USING_PRESET
+    size += param_journal_rec_size(sizeof(u16));//selector sequence of a preset switch
+    #endif
+    for (int i = 0; i < tbl->total; i++)
+    {
+        if (param_is_journal(tbl, i))
         {
-            u64 lval;
-            
-            if (size != sizeof(u8) && size != sizeof(u16) && size != sizeof(u32) && size != sizeof(u64))
-            {
-                psize = 0;
-                break;
-            }
-            
-            if (psize == sizeof(u32))
-            {
-                u32 tv;
-                memcpy((u8 *)&tv, paddr, psize);
-                lval = (u64)tv;
-            }
-            else
-            {
-                memcpy((u8 *)&lval, paddr, psize);
-            }
-            
-            memcpy(addr, (u8 *)&lval, size);
-            psize = size;
+            size += param_journal_rec_size(tbl->msgs[i].size);
         }
-        break;
-    case PTYPE_FLOAT:
-        {
-            f64 fval;
+    }
+    
+    return(size);
+}
 
-            if (size != sizeof(f32) && size != sizeof(f64))
-            {
-                psize = 0;
-                break;
-            }
+static int param_journal_put(param_tbl_t *tbl, u32 addr, int idx, const u8 *val, int len)
+{
+    u8 buf[sizeof(param_jnl_rec_t) + 256];
+    param_jnl_rec_t *rec = (param_jnl_rec_t *)buf;
+    
+    rec->idx = idx;
+    rec->len = len;
+    memmove(buf + sizeof(param_jnl_rec_t), val, len);
+    rec->crc16 = PARAM_CRC16_CAL(buf, offsetof(param_jnl_rec_t, crc16));
+    rec->crc16 = PARAM_CRC16_CYC_CAL(rec->crc16, buf + sizeof(param_jnl_rec_t), len);
+    
+    if (param_flash_write(tbl, addr, buf, sizeof(param_jnl_rec_t) + len) < 0)
+    {
+        LOG_E("param journal record write fail. addr : %d", addr);
+        return(-RT_ERROR);
+    }
+    return(RT_EOK);
+}
+
+static int param_journal_write_rec(param_tbl_t *tbl, u32 addr, int idx)
+{
+    #ifdef PARAM_USING_XIP
+    u8 buf[PARAM_VALUE_MAX];
+    
+    return(param_journal_put(tbl, addr, idx, param_xip_value(tbl, idx, buf), tbl->msgs[idx].size));
+    #else
+    return(param_journal_put(tbl, addr, idx, tbl->datas + tbl->offsets[idx], tbl->msgs[idx].size));
+    #endif
+}
+
+/*
+ * sel >= 0 - snapshot of a preset switch, it is in effect only after the selector record of sequence sel,
+ * so a power loss between the two writes loads the old snapshot with the old image
+ */
+static int param_journal_snapshot(param_tbl_t *tbl, int sel)//all journal params to the next sector
+{
+    int sector = (tbl->jnl_sector + 1) % tbl->cfg.journal_sectors;
+    u32 addr = param_journal_addr(tbl, sector);
+    u32 pos = sizeof(param_jnl_head_t);
+    param_jnl_head_t head;
+    
+    if (tbl->jnl_total == 0)//nothing to keep, the sector is not erased
+    {
+        return(RT_EOK);
+    }
+    if (param_flash_erase(tbl, addr, PARAM_SECTOR_SIZE) < 0)
+    {
+        LOG_E("param journal sector erase fail. addr : %d", addr);
+        return(-RT_ERROR);
+    }
+    
+    //snapshot of all journal params, the head is written at last
+    #ifdef PARAM_USING_PRESET
+    if (sel >= 0)
+    {
+        u16 seq = sel;
+        if (param_journal_put(tbl, addr + pos, PARAM_JOURNAL_SEL, (u8*)&seq, sizeof(seq)) != RT_EOK)
+        {
+            return(-RT_ERROR);
+        }
+        pos += param_journal_rec_size(sizeof(seq));
+    }
+    #endif
+    for (int i = 0; i < tbl->total; i++)
+    {
+        if (param_is_journal(tbl, i))
+        {
+            #ifdef PARAM_USING_XIP
+            u8 buf[PARAM_VALUE_MAX];
+            const u8 *val = (sel >= 0) ? param_xip_image_value(tbl, i, buf) : param_xip_value(tbl, i, buf);//the preset is read from its image
             
-            if (psize == sizeof(f32))
-            {
-                f32 tv;
-                memcpy((u8*)&tv, paddr, psize);
-                fval = (f64)tv;
-            }
-            else
+            if (param_journal_put(tbl, addr + pos, i, val, tbl->msgs[i].size) != RT_EOK)
+            #else
+            if (param_journal_write_rec(tbl, addr + pos, i) != RT_EOK)
+            #endif
             {
-                memcpy((u8*)&fval, paddr, psize);
+                return(-RT_ERROR);
             }
+            pos += param_journal_rec_size(tbl->msgs[i].size);
+        }
+    }
+    
+    head.magic = PARAM_MAGIC_JOURNAL;
+    head.seq = tbl->jnl_seq + 1;
+    head.crc16 = PARAM_CRC16_CAL((u8*)&head.seq, sizeof(head.seq));
+    if (param_flash_write(tbl, addr, (u8*)&head, sizeof(head)) < 0)
+    {
+        LOG_E("param journal head write fail. addr : %d", addr);
+        return(-RT_ERROR);
+    }
+    
+    tbl->jnl_sector = sector;
+    tbl->jnl_seq = head.seq;
+    tbl->jnl_pos = pos;
+    LOG_D("param journal compact success. sector : %d, seq : %d", sector, head.seq);
+    return(RT_EOK);
+}
 
-            if (size == sizeof(f32))
+static int param_journal_compact(param_tbl_t *tbl)
+{
+    return(param_journal_snapshot(tbl, -1));
+}
+
+#ifdef PARAM_USING_PRESET
+static int param_journal_pending(param_tbl_t *tbl, int sector)//snapshot of a preset switch whose selector record is not written
+{
+    u32 addr = param_journal_addr(tbl, sector) + sizeof(param_jnl_head_t);
+    param_jnl_rec_t rec;
+    u16 seq;
+    
+    if ((param_flash_read(tbl, addr, (u8*)&rec, sizeof(rec)) < 0) || (rec.idx != PARAM_JOURNAL_SEL) || (rec.len != sizeof(seq))
+        || (param_flash_read(tbl, addr + sizeof(rec), (u8*)&seq, sizeof(seq)) < 0))
+    {
+        return(0);
+    }
+    if (PARAM_CRC16_CYC_CAL(PARAM_CRC16_CAL((u8*)&rec, offsetof(param_jnl_rec_t, crc16)), (u8*)&seq, sizeof(seq)) != rec.crc16)
+    {
+        return(0);
+    }
+    if (tbl->sel_sector == -2)
+    {
+        param_sel_scan(tbl);
+    }
+    return((s16)(tbl->sel_seq - seq) < 0);
+}
+#endif
+
+static int param_journal_append(param_tbl_t *tbl, int idx)
+{
+    int size = param_journal_rec_size(tbl->msgs[idx].size);
+    int rst;
+    
+    if ((tbl->jnl_sector < 0) || (tbl->jnl_pos + size > PARAM_SECTOR_SIZE))
+    {
+        return(param_journal_compact(tbl));
+    }
+    
+    rst = param_journal_write_rec(tbl, param_journal_addr(tbl, tbl->jnl_sector) + tbl->jnl_pos, idx);
+    tbl->jnl_pos += size;//never program the same place twice, even if it fails
+    return(rst);
+}
+
+static int param_journal_load(param_tbl_t *tbl)
+{
+    u8 buf[256];
+    param_jnl_head_t head;
+    param_jnl_rec_t rec;
+    u32 addr, pos;
+    int sector = -1;
+    u32 seq = 0, top = 0;
+    
+    for (int i = 0; i < tbl->cfg.journal_sectors; i++)
+    {
+        if (param_flash_read(tbl, param_journal_addr(tbl, i), (u8*)&head, sizeof(head)) < 0)
+        {
+            continue;
+        }
+        if ((head.magic != PARAM_MAGIC_JOURNAL) || (PARAM_CRC16_CAL((u8*)&head.seq, sizeof(head.seq)) != head.crc16))
+        {
+            continue;
+        }
+        if (head.seq > top)
+        {
+            top = head.seq;
+        }
+        #ifdef PARAM_USING_PRESET
+        if (param_journal_pending(tbl, i))
+        {
+            continue;
+        }
+        #endif
+        if ((sector < 0) || (head.seq > seq))
+        {
+            sector = i;
+            seq = head.seq;
+        }
+    }
+    
+    tbl->jnl_sector = sector;
+    tbl->jnl_seq = top;//a snapshot never reuses the sequence of a pending one
+    tbl->jnl_pos = PARAM_SECTOR_SIZE;
+    if (sector < 0)
+    {
+        LOG_D("param journal is empty.");
+        return(RT_EOK);
+    }
+    
+    //replay the snapshot and the records after it, the last one wins
+    addr = param_journal_addr(tbl, sector);
+    pos = sizeof(param_jnl_head_t);
+    while (pos + sizeof(rec) <= PARAM_SECTOR_SIZE)
+    {
+        u16 crc16;
+        
+        if (param_flash_read(tbl, addr + pos, (u8*)&rec, sizeof(rec)) < 0)
+        {
+            LOG_E("param journal read fail. addr : %d", addr + pos);
+            return(-RT_ERROR);
+        }
+        if (rec.idx == PARAM_JOURNAL_EMPTY)
+        {
+            tbl->jnl_pos = pos;
+            break;
+        }
+        if ((rec.len > sizeof(buf)) || (pos + param_journal_rec_size(rec.len) > PARAM_SECTOR_SIZE)
+            || (param_flash_read(tbl, addr + pos + sizeof(rec), buf, rec.len) < 0))
+        {
+            break;//broken record, the next append goes to a new sector
+        }
+        crc16 = PARAM_CRC16_CAL((u8*)&rec, offsetof(param_jnl_rec_t, crc16));
+        crc16 = PARAM_CRC16_CYC_CAL(crc16, buf, rec.len);
+        if (crc16 != rec.crc16)
+        {
+            break;
+        }
+        #ifdef PARAM_USING_MIGRATE
+        if (tbl->mig != NULL)//records follow the layout of the migrated image
+        {
+            if ((rec.idx < tbl->mig_total) && (rec.len == tbl->mig[rec.idx].size))
             {
-                f32 tv = fval;
-                memcpy(addr, (u8 *)&tv, size);
+                param_migrate_value(tbl, rec.idx, buf);
             }
-            else
+        }
+        else
+        #endif
+        if ((rec.idx < tbl->total) && param_is_journal(tbl, rec.idx) && (rec.len == tbl->msgs[rec.idx].size))
+        {
+            #ifdef PARAM_USING_XIP
+            u8 *shadow = param_xip_shadow(tbl, rec.idx);
+            if (shadow != NULL)
             {
-                memcpy(addr, (u8 *)&fval, size);
+                memcpy(shadow, buf, rec.len);
             }
-
-            psize = size;
+            #else
+            memcpy(tbl->datas + tbl->offsets[rec.idx], buf, rec.len);
+            #endif
         }
-        break;
-    default:
-        psize = 0;
-        break;
+        pos += param_journal_rec_size(rec.len);
+    }
+    
+    LOG_D("param journal load success. sector : %d, seq : %d", sector, seq);
+    return(RT_EOK);
+}
+#endif
+
+#ifdef PARAM_USING_OVERLAY
+static int param_overlay_test(param_tbl_t *tbl, int idx)
+{
+    return((tbl->overlay_map[idx >> 3] >> (idx & 7)) & 1);
+}
+
+static void param_overlay_set(param_tbl_t *tbl, int idx)
+{
+    tbl->overlay_map[idx >> 3] |= (1 << (idx & 7));
+}
+
+static void param_overlay_clear(param_tbl_t *tbl, int idx)
+{
+    tbl->overlay_map[idx >> 3] &= ~(1 << (idx & 7));
+}
+
+static void param_overlay_update(param_tbl_t *tbl, int idx)
+{
+    u16 offset = tbl->offsets[idx];
+    
+    if (param_get_store(tbl, idx) != PSTORE_IMAGE)//journal and volatile params are never saved in image
+    {
+        param_overlay_clear(tbl, idx);
+    }
+    else if (memcmp(tbl->datas + offset, tbl->defaults + offset, tbl->msgs[idx].size) != 0)
+    {
+        param_overlay_set(tbl, idx);
+    }
+    else
+    {
+        param_overlay_clear(tbl, idx);
+    }
+}
+
+static void param_overlay_rebuild(param_tbl_t *tbl)
+{
+    for (int i = 0; i < tbl->total; i++)
+    {
+        param_overlay_update(tbl, i);
+    }
+}
+
+static void param_overlay_reset(param_tbl_t *tbl)
+{
+    memcpy(tbl->datas, tbl->defaults, tbl->size);
+    memset(tbl->overlay_map, 0, PARAM_MAP_SIZE(tbl));
+}
+
+static int param_overlay_value_len(param_tbl_t *tbl, int idx)
+{
+    int size = tbl->msgs[idx].size;
+    
+    if (tbl->msgs[idx].type == PTYPE_STR)
+    {
+        const char *str = (const char *)(tbl->datas + tbl->offsets[idx]);
+        int len = 0;
+        while ((len < size - 1) && (str[len] != 0))
+        {
+            len++;
+        }
+        return(len);
+    }
+    
+    return(size);
+}
+#endif
+
+#if defined(PARAM_USING_DYNAMIC) || defined(PARAM_USING_MIGRATE) || defined(PARAM_USING_TEXT_IMPORT)
+static u32 param_hash(const char *key, int klen)
+{
+    u32 hash = 2166136261u;//FNV-1a
+    
+    for (int i = 0; i < klen; i++)
+    {
+        hash ^= (u8)key[i];
+        hash *= 16777619u;
+    }
+    return(hash);
+}
+#endif
+
+#if defined(PARAM_USING_MIGRATE) || defined(PARAM_USING_TEXT_IMPORT)
+static u32 param_name_hash(param_tbl_t *tbl, int idx)
+{
+    const char *name = PARAM_MSG_NAME(tbl, idx);
+    
+    return(param_hash(name, strlen(name)));
+}
+
+static int param_name_index_slots(param_tbl_t *tbl)//slots of name index, power of 2, at most half used
+{
+    int slots = 1;
+    
+    while (slots < tbl->total * 2)
+    {
+        slots <<= 1;
+    }
+    return(slots);
+}
+
+static int param_name_index_build(param_tbl_t *tbl, param_name_slot_t *slots, int count)//return count of params whose name hash is already used
+{
+    int mask = count - 1;
+    int dup = 0;
+    
+    for (int i = 0; i < count; i++)
+    {
+        slots[i].idx = PARAM_NAME_SLOT_EMPTY;
+    }
+    for (int i = 0; i < tbl->total; i++)
+    {
+        u32 hash = param_name_hash(tbl, i);
+        int pos = hash & mask;
+        
+        while (slots[pos].idx != PARAM_NAME_SLOT_EMPTY)
+        {
+            if (slots[pos].hash == hash)
+            {
+                dup++;
+            }
+            pos = (pos + 1) & mask;
+        }
+        slots[pos].hash = hash;
+        slots[pos].idx = i;
+    }
+    return(dup);
+}
+
+static int param_name_index_find(param_tbl_t *tbl, const param_name_slot_t *slots, int count, u32 hash, const char *name)//name NULL - matched by hash only
+{
+    int mask = count - 1;
+    
+    for (int pos = hash & mask; slots[pos].idx != PARAM_NAME_SLOT_EMPTY; pos = (pos + 1) & mask)
+    {
+        if ((slots[pos].hash == hash) && ((name == NULL) || (strcmp(PARAM_MSG_NAME(tbl, slots[pos].idx), name) == 0)))
+        {
+            return(slots[pos].idx);
+        }
+    }
+    return(-1);
+}
+#endif
+
+#ifdef PARAM_USING_DYNAMIC
+
+static int param_dyn_rec_size(int klen, int vlen)
+{
+    return(RT_ALIGN(sizeof(param_dyn_rec_t) + klen + 1 + vlen, PARAM_DYN_ALIGN));
+}
+
+static int param_dyn_max_count(param_tbl_t *tbl)
+{
+    return(tbl->cfg.dyn_slots * 3 / 4);//keep the index sparse, probes stay short
+}
+
+/* 
+ * find the slot of key in hash index, 
+ * pfree returns the first slot can be used for the key when it is not found
+ */
+static int param_dyn_find(param_tbl_t *tbl, const char *key, int klen, int *pfree)
+{
+    u32 mask = tbl->cfg.dyn_slots - 1;
+    u32 pos = param_hash(key, klen) & mask;
+    int free = -1;
+    
+    for (u32 n = 0; n <= mask; n++, pos = (pos + 1) & mask)
+    {
+        u16 slot = tbl->dyn_index[pos];
+        param_dyn_rec_t *rec;
+        
+        if (slot == PARAM_DYN_SLOT_EMPTY)
+        {
+            if (free < 0)
+            {
+                free = pos;
+            }
+            break;
+        }
+        if (slot == PARAM_DYN_SLOT_DELETED)
+        {
+            if (free < 0)
+            {
+                free = pos;
+            }
+            continue;
+        }
+        rec = PARAM_DYN_REC(tbl, slot);
+        if ((rec->klen == klen) && (memcmp(rec + 1, key, klen) == 0))
+        {
+            return(pos);
+        }
+    }
+    
+    if (pfree != NULL)
+    {
+        *pfree = free;
+    }
+    return(-1);
+}
+
+static void param_dyn_reset(param_tbl_t *tbl)
+{
+    memset(tbl->dyn_index, 0, tbl->cfg.dyn_slots * sizeof(u16));
+    tbl->dyn_used = 0;
+    tbl->dyn_garbage = 0;
+    tbl->dyn_count = 0;
+    tbl->dyn_tombs = 0;
+}
+
+/* 
+ * rebuild hash index from arena records, 
+ * it is used after load and compaction, returns error if records are broken
+ */
+static int param_dyn_rebuild(param_tbl_t *tbl)
+{
+    u32 pos = 0;
+    
+    memset(tbl->dyn_index, 0, tbl->cfg.dyn_slots * sizeof(u16));
+    tbl->dyn_garbage = 0;
+    tbl->dyn_count = 0;
+    tbl->dyn_tombs = 0;
+    
+    while (pos < tbl->dyn_used)
+    {
+        param_dyn_rec_t *rec = (param_dyn_rec_t *)(tbl->dyn_arena + pos);
+        const char *key = (const char *)(rec + 1);
+        int size, free;
+        
+        if (pos + sizeof(param_dyn_rec_t) > tbl->dyn_used)
+        {
+            return(-RT_ERROR);
+        }
+        size = param_dyn_rec_size(rec->klen, rec->vlen);
+        if ((pos + size > tbl->dyn_used) || (rec->klen == 0) || (rec->klen > PARAM_DYN_KEY_MAX) || (key[rec->klen] != 0))
+        {
+            return(-RT_ERROR);
+        }
+        if (rec->flag == PARAM_DYN_LIVE)
+        {
+            if ((tbl->dyn_count >= param_dyn_max_count(tbl)) || (param_dyn_find(tbl, key, rec->klen, &free) >= 0))
+            {
+                return(-RT_ERROR);
+            }
+            tbl->dyn_index[free] = pos / PARAM_DYN_ALIGN + 1;
+            tbl->dyn_count++;
+        }
+        else
+        {
+            tbl->dyn_garbage += size;
+        }
+        pos += size;
+    }
+    
+    return(RT_EOK);
+}
+
+static void param_dyn_compact(param_tbl_t *tbl)
+{
+    u32 pos = 0, used = 0;
+    
+    //move live records down over the deleted, the order is kept
+    while (pos < tbl->dyn_used)
+    {
+        param_dyn_rec_t *rec = (param_dyn_rec_t *)(tbl->dyn_arena + pos);
+        int size = param_dyn_rec_size(rec->klen, rec->vlen);
+        
+        if (rec->flag == PARAM_DYN_LIVE)
+        {
+            if (used != pos)
+            {
+                memmove(tbl->dyn_arena + used, rec, size);
+            }
+            used += size;
+        }
+        pos += size;
+    }
+    
+    tbl->dyn_used = used;
+    param_dyn_rebuild(tbl);
+}
+
+static void param_dyn_remove(param_tbl_t *tbl, int pos)
+{
+    param_dyn_rec_t *rec = PARAM_DYN_REC(tbl, tbl->dyn_index[pos]);
+    
+    rec->flag = PARAM_DYN_DELETED;
+    tbl->dyn_garbage += param_dyn_rec_size(rec->klen, rec->vlen);
+    tbl->dyn_index[pos] = PARAM_DYN_SLOT_DELETED;
+    tbl->dyn_tombs++;
+    tbl->dyn_count--;
+    tbl->dyn_dirty = 1;
+}
+
+static int param_dyn_init(param_tbl_t *tbl)
+{
+    u16 slots = tbl->cfg.dyn_slots;
+    
+    tbl->dyn_size = tbl->cfg.dyn_sectors * PARAM_SECTOR_SIZE - sizeof(param_dyn_head_t);
+    if ((slots < 4) || ((slots & (slots - 1)) != 0) || (tbl->dyn_size / PARAM_DYN_ALIGN >= PARAM_DYN_SLOT_DELETED))
+    {
+        LOG_E("param dynamic init error. slots must be power of 2, arena must be less than %d.", PARAM_DYN_SLOT_DELETED * PARAM_DYN_ALIGN);
+        return(-RT_ERROR);
+    }
+    
+    //arena and index are allocated once, creating dynamic params never malloc
+    if (tbl->dyn_arena == NULL)
+    {
+        tbl->dyn_arena = malloc(tbl->dyn_size);
+    }
+    if (tbl->dyn_index == NULL)
+    {
+        tbl->dyn_index = malloc(slots * sizeof(u16));
+    }
+    if ((tbl->dyn_arena == NULL) || (tbl->dyn_index == NULL))
+    {
+        return(-RT_ENOMEM);
+    }
+    
+    param_dyn_reset(tbl);
+    tbl->dyn_dirty = 0;
+    return(RT_EOK);
+}
+
+static void param_dyn_deinit(param_tbl_t *tbl)
+{
+    if (tbl->dyn_arena != NULL)
+    {
+        free(tbl->dyn_arena);
+        tbl->dyn_arena = NULL;
+    }
+    if (tbl->dyn_index != NULL)
+    {
+        free(tbl->dyn_index);
+        tbl->dyn_index = NULL;
+    }
+}
+
+static int param_dyn_write_to_addr(param_tbl_t *tbl, u32 addr)
+{
+    param_dyn_head_t head;
+    u32 size = RT_ALIGN(sizeof(head) + tbl->dyn_used, PARAM_SECTOR_SIZE);
+    
+    if (( ! PARAM_TBL_IN_PLACE(tbl)) && (param_flash_erase(tbl, addr, size) < 0))//in place storage is only updated
+    {
+        LOG_E("param dynamic sector erease fail. addr : %d", addr);
+        return(-RT_ERROR);
+    }
+    if ((tbl->dyn_used > 0) && (param_flash_program(tbl, addr+sizeof(head), tbl->dyn_arena, tbl->dyn_used) < 0))
+    {
+        LOG_E("param dynamic write fail. addr : %d", addr);
+        return(-RT_ERROR);
+    }
+    
+    //the head is written at last, so an interrupted write never looks valid
+    head.magic = PARAM_MAGIC_DYN;
+    head.count = tbl->dyn_count;
+    head.size = tbl->dyn_used;
+    head.crc16 = PARAM_CRC16_CAL(tbl->dyn_arena, tbl->dyn_used);
+    head.head_crc16 = PARAM_CRC16_CAL((u8*)&head, sizeof(head)-2);
+    if (param_flash_write(tbl, addr, (u8*)&head, sizeof(head)) < 0)
+    {
+        LOG_E("param dynamic head write fail. addr : %d", addr);
+        return(-RT_ERROR);
+    }
+    LOG_D("param dynamic write success. addr : %d, count : %d", addr, head.count);
+    return(RT_EOK);
+}
+
+static int param_dyn_read_from_addr(param_tbl_t *tbl, u32 addr)
+{
+    param_dyn_head_t head;
+    
+    if (param_flash_read(tbl, addr, (u8*)&head, sizeof(head)) < 0)
+    {
+        LOG_E("param dynamic head read fail. addr : %d", addr);
+        return(-RT_ERROR);
+    }
+    if ((head.magic != PARAM_MAGIC_DYN) || (PARAM_CRC16_CAL((u8*)&head, sizeof(head)-2) != head.head_crc16)
+        || (head.size > tbl->dyn_size))
+    {
+        LOG_D("param dynamic head check fail. addr : %d", addr);
+        return(-RT_ERROR);
+    }
+    if ((head.size > 0) && (param_flash_read(tbl, addr+sizeof(head), tbl->dyn_arena, head.size) < 0))
+    {
+        LOG_E("param dynamic read fail. addr : %d", addr);
+        return(-RT_ERROR);
+    }
+    
+    tbl->dyn_used = head.size;
+    if ((PARAM_CRC16_CAL(tbl->dyn_arena, head.size) != head.crc16)
+        || (param_dyn_rebuild(tbl) != RT_EOK) || (tbl->dyn_count != head.count))
+    {
+        LOG_E("param dynamic check fail. addr : %d", addr);
+        PARAM_STAT_INC(tbl, crc_fails);
+        param_dyn_reset(tbl);
+        return(-RT_ERROR);
+    }
+    LOG_D("param dynamic read success. addr : %d, count : %d", addr, head.count);
+    return(RT_EOK);
+}
+
+static int param_dyn_load(param_tbl_t *tbl)
+{
+    tbl->dyn_dirty = 0;
+    if (param_dyn_read_from_addr(tbl, tbl->cfg.dyn_addr) == RT_EOK)
+    {
+        return(RT_EOK);
+    }
+    if (param_dyn_read_from_addr(tbl, tbl->cfg.dyn_addr_bak) == RT_EOK)
+    {
+        return(RT_EOK);
+    }
+    param_dyn_reset(tbl);
+    return(-RT_ERROR);
+}
+
+static int param_dyn_save(param_tbl_t *tbl)
+{
+    int rst1, rst2;
+    
+    if (tbl->dyn_dirty == 0)//the image in flash is the same, no erase
+    {
+        return(RT_EOK);
+    }
+    
+    if (tbl->dyn_garbage > 0)
+    {
+        param_dyn_compact(tbl);
+    }
+    rst1 = param_dyn_write_to_addr(tbl, tbl->cfg.dyn_addr);
+    rst2 = param_dyn_write_to_addr(tbl, tbl->cfg.dyn_addr_bak);
+    if ((rst1 != RT_EOK) && (rst2 != RT_EOK))
+    {
+        return(-RT_ERROR);
+    }
+    
+    tbl->dyn_dirty = 0;
+    return(RT_EOK);
+}
+#endif
+
+#ifdef PARAM_USING_EXT_IMAGE
+static void param_writer_init(param_writer_t *wr, param_tbl_t *tbl, u32 addr, int comp)
+{
+    wr->tbl = tbl;
+    wr->addr = addr;
+    wr->size = 0;
+    wr->out = 0;
+    wr->crc16 = 0;
+    wr->comp = comp;
+    wr->len = 0;
+    wr->rst = RT_EOK;
+    #ifdef PARAM_USING_COMPRESS
+    wr->run_len = 0;
+    wr->lit_len = 0;
+    #endif
+}
+
+static void param_writer_flush(param_writer_t *wr)
+{
+    if ((wr->len > 0) && (wr->rst == RT_EOK))
+    {
+        if (param_flash_program(wr->tbl, wr->addr, wr->buf, wr->len) < 0)
+        {
+            wr->rst = -RT_ERROR;
+        }
+    }
+    wr->addr += wr->len;
+    wr->len = 0;
+}
+
+static void param_writer_output(param_writer_t *wr, const u8 *data, int size)
+{
+    wr->out += size;
+    
+    while (size > 0)
+    {
+        int len = PARAM_WRITE_BUF_SIZE - ((wr->addr + wr->len) & (PARAM_WRITE_BUF_SIZE - 1));//to the step boundary
+        if (len > size)
+        {
+            len = size;
+        }
+        memcpy(wr->buf + wr->len, data, len);
+        wr->len += len;
+        data += len;
+        size -= len;
+        if (((wr->addr + wr->len) & (PARAM_WRITE_BUF_SIZE - 1)) == 0)
+        {
+            param_writer_flush(wr);
+        }
+    }
+}
+
+#ifdef PARAM_USING_COMPRESS
+/* rle block : ctrl byte 0x00~0x7F - (ctrl+1) literal bytes follow,
+ *             ctrl byte 0x80~0xFF - next byte repeats (ctrl-0x80+3) times
+ */
+static void param_rle_lit_flush(param_writer_t *wr)
+{
+    if (wr->lit_len > 0)
+    {
+        u8 ctrl = wr->lit_len - 1;
+        param_writer_output(wr, &ctrl, 1);
+        param_writer_output(wr, wr->lit, wr->lit_len);
+        wr->lit_len = 0;
+    }
+}
+
+static void param_rle_run_end(param_writer_t *wr)
+{
+    if (wr->run_len >= PARAM_RLE_RUN_MIN)
+    {
+        u8 ctrl = 0x80 + wr->run_len - PARAM_RLE_RUN_MIN;
+        param_rle_lit_flush(wr);
+        param_writer_output(wr, &ctrl, 1);
+        param_writer_output(wr, &wr->run_byte, 1);
+    }
+    else
+    {
+        for (int i = 0; i < wr->run_len; i++)
+        {
+            wr->lit[wr->lit_len++] = wr->run_byte;
+            if (wr->lit_len >= PARAM_RLE_LIT_MAX)
+            {
+                param_rle_lit_flush(wr);
+            }
+        }
+    }
+    wr->run_len = 0;
+}
+
+static void param_rle_put(param_writer_t *wr, const u8 *data, int size)
+{
+    for (int i = 0; i < size; i++)
+    {
+        if ((wr->run_len > 0) && (data[i] == wr->run_byte) && (wr->run_len < PARAM_RLE_RUN_MAX))
+        {
+            wr->run_len++;
+            continue;
+        }
+        param_rle_run_end(wr);
+        wr->run_byte = data[i];
+        wr->run_len = 1;
+    }
+}
+#endif
+
+static void param_writer_put(param_writer_t *wr, const void *data, int size)
+{
+    u8 *pdata = (u8 *)data;
+    
+    if (size <= 0)
+    {
+        return;
+    }
+    
+    if (wr->size == 0)
+    {
+        wr->crc16 = PARAM_CRC16_CAL(pdata, size);
+    }
+    else
+    {
+        wr->crc16 = PARAM_CRC16_CYC_CAL(wr->crc16, pdata, size);
+    }
+    wr->size += size;
+    
+    #ifdef PARAM_USING_COMPRESS
+    if (wr->comp == PCOMP_RLE)
+    {
+        param_rle_put(wr, pdata, size);
+        return;
+    }
+    #endif
+    
+    param_writer_output(wr, pdata, size);
+}
+
+static void param_writer_finish(param_writer_t *wr)
+{
+    #ifdef PARAM_USING_COMPRESS
+    if (wr->comp == PCOMP_RLE)
+    {
+        param_rle_run_end(wr);
+        param_rle_lit_flush(wr);
+    }
+    #endif
+    param_writer_flush(wr);
+}
+
+#ifndef PARAM_USING_XIP
+static void param_reader_init(param_reader_t *rd, param_tbl_t *tbl, u32 addr, int size, int comp, int zsize)
+{
+    rd->tbl = tbl;
+    rd->addr = addr;
+    rd->remain = size;
+    rd->crc16 = 0;
+    rd->comp = comp;
+    rd->len = 0;
+    rd->pos = 0;
+    rd->rst = RT_EOK;
+    #ifdef PARAM_USING_COMPRESS
+    rd->zremain = zsize;
+    rd->zlen = 0;
+    rd->zpos = 0;
+    rd->lit = 0;
+    rd->rep = 0;
+    #endif
+}
+
+#ifdef PARAM_USING_COMPRESS
+static int param_rle_get_byte(param_reader_t *rd, u8 *pbyte)
+{
+    if (rd->zpos >= rd->zlen)
+    {
+        int len = rd->zremain;
+        if (len > PARAM_WRITE_BUF_SIZE)
+        {
+            len = PARAM_WRITE_BUF_SIZE;
+        }
+        if ((len <= 0) || (param_flash_read(rd->tbl, rd->addr, rd->zbuf, len) < 0))
+        {
+            return(-RT_ERROR);
+        }
+        rd->addr += len;
+        rd->zremain -= len;
+        rd->zlen = len;
+        rd->zpos = 0;
+    }
+    *pbyte = rd->zbuf[rd->zpos++];
+    return(RT_EOK);
+}
+
+static int param_rle_decode(param_reader_t *rd, u8 *buf, int size)
+{
+    int n = 0;
+    
+    while (n < size)
+    {
+        if (rd->rep > 0)
+        {
+            buf[n++] = rd->rep_byte;
+            rd->rep--;
+        }
+        else if (rd->lit > 0)
+        {
+            if (param_rle_get_byte(rd, &buf[n++]) < 0)
+            {
+                return(-RT_ERROR);
+            }
+            rd->lit--;
+        }
+        else
+        {
+            u8 ctrl;
+            if (param_rle_get_byte(rd, &ctrl) < 0)
+            {
+                return(-RT_ERROR);
+            }
+            if (ctrl < 0x80)
+            {
+                rd->lit = ctrl + 1;
+            }
+            else
+            {
+                rd->rep = ctrl - 0x80 + PARAM_RLE_RUN_MIN;
+                if (param_rle_get_byte(rd, &rd->rep_byte) < 0)
+                {
+                    return(-RT_ERROR);
+                }
+            }
+        }
+    }
+    
+    return(RT_EOK);
+}
+#endif
+
+static void param_reader_fill(param_reader_t *rd)
+{
+    int len = rd->remain;
+    int rst;
+    
+    if (len > PARAM_WRITE_BUF_SIZE)
+    {
+        len = PARAM_WRITE_BUF_SIZE;
+    }
+    if (len <= 0)
+    {
+        rd->rst = -RT_ERROR;
+        return;
+    }
+    
+    #ifdef PARAM_USING_COMPRESS
+    if (rd->comp == PCOMP_RLE)
+    {
+        rst = param_rle_decode(rd, rd->buf, len);
+    }
+    else
+    #endif
+    {
+        rst = param_flash_read(rd->tbl, rd->addr, rd->buf, len);
+        rd->addr += len;
+    }
+    if (rst < 0)
+    {
+        rd->rst = -RT_ERROR;
+        return;
+    }
+    
+    if (rd->len == 0)
+    {
+        rd->crc16 = PARAM_CRC16_CAL(rd->buf, len);
+    }
+    else
+    {
+        rd->crc16 = PARAM_CRC16_CYC_CAL(rd->crc16, rd->buf, len);
+    }
+    rd->remain -= len;
+    rd->len = len;
+    rd->pos = 0;
+}
+
+static int param_reader_get(param_reader_t *rd, void *data, int size)
+{
+    u8 *pdata = data;
+    
+    while ((size > 0) && (rd->rst == RT_EOK))
+    {
+        int len = rd->len - rd->pos;
+        if (len <= 0)
+        {
+            param_reader_fill(rd);
+            continue;
+        }
+        if (len > size)
+        {
+            len = size;
+        }
+        memcpy(pdata, rd->buf + rd->pos, len);
+        rd->pos += len;
+        pdata += len;
+        size -= len;
+    }
+    
+    return(rd->rst);
+}
+
+static int param_reader_check(param_reader_t *rd, u16 crc16)
+{
+    if ((rd->rst != RT_EOK) || (rd->remain != 0) || (rd->pos != rd->len) || (rd->crc16 != crc16))
+    {
+        return(-RT_ERROR);
+    }
+    #ifdef PARAM_USING_COMPRESS
+    if ((rd->comp == PCOMP_RLE)
+        && ((rd->zremain != 0) || (rd->zpos != rd->zlen) || (rd->lit != 0) || (rd->rep != 0)))
+    {
+        return(-RT_ERROR);
+    }
+    #endif
+    return(RT_EOK);
+}
+#endif
+
+#ifdef PARAM_USING_OVERLAY
+static void param_encode_sparse(param_tbl_t *tbl, param_writer_t *wr)
+{
+    u16 total = tbl->total;
+    
+    //sparse data : total + non-default map + records(index, length, value)
+    param_writer_put(wr, &total, sizeof(total));
+    param_writer_put(wr, tbl->overlay_map, PARAM_MAP_SIZE(tbl));
+    for (int i = 0; i < tbl->total; i++)
+    {
+        if (param_overlay_test(tbl, i))
+        {
+            u16 idx = i;
+            u8 len = param_overlay_value_len(tbl, i);
+            param_writer_put(wr, &idx, sizeof(idx));
+            param_writer_put(wr, &len, sizeof(len));
+            param_writer_put(wr, tbl->datas + tbl->offsets[i], len);
+        }
+    }
+}
+
+static int param_decode_sparse(param_tbl_t *tbl, param_reader_t *rd)
+{
+    u16 total = 0;
+    int count = 0;
+    
+    param_reader_get(rd, &total, sizeof(total));
+    if ((rd->rst != RT_EOK) || (total != tbl->total))
+    {
+        return(-RT_ERROR);
+    }
+    
+    //expand records against the default layer
+    param_overlay_reset(tbl);
+    param_reader_get(rd, tbl->overlay_map, PARAM_MAP_SIZE(tbl));
+    for (int i = 0; i < tbl->total; i++)
+    {
+        count += param_overlay_test(tbl, i);
+    }
+    
+    while ((count > 0) && (rd->rst == RT_EOK))
+    {
+        u16 idx = 0;
+        u8 len = 0;
+        u8 *paddr;
+        
+        param_reader_get(rd, &idx, sizeof(idx));
+        param_reader_get(rd, &len, sizeof(len));
+        if ((rd->rst != RT_EOK) || (idx >= tbl->total) || (param_overlay_test(tbl, idx) == 0))
+        {
+            return(-RT_ERROR);
+        }
+        if ((len > tbl->msgs[idx].size)
+            || ((tbl->msgs[idx].type != PTYPE_STR) && (len != tbl->msgs[idx].size)))
+        {
+            return(-RT_ERROR);
+        }
+        paddr = tbl->datas + tbl->offsets[idx];
+        memset(paddr, 0, tbl->msgs[idx].size);
+        param_reader_get(rd, paddr, len);
+        count--;
+    }
+    
+    return(rd->rst);
+}
+#endif
+
+#ifdef PARAM_USING_MIGRATE
+static void param_values_reset(param_tbl_t *tbl);
+
+static void param_dir_write(param_tbl_t *tbl, param_writer_t *wr)
+{
+    u16 total = tbl->total;
+    
+    //directory : total + entries(name hash, type, size)
+    param_writer_put(wr, &total, sizeof(total));
+    for (int i = 0; i < tbl->total; i++)
+    {
+        u8 ent[PARAM_DIR_ENTRY_SIZE];
+        u32 hash = param_name_hash(tbl, i);
+        
+        memcpy(ent, &hash, sizeof(hash));
+        ent[4] = tbl->msgs[i].type;
+        ent[5] = tbl->msgs[i].size;
+        param_writer_put(wr, ent, sizeof(ent));
+    }
+}
+
+static void param_migrate_free(param_tbl_t *tbl)
+{
+    if (tbl->mig != NULL)
+    {
+        free(tbl->mig);
+        tbl->mig = NULL;
+    }
+    tbl->mig_total = 0;
+}
+
+static int param_migrate_check(param_tbl_t *tbl)//saved entries are matched by name hash only, the hashes of current names must differ
+{
+    int count = param_name_index_slots(tbl);
+    param_name_slot_t *slots = malloc(count * sizeof(param_name_slot_t));
+    
+    if (slots == NULL)
+    {
+        return(-RT_ERROR);
+    }
+    tbl->mig_dup = (param_name_index_build(tbl, slots, count) != 0);
+    free(slots);
+    if (tbl->mig_dup)
+    {
+        LOG_E("param %s names share a hash. rename the params, images of other layout are not migrated.", tbl->name);
+    }
+    
+    return(RT_EOK);
+}
+
+static int param_migrate_join(param_tbl_t *tbl, param_reader_t *rd, int total)//map each saved param to current table by name hash
+{
+    int count = param_name_index_slots(tbl);
+    param_name_slot_t *slots;
+    
+    if (tbl->mig_dup)
+    {
+        LOG_E("param migrate fail. names of %s share a hash, values would be swapped.", tbl->name);
+        return(-RT_ERROR);
+    }
+    if (total == 0)
+    {
+        LOG_E("param migrate fail. saved directory is empty.");
+        return(-RT_ERROR);
+    }
+    slots = malloc(count * sizeof(param_name_slot_t));
+    tbl->mig = malloc(total * sizeof(param_mig_t));
+    if ((slots == NULL) || (tbl->mig == NULL))
+    {
+        if (slots != NULL)
+        {
+            free(slots);
+        }
+        param_migrate_free(tbl);
+        LOG_E("param migrate fail. no memory for migration.");
+        return(-RT_ERROR);
+    }
+    tbl->mig_total = total;
+    
+    //index current params by name hash, then look up each saved entry once
+    param_name_index_build(tbl, slots, count);
+    for (int i = 0; i < total; i++)
+    {
+        u8 ent[PARAM_DIR_ENTRY_SIZE] = {0};
+        u32 hash;
+        int idx;
+        
+        param_reader_get(rd, ent, sizeof(ent));
+        memcpy(&hash, ent, sizeof(hash));
+        idx = param_name_index_find(tbl, slots, count, hash, NULL);
+        tbl->mig[i].idx = (idx < 0) ? PARAM_MIG_NONE : idx;
+        tbl->mig[i].type = ent[4];
+        tbl->mig[i].size = ent[5];
+    }
+    free(slots);
+    
+    return(rd->rst);
+}
+
+static int param_dir_read(param_tbl_t *tbl, param_reader_t *rd, u32 addr, param_ext_head_t *head)
+{
+    u16 total = 0;
+    int i = 0;
+    
+    //the directory is compared with current table first, nothing is allocated if the layout is not changed
+    param_reader_get(rd, &total, sizeof(total));
+    if (total == tbl->total)
+    {
+        for (i = 0; (i < total) && (rd->rst == RT_EOK); i++)
+        {
+            u8 ent[PARAM_DIR_ENTRY_SIZE] = {0};
+            u32 hash;
+            
+            param_reader_get(rd, ent, sizeof(ent));
+            memcpy(&hash, ent, sizeof(hash));
+            if ((hash != param_name_hash(tbl, i)) || (ent[4] != tbl->msgs[i].type) || (ent[5] != tbl->msgs[i].size))
+            {
+                break;
+            }
+        }
+    }
+    if (rd->rst != RT_EOK)
+    {
+        return(-RT_ERROR);
+    }
+    if ((total == tbl->total) && (i == total))
+    {
+        return(RT_EOK);
+    }
+    
+    //layout changed, read the directory again for the join
+    param_reader_init(rd, tbl, addr + sizeof(*head), head->raw_size, head->comp, head->size);
+    param_reader_get(rd, &total, sizeof(total));
+    if (rd->rst != RT_EOK)
+    {
+        return(-RT_ERROR);
+    }
+    return(param_migrate_join(tbl, rd, total));
+}
+
+static int param_convert_integer(u8 *dst, int ntype, int nsize, const u8 *src, int type, int size)
+{
+    u64 mag;            //magnitude of value
+    int neg = 0;
+    
+    if (((type != PTYPE_INT) && (type != PTYPE_HEX)) || ((size != sizeof(u32)) && (size != sizeof(u64))))
+    {
+        return(-RT_ERROR);
+    }
+    if (type == PTYPE_INT)
+    {
+        s64 v;
+        if (size == sizeof(s32))
+        {
+            s32 v32;
+            memcpy(&v32, src, sizeof(v32));
+            v = v32;
+        }
+        else
+        {
+            memcpy(&v, src, sizeof(v));
+        }
+        neg = (v < 0);
+        mag = neg ? (0 - (u64)v) : (u64)v;
+    }
+    else
+    {
+        u32 v32;
+        if (size == sizeof(u32))
+        {
+            memcpy(&v32, src, sizeof(v32));
+            mag = v32;
+        }
+        else
+        {
+            memcpy(&mag, src, sizeof(mag));
+        }
+    }
+    
+    if (ntype == PTYPE_HEX)
+    {
+        if (neg || ((nsize == sizeof(u32)) && (mag > 0xFFFFFFFFu)))
+        {
+            return(-RT_ERROR);
+        }
+        if (nsize == sizeof(u32))
+        {
+            u32 v32 = (u32)mag;
+            memcpy(dst, &v32, sizeof(v32));
+        }
+        else
+        {
+            memcpy(dst, &mag, sizeof(mag));
+        }
+    }
+    else
+    {
+        u64 max = (nsize == sizeof(s32)) ? 0x7FFFFFFFu : 0x7FFFFFFFFFFFFFFFull;
+        s64 v;
+        if (mag > max + neg)
+        {
+            return(-RT_ERROR);
+        }
+        v = neg ? (s64)(0 - mag) : (s64)mag;
+        if (nsize == sizeof(s32))
+        {
+            s32 v32 = (s32)v;
+            memcpy(dst, &v32, sizeof(v32));
+        }
+        else
+        {
+            memcpy(dst, &v, sizeof(v));
+        }
+    }
+    return(RT_EOK);
+}
+
+static int param_convert_value(u8 *dst, int ntype, int nsize, const u8 *src, int type, int size)//convert only if the value is kept
+{
+    int len = 0;
+    
+    memset(dst, 0, nsize);
+    if ((type == ntype) && (size == nsize))
+    {
+        memcpy(dst, src, size);
+        return(RT_EOK);
+    }
+    
+    switch (ntype)
+    {
+    case PTYPE_STR:
+        if (type != PTYPE_STR)
+        {
+            return(-RT_ERROR);
+        }
+        while ((len < size) && (src[len] != 0))
+        {
+            len++;
+        }
+        if (len >= nsize)//string is never truncated
+        {
+            return(-RT_ERROR);
+        }
+        memcpy(dst, src, len);
+        return(RT_EOK);
+    case PTYPE_ARRAY:
+        if ((type != PTYPE_ARRAY) || (size > nsize))//array is extended with zero, never truncated
+        {
+            return(-RT_ERROR);
+        }
+        memcpy(dst, src, size);
+        return(RT_EOK);
+    case PTYPE_INT:
+    case PTYPE_HEX:
+        if ((nsize != sizeof(u32)) && (nsize != sizeof(u64)))
+        {
+            return(-RT_ERROR);
+        }
+        return(param_convert_integer(dst, ntype, nsize, src, type, size));
+    case PTYPE_FLOAT:
+        if (type != PTYPE_FLOAT)
+        {
+            return(-RT_ERROR);
+        }
+        if ((size == sizeof(f32)) && (nsize == sizeof(f64)))
+        {
+            f32 f;
+            f64 d;
+            memcpy(&f, src, sizeof(f));
+            d = f;
+            memcpy(dst, &d, sizeof(d));
+            return(RT_EOK);
+        }
+        if ((size == sizeof(f64)) && (nsize == sizeof(f32)))
+        {
+            f64 d;
+            f32 f;
+            memcpy(&d, src, sizeof(d));
+            if (!((d >= -FLT_MAX) && (d <= FLT_MAX)))//out of range or not a number
+            {
+                return(-RT_ERROR);
+            }
+            f = (f32)d;
+            memcpy(dst, &f, sizeof(f));
+            return(RT_EOK);
+        }
+        return(-RT_ERROR);
+    default:
+        return(-RT_ERROR);
+    }
+}
+
+static void param_migrate_value(param_tbl_t *tbl, int mig_idx, const u8 *val)//value of saved param, the current one keeps default if it can not be converted
+{
+    param_mig_t *mig = &tbl->mig[mig_idx];
+    u8 buf[PARAM_VALUE_MAX];
+    int idx = mig->idx;
+    
+    if (idx == PARAM_MIG_NONE)
+    {
+        return;
+    }
+    if (param_convert_value(buf, tbl->msgs[idx].type, tbl->msgs[idx].size, val, mig->type, mig->size) != RT_EOK)
+    {
+        LOG_W("param %s is not migrated. type or size changed.", PARAM_MSG_NAME(tbl, idx));
+        return;
+    }
+    memcpy(tbl->datas + tbl->offsets[idx], buf, tbl->msgs[idx].size);
+    #ifdef PARAM_USING_OVERLAY
+    param_overlay_update(tbl, idx);
+    #endif
+}
+
+static int param_migrate_raw(param_tbl_t *tbl, param_reader_t *rd)
+{
+    u8 buf[PARAM_VALUE_MAX];
+    
+    param_values_reset(tbl);//params not in saved image read default
+    for (int i = 0; (i < tbl->mig_total) && (rd->rst == RT_EOK); i++)
+    {
+        if (param_reader_get(rd, buf, tbl->mig[i].size) == RT_EOK)
+        {
+            param_migrate_value(tbl, i, buf);
+        }
+    }
+    
+    return(rd->rst);
+}
+
+#ifdef PARAM_USING_OVERLAY
+static int param_migrate_sparse(param_tbl_t *tbl, param_reader_t *rd)
+{
+    u8 buf[PARAM_VALUE_MAX];
+    u16 total = 0;
+    int count = 0;
+    
+    param_reader_get(rd, &total, sizeof(total));
+    if ((rd->rst != RT_EOK) || (total != tbl->mig_total))
+    {
+        return(-RT_ERROR);
+    }
+    
+    //the saved map only gives the count of records
+    param_overlay_reset(tbl);
+    for (int i = 0; (i < (total + 7) / 8) && (rd->rst == RT_EOK); i++)
+    {
+        u8 bits = 0;
+        param_reader_get(rd, &bits, sizeof(bits));
+        for (; bits != 0; bits &= bits - 1)
+        {
+            count++;
+        }
+    }
+    
+    while ((count > 0) && (rd->rst == RT_EOK))
+    {
+        u16 idx = 0;
+        u8 len = 0;
+        
+        param_reader_get(rd, &idx, sizeof(idx));
+        param_reader_get(rd, &len, sizeof(len));
+        if ((rd->rst != RT_EOK) || (idx >= total) || (len > tbl->mig[idx].size))
+        {
+            return(-RT_ERROR);
+        }
+        memset(buf, 0, tbl->mig[idx].size);
+        if (param_reader_get(rd, buf, len) == RT_EOK)
+        {
+            param_migrate_value(tbl, idx, buf);
+        }
+        count--;
+    }
+    
+    return(rd->rst);
+}
+#endif
+#endif
+
+static int param_program_ext_to_addr(param_tbl_t *tbl, u32 addr)//the sector is erased
+{
+    param_writer_t wr;
+    param_ext_head_t head;
+    
+    //the head is written at last, so an interrupted write never looks valid
+    param_writer_init(&wr, tbl, addr+sizeof(head), tbl->comp);
+    #ifdef PARAM_USING_MIGRATE
+    param_dir_write(tbl, &wr);
+    #endif
+    #ifdef PARAM_USING_OVERLAY
+    head.format = PFMT_SPARSE;
+    param_encode_sparse(tbl, &wr);
+    #elif defined(PARAM_USING_XIP)
+    head.format = PFMT_RAW;
+    for (int i = 0; i < tbl->total; i++)//clean params are copied from the mapped image
+    {
+        u8 buf[PARAM_VALUE_MAX];
+        param_writer_put(&wr, param_xip_value(tbl, i, buf), tbl->msgs[i].size);
+    }
+    #else
+    head.format = PFMT_RAW;
+    param_writer_put(&wr, tbl->datas, tbl->size);
+    #endif
+    param_writer_finish(&wr);
+    if (wr.rst != RT_EOK)
+    {
+        LOG_E("param write fail. addr : %d", addr);
+        return(-RT_ERROR);
+    }
+    if (sizeof(head) + wr.out > PARAM_IMAGE_MAX)
+    {
+        LOG_E("param write fail. image is too big for one sector. addr : %d", addr);
+        return(-RT_ERROR);
+    }
+    
+    #ifdef PARAM_USING_MIGRATE
+    head.format |= PFMT_DIR;
+    #endif
+    head.magic = PARAM_MAGIC_EXT;
+    head.comp = wr.comp;
+    head.size = wr.out;
+    head.raw_size = wr.size;
+    head.crc16 = wr.crc16;
+    head.head_crc16 = PARAM_CRC16_CAL((u8*)&head, sizeof(head)-2);
+    if (param_flash_write(tbl, addr, (u8*)&head, sizeof(head)) < 0)
+    {
+        LOG_E("param head write fail. addr : %d", addr);
+        return(-RT_ERROR);
+    }
+    LOG_D("param write success. addr : %d, size : %d/%d", addr, wr.out, wr.size);
+    return(RT_EOK);
+}
+
+#if !defined(PARAM_USING_PRE_ERASE) || defined(PARAM_USING_PRESET)//the slots of PARAM_USING_PRE_ERASE are erased apart
+static int param_write_ext_to_addr(param_tbl_t *tbl, u32 addr)
+{
+    if (( ! PARAM_TBL_IN_PLACE(tbl)) && (param_flash_erase(tbl, addr, PARAM_SECTOR_SIZE) < 0))
+    {
+        LOG_E("param sector erease fail. addr : %d", addr);
+        return(-RT_ERROR);
+    }
+    return(param_program_ext_to_addr(tbl, addr));
+}
+#endif
+
+#ifdef PARAM_USING_MIGRATE
+static int param_migrate_finish(param_tbl_t *tbl)//write back the migrated image once
+{
+    int rst = RT_EOK;
+    
+    param_migrate_free(tbl);
+    #ifdef PARAM_USING_PRESET
+    if (tbl->preset_cur >= 0)//a preset is live, it is written back to its own sector
+    {
+        if (param_preset_write(tbl, tbl->preset_cur) != RT_EOK)
+        {
+            rst = -RT_ERROR;
+        }
+    }
+    else
+    #endif
+    #ifdef PARAM_USING_PRE_ERASE
+    if (param_slot_save(tbl) != RT_EOK)
+    {
+        rst = -RT_ERROR;
+    }
+    #elif defined(PARAM_USING_DUAL)
+    if (param_dual_save(tbl) != RT_EOK)
+    {
+        rst = -RT_ERROR;
+    }
+    #else
+    if ((param_write_ext_to_addr(tbl, tbl->cfg.save_addr) != RT_EOK)
+        || (param_write_ext_to_addr(tbl, tbl->cfg.save_addr_bak) != RT_EOK))
+    {
+        rst = -RT_ERROR;
+    }
+    #endif
+    #ifdef PARAM_USING_JOURNAL
+    if (param_journal_compact(tbl) != RT_EOK)//snapshot in current layout
+    {
+        rst = -RT_ERROR;
+    }
+    #endif
+    
+    return(rst);
+}
+#endif
+
+#ifndef PARAM_USING_XIP
+static int param_read_ext_from_addr(param_tbl_t *tbl, u32 addr)
+{
+    param_reader_t rd;
+    param_ext_head_t head;
+    int rst = -RT_ERROR;
+    int format, size;
+    
+    if (param_flash_read(tbl, addr, (u8*)&head, sizeof(head)) < 0)
+    {
+        LOG_E("param head read fail. addr : %d", addr);
+        return(-RT_ERROR);
+    }
+    if (PARAM_CRC16_CAL((u8*)&head, sizeof(head)-2) != head.head_crc16)
+    {
+        LOG_E("param head check fail. addr : %d", addr);
+        PARAM_STAT_INC(tbl, crc_fails);
+        return(-RT_ERROR);
+    }
+    #ifdef PARAM_USING_COMPRESS
+    if (head.comp != PCOMP_NONE && head.comp != PCOMP_RLE)
+    #else
+    if (head.comp != PCOMP_NONE)
+    #endif
+    {
+        LOG_E("param compression type unsupported. addr : %d", addr);
+        return(-RT_ERROR);
+    }
+    
+    param_reader_init(&rd, tbl, addr+sizeof(head), head.raw_size, head.comp, head.size);
+    format = head.format;
+    size = head.raw_size;
+    #ifdef PARAM_USING_MIGRATE
+    if (format & PFMT_DIR)
+    {
+        format &= ~PFMT_DIR;
+        if (param_dir_read(tbl, &rd, addr, &head) != RT_EOK)
+        {
+            LOG_E("param directory read fail. addr : %d", addr);
+            return(-RT_ERROR);
+        }
+        size -= PARAM_DIR_SIZE((tbl->mig != NULL) ? tbl->mig_total : tbl->total);
+    }
+    #endif
+    switch (format)
+    {
+    case PFMT_RAW:
+        #ifdef PARAM_USING_MIGRATE
+        if (tbl->mig != NULL)
+        {
+            rst = param_migrate_raw(tbl, &rd);
+            break;
+        }
+        #endif
+        if (size > tbl->size)
+        {
+            LOG_E("param size check fail. addr : %d", addr);
+            return(-RT_ERROR);
+        }
+        rst = param_reader_get(&rd, tbl->datas, size);
+        break;
+    #ifdef PARAM_USING_OVERLAY
+    case PFMT_SPARSE:
+        #ifdef PARAM_USING_MIGRATE
+        if (tbl->mig != NULL)
+        {
+            rst = param_migrate_sparse(tbl, &rd);
+            break;
+        }
+        #endif
+        rst = param_decode_sparse(tbl, &rd);
+        break;
+    #endif
+    default:
+        LOG_E("param format unsupported. addr : %d", addr);
+        #ifdef PARAM_USING_MIGRATE
+        param_migrate_free(tbl);
+        #endif
+        return(-RT_ERROR);
+    }
+    
+    if ((rst != RT_EOK) || (param_reader_check(&rd, head.crc16) != RT_EOK))
+    {
+        LOG_E("param check fail. addr : %d", addr);
+        PARAM_STAT_INC(tbl, crc_fails);
+        #ifdef PARAM_USING_OVERLAY
+        param_overlay_reset(tbl);
+        #endif
+        #ifdef PARAM_USING_MIGRATE
+        param_migrate_free(tbl);
+        #endif
+        return(-RT_ERROR);
+    }
+    
+    #ifdef PARAM_USING_OVERLAY
+    if (format == PFMT_RAW)
+    {
+        param_overlay_rebuild(tbl);
+    }
+    #endif
+    LOG_D("param read success. addr : %d, size : %d/%d", addr, head.size, head.raw_size);
+    return(RT_EOK);
+}
+#endif
+#endif
+
+#ifdef PARAM_USING_XIP
+static int param_xip_map(param_tbl_t *tbl, u32 addr)//verify the image in place, then params are read from it
+{
+    union
+    {
+        param_head_t head;
+        param_ext_head_t ext;
+    }h;
+    const u8 *base = param_xip_addr(tbl, addr);
+    int size;
+    u16 crc16;
+    
+    if (base == NULL)
+    {
+        LOG_E("param flash is not mapped. addr : %d", addr);
+        return(-RT_ERROR);
+    }
+    if (param_flash_read(tbl, addr, (u8*)&h, sizeof(h)) < 0)
+    {
+        LOG_E("param head read fail. addr : %d", addr);
+        return(-RT_ERROR);
+    }
+    if (h.ext.magic == PARAM_MAGIC_EXT)
+    {
+        if (PARAM_CRC16_CAL((u8*)&h.ext, sizeof(h.ext)-2) != h.ext.head_crc16)
+        {
+            LOG_E("param head check fail. addr : %d", addr);
+            PARAM_STAT_INC(tbl, crc_fails);
+            return(-RT_ERROR);
+        }
+        if ((h.ext.format != PFMT_RAW) || (h.ext.comp != PCOMP_NONE))
+        {
+            LOG_E("param image can not be mapped. addr : %d", addr);
+            return(-RT_ERROR);
+        }
+        base += sizeof(h.ext);
+        size = h.ext.raw_size;
+        crc16 = h.ext.crc16;
+    }
+    else
+    {
+        if (param_head_check(&h.head) < 0)
+        {
+            LOG_E("param head check fail. addr : %d", addr);
+            PARAM_STAT_ADD(tbl, crc_fails, (h.head.magic == PARAM_MAGIC_WORD));//blank flash is not counted
+            return(-RT_ERROR);
+        }
+        base += sizeof(h.head);
+        size = h.head.size;
+        crc16 = h.head.crc16;
+    }
+    if (size > tbl->size)
+    {
+        LOG_E("param size check fail. addr : %d", addr);
+        return(-RT_ERROR);
+    }
+    if (PARAM_CRC16_CAL((u8 *)base, size) != crc16)
+    {
+        LOG_E("param check fail. addr : %d", addr);
+        PARAM_STAT_INC(tbl, crc_fails);
+        return(-RT_ERROR);
+    }
+    
+    tbl->xip_base = base;
+    tbl->xip_addr = addr;
+    tbl->xip_size = size;
+    LOG_D("param map success. addr : %d, size : %d", addr, size);
+    return(RT_EOK);
+}
+
+static int param_xip_flush(param_tbl_t *tbl)//save params, then map the new image and release all shadows
+{
+    u32 addr = tbl->cfg.save_addr;
+    u32 other = tbl->cfg.save_addr_bak;
+    
+    //the mapped image is the source of clean params, so the other copy is written first
+    if ((tbl->xip_base != NULL) && (tbl->xip_addr == tbl->cfg.save_addr))
+    {
+        addr = tbl->cfg.save_addr_bak;
+        other = tbl->cfg.save_addr;
+    }
+    
+    if ((param_write_ext_to_addr(tbl, addr) != RT_EOK) || (param_xip_map(tbl, addr) != RT_EOK))
+    {
+        return(-RT_ERROR);
+    }
+    param_xip_release(tbl);
+    #ifdef PARAM_USING_PRESET
+    param_preset_release(tbl);
+    #endif
+    if (param_write_ext_to_addr(tbl, other) != RT_EOK)
+    {
+        LOG_E("param backup write fail. addr : %d", other);
+    }
+    return(RT_EOK);
+}
+#endif
+
+#ifndef PARAM_USING_EXT_IMAGE
+static int param_program_to_addr(param_tbl_t *tbl, u32 addr, param_head_t *head)//the sector is erased
+{
+    //the head is written at last, so an interrupted write never looks valid
+    if (param_flash_program(tbl, addr+sizeof(param_head_t), (u8*)tbl->datas, tbl->size) < 0)
+    {
+        LOG_E("param write fail. addr : %d", addr);
+        return(-RT_ERROR);
+    }
+    if (param_flash_write(tbl, addr, (u8*)head, sizeof(param_head_t)) < 0)
+    {
+        LOG_E("param head write fail. addr : %d", addr);
+        return(-RT_ERROR);
+    }
+    LOG_D("param write success. addr : %d", addr);
+    return(RT_EOK);
+}
+
+#ifndef PARAM_USING_PRE_ERASE
+static int param_write_to_addr(param_tbl_t *tbl, u32 addr, param_head_t *head)
+{
+    if (( ! PARAM_TBL_IN_PLACE(tbl)) && (param_flash_erase(tbl, addr, PARAM_SECTOR_SIZE) < 0))
+    {
+        LOG_E("param sector erease fail. addr : %d", addr);
+        return(-RT_ERROR);
+    }
+    return(param_program_to_addr(tbl, addr, head));
+}
+#endif
+#endif
+
+#ifndef PARAM_USING_XIP
+static int param_read_from_addr(param_tbl_t *tbl, u32 addr)
+{
+    param_head_t head;
+    
+    if (param_flash_read(tbl, addr, (u8*)&head, sizeof(head)) < 0)
+    {
+        LOG_E("param head read fail. addr : %d", addr);
+        return(-RT_ERROR);
+    }
+    #ifdef PARAM_USING_EXT_IMAGE
+    if (head.magic == PARAM_MAGIC_EXT)
+    {
+        return(param_read_ext_from_addr(tbl, addr));
+    }
+    #endif
+    if (param_head_check(&head) < 0)
+    {
+        LOG_E("param head check fail. addr : %d", addr);
+        PARAM_STAT_ADD(tbl, crc_fails, (head.magic == PARAM_MAGIC_WORD));//blank flash is not counted
+        return(-RT_ERROR);
+    }
+    if (head.size > tbl->size)
+    {
+        LOG_E("param size check fail. addr : %d", addr);
+        return(-RT_ERROR);
+    }
+    if (param_flash_read(tbl, addr+sizeof(head), (u8*)tbl->datas, head.size) < 0)
+    {
+        LOG_E("param read fail. addr : %d", addr);
+        return(-RT_ERROR);
+    }
+    if (param_check(tbl, &head) < 0)
+    {
+        LOG_E("param check fail. addr : %d", addr);
+        PARAM_STAT_INC(tbl, crc_fails);
+        return(-RT_ERROR);
+    }
+    #ifdef PARAM_USING_OVERLAY
+    param_overlay_rebuild(tbl);
+    #endif
+    LOG_D("param read success. addr : %d", addr);
+    return(RT_EOK);
+}
+#endif
+
+#if defined(PARAM_USING_PRE_ERASE) || defined(PARAM_USING_DUAL)
+static int param_tag_read(param_tbl_t *tbl, u32 addr, u32 *seq)//sequence of the image at addr
+{
+    param_slot_tag_t tag;
+    
+    if ((param_flash_read(tbl, addr + PARAM_IMAGE_MAX, (u8*)&tag, sizeof(tag)) < 0)
+        || (tag.magic != PARAM_MAGIC_SLOT) || (PARAM_CRC16_CAL((u8*)&tag, sizeof(tag)-2) != tag.crc16))
+    {
+        return(-RT_ERROR);
+    }
+    *seq = tag.seq;
+    return(RT_EOK);
+}
+
+static int param_tag_write(param_tbl_t *tbl, u32 addr, u32 seq)
+{
+    param_slot_tag_t tag;
+    
+    tag.seq = seq;
+    tag.magic = PARAM_MAGIC_SLOT;
+    tag.crc16 = PARAM_CRC16_CAL((u8*)&tag, sizeof(tag)-2);
+    if (param_flash_write(tbl, addr + PARAM_IMAGE_MAX, (u8*)&tag, sizeof(tag)) < 0)
+    {
+        LOG_E("param image tag write fail. addr : %d", addr);
+        return(-RT_ERROR);
+    }
+    return(RT_EOK);
+}
+#endif
+
+#ifdef PARAM_USING_DUAL
+#if PARAM_DUAL_THREAD_PRIORITY > 0
+static rt_sem_t param_dual_start = NULL;    //a backup copy is requested
+static rt_sem_t param_dual_done = NULL;     //the backup copy is written
+static rt_mutex_t param_dual_lock = NULL;   //the thread writes for one table at a time
+static u32 param_dual_addr;                 //address of the request
+static u32 param_dual_seq;                  //sequence of the request
+static int param_dual_rst;                  //result of the request
+#endif
+
+static int param_dual_write(param_tbl_t *tbl, u32 addr, u32 seq)//write one copy, the tag is written after the image
+{
+    int rst;
+    #ifndef PARAM_USING_EXT_IMAGE
+    param_head_t head;
+    #endif
+    
+    #ifdef PARAM_USING_EXT_IMAGE
+    rst = param_write_ext_to_addr(tbl, addr);
+    #else
+    param_head_update(tbl, &head);
+    rst = param_write_to_addr(tbl, addr, &head);
+    #endif
+    if (rst == RT_EOK)
+    {
+        rst = param_tag_write(tbl, addr, seq);
+    }
+    return(rst);
+}
+
+#if PARAM_DUAL_THREAD_PRIORITY > 0
+static void param_dual_entry(void *parameter)//writes the backup copy while the saving thread writes the primary one
+{
+    while (1)
+    {
+        rt_sem_take(param_dual_start, RT_WAITING_FOREVER);
+        param_dual_rst = param_dual_write(param_dual_tbl, param_dual_addr, param_dual_seq);
+        rt_sem_release(param_dual_done);
+    }
+}
+
+static void param_dual_merge(param_tbl_t *tbl)//counters of the thread are added to the table after the copy is written
+{
+    #ifdef PARAM_USING_STATS
+    param_stats_t *st = &param_dual_stats;
+    
+    tbl->stats.write_yields += st->write_yields;
+    if (st->write_step_max_us > tbl->stats.write_step_max_us)
+    {
+        tbl->stats.write_step_max_us = st->write_step_max_us;
+    }
+    for (int i = 0; i < PSTAT_RGN_TOTAL; i++)
+    {
+        tbl->stats.erase_bytes[i] += st->erase_bytes[i];
+        tbl->stats.prog_bytes[i] += st->prog_bytes[i];
+    }
+    for (int i = 0; (i < PARAM_STATS_SECTORS) && (st->sectors[i].erases != 0); i++)
+    {
+        param_stat_sector(&tbl->stats, st->sectors[i].addr, st->sectors[i].erases);
+    }
+    memset(st, 0, sizeof(*st));
+    #endif
+}
+
+static int param_dual_same_dev(param_tbl_t *tbl)//both copies are on one flash device, they can not be written at the same time
+{
+    const struct fal_partition *part, *bak;
+    
+    #ifdef PARAM_USING_BACKEND
+    if (tbl->cfg.backend != &param_backend_fal)
+    {
+        return(tbl->dev == tbl->dev_bak);
+    }
+    #endif
+    part = (const struct fal_partition *)PARAM_TBL_STORAGE(tbl);
+    bak = (const struct fal_partition *)PARAM_TBL_STORAGE_BAK(tbl);
+    return(strcmp(part->flash_name, bak->flash_name) == 0);
+}
+
+static int param_dual_thread_init(void)
+{
+    rt_thread_t thread = NULL;
+    
+    if (param_dual_lock != NULL)
+    {
+        return(RT_EOK);
+    }
+    
+    param_dual_start = rt_sem_create("par_dst", 0, RT_IPC_FLAG_FIFO);
+    param_dual_done = rt_sem_create("par_ddn", 0, RT_IPC_FLAG_FIFO);
+    param_dual_lock = PARAM_MUTEX_CREATE();
+    if ((param_dual_start != NULL) && (param_dual_done != NULL) && (param_dual_lock != NULL))
+    {
+        thread = rt_thread_create("par_dual", param_dual_entry, NULL, PARAM_DUAL_THREAD_STACK, PARAM_DUAL_THREAD_PRIORITY, 10);
+    }
+    if (thread == NULL)
+    {
+        if (param_dual_start != NULL)
+        {
+            rt_sem_delete(param_dual_start);
+            param_dual_start = NULL;
+        }
+        if (param_dual_done != NULL)
+        {
+            rt_sem_delete(param_dual_done);
+            param_dual_done = NULL;
+        }
+        if (param_dual_lock != NULL)
+        {
+            PARAM_MUTEX_DELETE(param_dual_lock);
+            param_dual_lock = NULL;
+        }
+        return(-RT_ENOMEM);
+    }
+    rt_thread_startup(thread);
+    return(RT_EOK);
+}
+#endif
+
+/*
+ * each storage has two sectors used by turns, sequence n is written to sector n & 1 of both,
+ * so the sectors being written never hold the newest image, a power loss leaves it on both storages
+ */
+static int param_dual_save(param_tbl_t *tbl)//both copies with a new sequence, the newest valid one is loaded
+{
+    u32 seq = tbl->dual_seq + 1;
+    u32 off = (seq & 1) * PARAM_SECTOR_SIZE;
+    int rst1, rst2;
+    
+    #if PARAM_DUAL_THREAD_PRIORITY > 0
+    if ( ! param_dual_same_dev(tbl))
+    {
+        PARAM_MUTEX_TAKE(param_dual_lock);
+        param_dual_tbl = tbl;
+        param_dual_addr = (tbl->cfg.save_addr_bak + off) | PARAM_ADDR_BAK;
+        param_dual_seq = seq;
+        #ifdef PARAM_USING_PACED_WRITE
+        param_dual_write_us = 0;
+        #endif
+        rt_sem_release(param_dual_start);
+        rst1 = param_dual_write(tbl, tbl->cfg.save_addr + off, seq);//stats and pacing of the table are only used by this thread
+        rt_sem_take(param_dual_done, RT_WAITING_FOREVER);
+        param_dual_tbl = NULL;
+        rst2 = param_dual_rst;
+        param_dual_merge(tbl);
+        PARAM_MUTEX_RELEASE(param_dual_lock);
+    }
+    else
+    #endif
+    {
+        rst1 = param_dual_write(tbl, tbl->cfg.save_addr + off, seq);
+        rst2 = param_dual_write(tbl, (tbl->cfg.save_addr_bak + off) | PARAM_ADDR_BAK, seq);
+    }
+    if ((rst1 != RT_EOK) && (rst2 != RT_EOK))
+    {
+        return(-RT_ERROR);
+    }
+    tbl->dual_seq = seq;
+    return(RT_EOK);
+}
+
+static int param_dual_load(param_tbl_t *tbl)//the copy of the newest sequence first, copies without tag are the oldest
+{
+    u32 addrs[4] = {tbl->cfg.save_addr, tbl->cfg.save_addr_bak | PARAM_ADDR_BAK,
+                    tbl->cfg.save_addr + PARAM_SECTOR_SIZE, (tbl->cfg.save_addr_bak + PARAM_SECTOR_SIZE) | PARAM_ADDR_BAK};
+    u32 seqs[4] = {0, 0, 0, 0};
+    int order[4] = {0, 1, 2, 3};
+    
+    for (int i = 0; i < 4; i++)
+    {
+        param_tag_read(tbl, addrs[i], &seqs[i]);
+    }
+    for (int i = 1; i < 4; i++)//newest first, the primary storage first of the same sequence
+    {
+        for (int j = i; (j > 0) && (seqs[order[j]] > seqs[order[j - 1]]); j--)
+        {
+            int t = order[j];
+            order[j] = order[j - 1];
+            order[j - 1] = t;
+        }
+    }
+    tbl->dual_seq = seqs[order[0]];
+    for (int i = 0; i < 4; i++)
+    {
+        if (param_read_from_addr(tbl, addrs[order[i]]) == RT_EOK)
+        {
+            LOG_D("param load success from %s copy.", (addrs[order[i]] & PARAM_ADDR_BAK) ? "backup" : "primary");
+            PARAM_STAT_ADD(tbl, backup_loads, (i > 0));
+            return(RT_EOK);
+        }
+    }
+    return(-RT_ERROR);
+}
+#endif
+
+#ifdef PARAM_USING_PRESET
+#define PARAM_PRESET_NONE                   0xFF    //selector record of the saved image
+#define PARAM_SEL_RECS                      (PARAM_SECTOR_SIZE / sizeof(param_sel_rec_t))
+
+typedef struct
+{
+    u16 magic;          //PARAM_MAGIC_PRESET
+    u8 preset;          //preset of the live image, PARAM_PRESET_NONE - the saved image
+    u8 reserved;
+    u16 seq;            //sequence of record, compared with wrap around
+    u16 crc16;
+}param_sel_rec_t;       //appended to selector sector, the last valid one is in effect
+
+static u32 param_preset_addr(param_tbl_t *tbl, int preset)
+{
+    return(tbl->cfg.preset_addr + (PARAM_SEL_SECTORS + preset) * PARAM_SECTOR_SIZE);
+}
+
+static int param_preset_find(param_tbl_t *tbl, const char *name)
+{
+    for (int i = 0; (name != NULL) && (i < tbl->cfg.preset_total); i++)
+    {
+        if (strcmp(tbl->cfg.presets[i], name) == 0)
+        {
+            return(i);
+        }
+    }
+    LOG_E("param preset find fail. name : %s", (name != NULL) ? name : "");
+    return(-RT_ERROR);
+}
+
+static int param_sel_read(param_tbl_t *tbl, int sector, int pos, param_sel_rec_t *rec)//1 - blank, 0 - valid, <0 - broken
+{
+    u32 addr = tbl->cfg.preset_addr + sector * PARAM_SECTOR_SIZE + pos * sizeof(param_sel_rec_t);
+    const u8 *p = (const u8 *)rec;
+    int blank = 1;
+    
+    if (param_flash_read(tbl, addr, (u8 *)rec, sizeof(param_sel_rec_t)) < 0)
+    {
+        return(-RT_ERROR);
+    }
+    for (int i = 0; i < (int)sizeof(param_sel_rec_t); i++)
+    {
+        blank &= (p[i] == 0xFF);
+    }
+    if (blank)
+    {
+        return(1);
+    }
+    if ((rec->magic != PARAM_MAGIC_PRESET) || (PARAM_CRC16_CAL((u8 *)rec, sizeof(param_sel_rec_t)-2) != rec->crc16))
+    {
+        return(-RT_ERROR);
+    }
+    return(0);
+}
+
+static int param_sel_scan(param_tbl_t *tbl)//find the record in effect, return its preset, PARAM_PRESET_NONE - none
+{
+    param_sel_rec_t rec, last;
+    int preset = PARAM_PRESET_NONE;
+    
+    tbl->sel_sector = -1;
+    tbl->sel_pos = 0;
+    tbl->sel_seq = 0;
+    for (int s = 0; s < PARAM_SEL_SECTORS; s++)
+    {
+        int lo = 0, hi = PARAM_SEL_RECS, pos;
+        
+        while (lo < hi)//records are appended, so the used ones are a prefix of the sector
+        {
+            int mid = (lo + hi) / 2;
+            if (param_sel_read(tbl, s, mid, &rec) == 1)
+            {
+                hi = mid;
+            }
+            else
+            {
+                lo = mid + 1;
+            }
+        }
+        for (pos = lo - 1; pos >= lo - 2; pos--)//the last record may be cut by power loss
+        {
+            if ((pos >= 0) && (param_sel_read(tbl, s, pos, &last) == 0))
+            {
+                break;
+            }
+        }
+        if ((pos < lo - 2) || (pos < 0))
+        {
+            continue;
+        }
+        if ((tbl->sel_sector < 0) || ((s16)(last.seq - tbl->sel_seq) > 0))
+        {
+            tbl->sel_sector = s;
+            tbl->sel_pos = lo;
+            tbl->sel_seq = last.seq;
+            preset = last.preset;
+        }
+    }
+    return(preset);
+}
+
+static int param_sel_write(param_tbl_t *tbl, int preset)//append a record, the other sector is erased when the sector is full
+{
+    param_sel_rec_t rec;
+    u32 addr;
+    
+    if (tbl->sel_sector == -2)
+    {
+        param_sel_scan(tbl);
+    }
+    if ((tbl->sel_sector < 0) || (tbl->sel_pos >= PARAM_SEL_RECS))
+    {
+        int sector = (tbl->sel_sector == 0) ? 1 : 0;
+        if (param_flash_erase(tbl, tbl->cfg.preset_addr + sector * PARAM_SECTOR_SIZE, PARAM_SECTOR_SIZE) < 0)
+        {
+            LOG_E("param preset selector erase fail. addr : %d", tbl->cfg.preset_addr + sector * PARAM_SECTOR_SIZE);
+            return(-RT_ERROR);
+        }
+        tbl->sel_sector = sector;
+        tbl->sel_pos = 0;
+    }
+    
+    rec.magic = PARAM_MAGIC_PRESET;
+    rec.preset = preset;
+    rec.reserved = 0xFF;
+    rec.seq = tbl->sel_seq + 1;
+    rec.crc16 = PARAM_CRC16_CAL((u8 *)&rec, sizeof(rec)-2);
+    addr = tbl->cfg.preset_addr + tbl->sel_sector * PARAM_SECTOR_SIZE + tbl->sel_pos * sizeof(rec);
+    tbl->sel_pos++;//a failed record is skipped
+    if (param_flash_write(tbl, addr, (u8 *)&rec, sizeof(rec)) < 0)
+    {
+        LOG_E("param preset selector write fail. addr : %d", addr);
+        return(-RT_ERROR);
+    }
+    tbl->sel_seq = rec.seq;
+    return(RT_EOK);
+}
+
+static int param_preset_write(param_tbl_t *tbl, int preset)//live values to the preset sector
+{
+    u32 addr = param_preset_addr(tbl, preset);
+    #ifdef PARAM_USING_EXT_IMAGE
+    return(param_write_ext_to_addr(tbl, addr));
+    #else
+    param_head_t head;
+    
+    if (( ! PARAM_TBL_IN_PLACE(tbl)) && (param_flash_erase(tbl, addr, PARAM_SECTOR_SIZE) < 0))
+    {
+        LOG_E("param sector erease fail. addr : %d", addr);
+        return(-RT_ERROR);
+    }
+    param_head_update(tbl, &head);
+    return(param_program_to_addr(tbl, addr, &head));
+    #endif
+}
+
+static int param_preset_load(param_tbl_t *tbl)//load the preset in effect, -RT_EEMPTY - the saved image is live
+{
+    int preset = param_sel_scan(tbl);
+    
+    tbl->preset_cur = -1;
+    if ((preset == PARAM_PRESET_NONE) || (preset >= tbl->cfg.preset_total))
+    {
+        return(-RT_EEMPTY);
+    }
+    #ifdef PARAM_USING_XIP
+    if (param_xip_map(tbl, param_preset_addr(tbl, preset)) != RT_EOK)
+    #else
+    if (param_read_from_addr(tbl, param_preset_addr(tbl, preset)) != RT_EOK)
+    #endif
+    {
+        LOG_E("param preset %s load fail, the saved image is loaded.", tbl->cfg.presets[preset]);
+        return(-RT_EEMPTY);
+    }
+    tbl->preset_cur = preset;
+    return(RT_EOK);
+}
+
+static void param_preset_release(param_tbl_t *tbl)//the saved image is written, it is live again
+{
+    if ((tbl->preset_cur >= 0) && (param_sel_write(tbl, PARAM_PRESET_NONE) == RT_EOK))
+    {
+        tbl->preset_cur = -1;
+    }
+}
+
+static int param_preset_commit(param_tbl_t *tbl, int preset)//the selector record puts the values of the preset in effect
+{
+    #ifdef PARAM_USING_JOURNAL
+    int sector = tbl->jnl_sector;
+    u32 pos = tbl->jnl_pos;
+    
+    //journal params follow the preset too, their snapshot waits for the selector record
+    if (tbl->sel_sector == -2)
+    {
+        param_sel_scan(tbl);
+    }
+    if (param_journal_snapshot(tbl, (u16)(tbl->sel_seq + 1)) != RT_EOK)
+    {
+        return(-RT_ERROR);
+    }
+    if (param_sel_write(tbl, preset) != RT_EOK)
+    {
+        tbl->jnl_sector = sector;//records go on after the old snapshot, the new one is never loaded
+        tbl->jnl_pos = pos;
+        return(-RT_ERROR);
+    }
+    return(RT_EOK);
+    #else
+    return(param_sel_write(tbl, preset));
+    #endif
+}
+
+static int param_preset_apply(param_tbl_t *tbl, int preset)//the live image becomes the preset, restored if the selector is not written
+{
+    u32 addr = param_preset_addr(tbl, preset);
+    #ifdef PARAM_USING_XIP
+    const u8 *base = tbl->xip_base;
+    u32 xaddr = tbl->xip_addr;
+    u16 size = tbl->xip_size;
+    
+    if (param_xip_map(tbl, addr) != RT_EOK)
+    {
+        return(-RT_ERROR);
+    }
+    if (param_preset_commit(tbl, preset) != RT_EOK)
+    {
+        tbl->xip_base = base;
+        tbl->xip_addr = xaddr;
+        tbl->xip_size = size;
+        return(-RT_ERROR);
+    }
+    param_xip_release(tbl);//unsaved changes are dropped, volatile params keep theirs
+    #else
+    u8 *live = malloc(tbl->size);//the whole image is read and checked, the live values are kept until the switch is done
+    int rst;
+    
+    if (live == NULL)
+    {
+        LOG_E("param preset switch fail. no memory.");
+        return(-RT_ENOMEM);
+    }
+    memcpy(live, tbl->datas, tbl->size);
+    rst = param_read_from_addr(tbl, addr);
+    #ifdef PARAM_USING_MIGRATE
+    if ((rst == RT_EOK) && (tbl->mig != NULL))//preset of old layout, written back once
+    {
+        param_migrate_free(tbl);
+        rst = param_preset_write(tbl, preset);
+    }
+    #endif
+    if (rst == RT_EOK)
+    {
+        rst = param_preset_commit(tbl, preset);
+    }
+    if (rst != RT_EOK)
+    {
+        memcpy(tbl->datas, live, tbl->size);
+    }
+    else
+    {
+        for (int i = 0; i < tbl->total; i++)//volatile params keep their values
+        {
+            if (param_is_volatile(tbl, i))
+            {
+                memcpy(tbl->datas + tbl->offsets[i], live + tbl->offsets[i], tbl->msgs[i].size);
+            }
+        }
+    }
+    #ifdef PARAM_USING_OVERLAY
+    param_overlay_rebuild(tbl);
+    #endif
+    free(live);
+    if (rst != RT_EOK)
+    {
+        return(-RT_ERROR);
+    }
+    #endif
+    
+    PARAM_GEN_STAMP_ALL(tbl);
+    tbl->preset_cur = preset;
+    return(RT_EOK);
+}
+#endif
+
+#ifdef PARAM_USING_PRE_ERASE
+#if PARAM_ERASE_THREAD_PRIORITY > 0
+static rt_sem_t param_erase_sem = NULL;
+
+static void param_erase_entry(void *parameter)//erases the retired slots of all tables in background
+{
+    while (1)
+    {
+        rt_slist_t *node;
+        
+        rt_sem_take(param_erase_sem, RT_WAITING_FOREVER);
+        rt_slist_for_each(node, &param_tbl_list)
+        {
+            param_tbl_pre_erase(rt_slist_entry(node, param_tbl_t, list));
+        }
+    }
+}
+
+static int param_erase_thread_init(void)
+{
+    rt_thread_t thread;
+    
+    if (param_erase_sem != NULL)
+    {
+        return(RT_EOK);
+    }
+    
+    param_erase_sem = rt_sem_create("par_ers", 0, RT_IPC_FLAG_FIFO);
+    if (param_erase_sem == NULL)
+    {
+        return(-RT_ENOMEM);
+    }
+    thread = rt_thread_create("par_ers", param_erase_entry, NULL, PARAM_ERASE_THREAD_STACK, PARAM_ERASE_THREAD_PRIORITY, 10);
+    if (thread == NULL)
+    {
+        rt_sem_delete(param_erase_sem);
+        param_erase_sem = NULL;
+        return(-RT_ENOMEM);
+    }
+    rt_thread_startup(thread);
+    return(RT_EOK);
+}
+#endif
+
+static u32 param_slot_addr(param_tbl_t *tbl, int slot)
+{
+    return((slot == 0) ? tbl->cfg.save_addr : (slot == 1) ? tbl->cfg.save_addr_bak : tbl->cfg.spare_addr);
+}
+
+static int param_slot_next(param_tbl_t *tbl)//slot written by the next save, the oldest one
+{
+    return((tbl->slot_cur + 1) % PARAM_SLOTS);
+}
+
+static void param_slot_retire(param_tbl_t *tbl)//next slot is waiting for erase
+{
+    if (PARAM_TBL_IN_PLACE(tbl))//the oldest image is updated in place, it is never erased
+    {
+        tbl->slot_ready = 1;
+        tbl->slot_pending = 0;
+        return;
+    }
+    tbl->slot_ready = 0;
+    tbl->slot_pending = 1;
+    #if PARAM_ERASE_THREAD_PRIORITY > 0
+    if (param_erase_sem != NULL)
+    {
+        rt_sem_release(param_erase_sem);
+    }
+    #endif
+}
+
+static int param_slot_blank(param_tbl_t *tbl, int slot)
+{
+    u32 addr = param_slot_addr(tbl, slot);
+    u32 buf[16];
+    
+    for (int pos = 0; pos < PARAM_SECTOR_SIZE; pos += sizeof(buf))
+    {
+        if (param_flash_read(tbl, addr + pos, (u8*)buf, sizeof(buf)) < 0)
+        {
+            return(0);
+        }
+        for (int i = 0; i < (int)(sizeof(buf)/sizeof(buf[0])); i++)
+        {
+            if (buf[i] != 0xFFFFFFFF)
+            {
+                return(0);
+            }
+        }
+    }
+    return(1);
+}
+
+static int param_slot_save(param_tbl_t *tbl)//program the image to the erased next slot, then retire the oldest slot
+{
+    int slot = param_slot_next(tbl);
+    u32 addr = param_slot_addr(tbl, slot);
+    int rst;
+    #ifndef PARAM_USING_EXT_IMAGE
+    param_head_t head;
+    #endif
+    
+    if (( ! tbl->slot_ready) && ( ! PARAM_TBL_IN_PLACE(tbl)) && (param_flash_erase(tbl, addr, PARAM_SECTOR_SIZE) < 0))//background erase not done yet
+    {
+        LOG_E("param sector erease fail. addr : %d", addr);
+        param_slot_retire(tbl);
+        return(-RT_ERROR);
+    }
+    tbl->slot_ready = 0;
+    
+    #ifdef PARAM_USING_EXT_IMAGE
+    rst = param_program_ext_to_addr(tbl, addr);
+    #else
+    param_head_update(tbl, &head);
+    rst = param_program_to_addr(tbl, addr, &head);
+    #endif
+    if (rst == RT_EOK)//the tag is written after the head, an image without tag is only loaded when no tagged image is valid
+    {
+        rst = param_tag_write(tbl, addr, tbl->slot_seq + 1);
+    }
+    if (rst != RT_EOK)//the slot stays next, it is erased again
+    {
+        param_slot_retire(tbl);
+        return(-RT_ERROR);
+    }
+    
+    tbl->slot_seq++;
+    tbl->slot_cur = slot;
+    param_slot_retire(tbl);
+    return(RT_EOK);
+}
+
+static int param_slot_load(param_tbl_t *tbl)//load the newest valid image, older ones are backups
+{
+    int order[PARAM_SLOTS];
+    u32 seqs[PARAM_SLOTS];
+    int rst = -RT_ERROR;
+    
+    tbl->slot_seq = 0;
+    for (int i = 0; i < PARAM_SLOTS; i++)//sorted by sequence, slots without tag are the oldest
+    {
+        int pos = i;
+        u32 seq = 0;
+        
+        param_tag_read(tbl, param_slot_addr(tbl, i), &seq);
+        while ((pos > 0) && (seqs[pos - 1] < seq))
+        {
+            order[pos] = order[pos - 1];
+            seqs[pos] = seqs[pos - 1];
+            pos--;
+        }
+        order[pos] = i;
+        seqs[pos] = seq;
+        if (seq > tbl->slot_seq)
+        {
+            tbl->slot_seq = seq;
+        }
+    }
+    
+    tbl->slot_cur = -1;
+    for (int i = 0; i < PARAM_SLOTS; i++)
+    {
+        if (param_read_from_addr(tbl, param_slot_addr(tbl, order[i])) == RT_EOK)
+        {
+            tbl->slot_cur = order[i];
+            PARAM_STAT_ADD(tbl, backup_loads, (i > 0));
+            rst = RT_EOK;
+            break;
+        }
+    }
+    
+    if (param_slot_blank(tbl, param_slot_next(tbl)))
+    {
+        tbl->slot_ready = 1;
+        tbl->slot_pending = 0;
+    }
+    else
+    {
+        param_slot_retire(tbl);
+    }
+    return(rst);
+}
+
+int param_tbl_pre_erase(param_tbl_t *tbl)
+{
+    int rst = 0;
+    
+    if (tbl->mutex == NULL)
+    {
+        return(-RT_ERROR);
+    }
+    
+    param_mutex_take(tbl);
+    if (tbl->slot_pending)
+    {
+        u32 addr = param_slot_addr(tbl, param_slot_next(tbl));
+        if (param_flash_erase(tbl, addr, PARAM_SECTOR_SIZE) < 0)
+        {
+            LOG_E("param sector erease fail. addr : %d", addr);
+            rst = -RT_ERROR;
+        }
+        else
+        {
+            tbl->slot_ready = 1;
+            tbl->slot_pending = 0;
+            rst = 1;
+        }
+    }
+    param_mutex_release(tbl);
+    
+    return(rst);
+}
+#endif
+
+#ifdef PARAM_USING_CLI
+static param_type_t param_get_type(param_tbl_t *tbl, int idx)
+{
+    return(tbl->msgs[idx].type);
+}
+
+static int param_get_size(param_tbl_t *tbl, int idx)
+{
+    return(tbl->msgs[idx].size);
+}
+#endif
+
+#ifndef PARAM_USING_INDEX_ONLY
+static int param_find_by_name(param_tbl_t *tbl, const char *name)
+{
+    for (int i=0; i<tbl->total; i++)
+    {
+        if (strcmp(PARAM_MSG_NAME(tbl, i), name) == 0)
+        {
+            return(i);
+        }
+    }
+    return(-1);
+}
+#endif
+
+static int param_input_value(void *buf, int type, int size, const char *input_str)
+{
+    switch(type)
+    {
+    case PTYPE_STR:
+        strncpy(buf, input_str, size-1);
+        break;
+    case PTYPE_ARRAY:
+        {
+            u8 *pbyte = buf;
+            char *p = (char *)input_str;
+            char *pn = NULL;
+            while(1)
+            {
+                *pbyte++ = strtol(p, &pn, 16);
+                if (*pn == 0) break;
+                p = pn+1;
+            }
+        }
+        break;
+    case PTYPE_INT:
+        {
+            s64 lval = strtoll(input_str, NULL, 0);
+            memcpy(buf, (u8 *)&lval, size);
+        }
+        break;
+    case PTYPE_HEX:
+        {
+            u64 lval = strtoll(input_str, NULL, 16);
+            memcpy(buf, (u8 *)&lval, size);
+        }
+        break;
+    case PTYPE_FLOAT:
+        {
+            if (size == sizeof(f32))
+            {
+                f32 fval = atof(input_str);
+                memcpy(buf, (u8 *)&fval, size);
+            }
+            else
+            {
+                f64 fval = atof(input_str);
+                memcpy(buf, (u8 *)&fval, size);
+            }
+        }
+        break;
+    default:
+        return(0);
+    }
+    
+    return(size);
+}
+
+static void param_values_reset(param_tbl_t *tbl)//all params read default
+{
+    #ifdef PARAM_USING_OVERLAY
+    param_overlay_reset(tbl);
+    #elif defined(PARAM_USING_XIP)
+    param_xip_reset(tbl);//all params read default until saved
+    tbl->xip_base = NULL;
+    #else
+    memset(tbl->datas, 0, tbl->size);
+    for (int i = 0; i < tbl->total; i++)
+    {
+        int type = tbl->msgs[i].type;
+        int size = tbl->msgs[i].size;
+        const char *str = PARAM_MSG_DEFVAL(tbl, i);
+        u8 *paddr = tbl->datas + tbl->offsets[i];
+
+        param_input_value(paddr, type, size, str);
+    }
+    #endif
+}
+
+static int _param_resume_all(param_tbl_t *tbl)
+{
+    if (tbl->mutex == NULL)
+    {
+        LOG_E("param resume all fail. param no initialized.");
+        return(-RT_ERROR);
+    }
+    
+    param_mutex_take(tbl);
+    param_values_reset(tbl);
+    PARAM_GEN_STAMP_ALL(tbl);
+    param_mutex_release(tbl);
+
+    return(RT_EOK);
+}
+
+#ifdef PARAM_USING_OVERLAY
+static void param_defaults_init(param_tbl_t *tbl)
+{
+    memset(tbl->defaults, 0, tbl->size);
+    for (int i = 0; i < tbl->total; i++)
+    {
+        int type = tbl->msgs[i].type;
+        int size = tbl->msgs[i].size;
+        const char *str = PARAM_MSG_DEFVAL(tbl, i);
+        u8 *paddr = tbl->defaults + tbl->offsets[i];
+
+        param_input_value(paddr, type, size, str);
+    }
+}
+#endif
+
+static void param_resume_value(param_tbl_t *tbl, int idx)
+{
+    int size = tbl->msgs[idx].size;
+    #ifdef PARAM_USING_XIP
+    u8 *paddr = param_xip_shadow(tbl, idx);
+    
+    if (paddr == NULL)
+    {
+        return;
+    }
+    #else
+    u8 *paddr = tbl->datas + tbl->offsets[idx];
+    #endif
+    
+    #ifdef PARAM_USING_OVERLAY
+    memcpy(paddr, tbl->defaults + tbl->offsets[idx], size);
+    param_overlay_clear(tbl, idx);
+    #else
+    memset(paddr, 0, size);
+    param_input_value(paddr, tbl->msgs[idx].type, size, PARAM_MSG_DEFVAL(tbl, idx));
+    #endif
+}
+
+#ifndef PARAM_USING_XIP
+static void param_volatile_resume(param_tbl_t *tbl)
+{
+    for (int i = 0; i < tbl->total; i++)
+    {
+        if (param_is_volatile(tbl, i))
+        {
+            param_resume_value(tbl, i);
+        }
+    }
+}
+#endif
+
+#define PARAM_AREAS_MAX                     7       //image, backup, spare, journal, dynamic params and its backup, presets
+
+typedef struct
+{
+    const char *part;                   //partition or storage name
+    u32 addr;
+    u32 size;
+}param_area_t;
+
+static int param_tbl_areas(param_tbl_t *tbl, param_area_t *areas)//storage areas written by the table, return areas total
+{
+    int n = 0;
+    
+    #ifdef PARAM_USING_DUAL
+    areas[n++] = (param_area_t){tbl->cfg.part_name, tbl->cfg.save_addr, PARAM_SECTOR_SIZE * 2};
+    areas[n++] = (param_area_t){tbl->cfg.part_name_bak, tbl->cfg.save_addr_bak, PARAM_SECTOR_SIZE * 2};
+    #else
+    areas[n++] = (param_area_t){tbl->cfg.part_name, tbl->cfg.save_addr, PARAM_SECTOR_SIZE};
+    areas[n++] = (param_area_t){tbl->cfg.part_name, tbl->cfg.save_addr_bak, PARAM_SECTOR_SIZE};
+    #endif
+    #ifdef PARAM_USING_PRE_ERASE
+    areas[n++] = (param_area_t){tbl->cfg.part_name, tbl->cfg.spare_addr, PARAM_SECTOR_SIZE};
+    #endif
+    #ifdef PARAM_USING_JOURNAL
+    for (int i = 0; i < tbl->total; i++)
+    {
+        if (param_is_journal(tbl, i))//the journal is never written without journal params
+        {
+            areas[n++] = (param_area_t){tbl->cfg.part_name, tbl->cfg.journal_addr, tbl->cfg.journal_sectors * PARAM_SECTOR_SIZE};
+            break;
+        }
+    }
+    #endif
+    #ifdef PARAM_USING_DYNAMIC
+    areas[n++] = (param_area_t){tbl->cfg.part_name, tbl->cfg.dyn_addr, tbl->cfg.dyn_sectors * PARAM_SECTOR_SIZE};
+    areas[n++] = (param_area_t){tbl->cfg.part_name, tbl->cfg.dyn_addr_bak, tbl->cfg.dyn_sectors * PARAM_SECTOR_SIZE};
+    #endif
+    #ifdef PARAM_USING_PRESET
+    areas[n++] = (param_area_t){tbl->cfg.part_name, tbl->cfg.preset_addr, (PARAM_SEL_SECTORS + tbl->cfg.preset_total) * PARAM_SECTOR_SIZE};
+    #endif
+    return(n);
+}
+
+static param_tbl_t *param_tbl_overlap(param_tbl_t *tbl)//the registered table sharing storage with tbl, NULL - none
+{
+    param_area_t areas[PARAM_AREAS_MAX], others[PARAM_AREAS_MAX];
+    int n = param_tbl_areas(tbl, areas);
+    rt_slist_t *node;
+    
+    rt_slist_for_each(node, &param_tbl_list)
+    {
+        param_tbl_t *other = rt_slist_entry(node, param_tbl_t, list);
+        int shared = 0;//all tables share one storage, names are ignored
+        int m;
+        
+        #ifdef PARAM_USING_BACKEND
+        if (other->cfg.backend != tbl->cfg.backend)
+        {
+            continue;
+        }
+        shared = (tbl->cfg.backend == &param_backend_ram);
+        #endif
+        m = param_tbl_areas(other, others);
+        for (int i = 0; i < n; i++)
+        {
+            for (int j = 0; j < m; j++)
+            {
+                if ((shared || (strcmp(areas[i].part, others[j].part) == 0))
+                    && (areas[i].addr < others[j].addr + others[j].size) && (others[j].addr < areas[i].addr + areas[i].size))
+                {
+                    return(other);
+                }
+            }
+        }
+    }
+    return(NULL);
+}
+
+int param_tbl_init(param_tbl_t *tbl)
+{
+    param_tbl_t *other;
+    
+    param_tbl_deinit(tbl);
+    
+    other = param_tbl_overlap(tbl);
+    if (other != NULL)
+    {
+        LOG_E("param init error. storage of table %s overlaps table %s.", tbl->name, other->name);
+        return(-RT_ERROR);
+    }
+    
+    if (param_part_init(tbl) != RT_EOK)
+    {
+        LOG_E("param fal partition initialize fail.");
+        return(-RT_ERROR);
+    }
+    
+    if (param_mutex_init(tbl) != RT_EOK)
+    {
+        LOG_E("param mutex init error. no memory for create mutex.");
+        return(-RT_ERROR);
+    }
+    
+    if (param_datas_init(tbl) != RT_EOK)
+    {
+        param_mutex_deinit(tbl);
+        LOG_E("param datas init error. no memory for create param datas.");
+        return(-RT_ERROR);
+    }
+    
+    #ifdef PARAM_USING_OVERLAY
+    param_defaults_init(tbl);
+    #endif
+    
+    #ifdef PARAM_USING_COMPRESS
+    tbl->comp = PCOMP_RLE;
+    #else
+    tbl->comp = PCOMP_NONE;
+    #endif
+    
+    #ifdef PARAM_USING_JOURNAL
+    if (param_journal_snapshot_size(tbl) > PARAM_SECTOR_SIZE)
+    {
+        param_mutex_deinit(tbl);
+        param_datas_deinit(tbl);
+        LOG_E("param journal init error. journal params are too big for one sector.");
+        return(-RT_ERROR);
+    }
+    tbl->jnl_sector = -1;
+    tbl->jnl_seq = 0;
+    tbl->jnl_total = 0;
+    for (int i = 0; i < tbl->total; i++)
+    {
+        tbl->jnl_total += param_is_journal(tbl, i);
+    }
+    #endif
+    #ifdef PARAM_USING_PRESET
+    tbl->preset_cur = -1;
+    tbl->sel_sector = -2;//selector is scanned on first use
+    #endif
+    #ifdef PARAM_USING_DELTA
+    tbl->gen = 0;
+    tbl->epoch = 0;//a new run, generations of the last one are never compared
+    param_gen_stamp_all(tbl);//generation 1, a sync since 0 gets all params
+    #endif
+    
+    #ifndef PARAM_USING_EXT_IMAGE
+    if (sizeof(param_head_t) + tbl->size > PARAM_IMAGE_MAX)
+    {
+        param_mutex_deinit(tbl);
+        param_datas_deinit(tbl);
+        LOG_E("param init error. params are too big for one sector.");
+        return(-RT_ERROR);
+    }
+    #endif
+    
+    #ifdef PARAM_USING_DUAL
+    tbl->dual_seq = 0;
+    #if PARAM_DUAL_THREAD_PRIORITY > 0
+    if (param_dual_thread_init() != RT_EOK)
+    {
+        param_mutex_deinit(tbl);
+        param_datas_deinit(tbl);
+        LOG_E("param init error. no memory for create backup thread.");
+        return(-RT_ERROR);
+    }
+    #endif
+    #endif
+    
+    #ifdef PARAM_USING_PRE_ERASE
+    tbl->slot_seq = 0;
+    tbl->slot_cur = -1;
+    tbl->slot_ready = 0;
+    tbl->slot_pending = 0;
+    #if PARAM_ERASE_THREAD_PRIORITY > 0
+    if (param_erase_thread_init() != RT_EOK)
+    {
+        param_mutex_deinit(tbl);
+        param_datas_deinit(tbl);
+        LOG_E("param init error. no memory for create erase thread.");
+        return(-RT_ERROR);
+    }
+    #endif
+    #endif
+    
+    #ifdef PARAM_USING_MIGRATE
+    if (sizeof(param_ext_head_t) + PARAM_DIR_SIZE(tbl->total) + tbl->size > PARAM_SECTOR_SIZE)
+    {
+        param_mutex_deinit(tbl);
+        param_datas_deinit(tbl);
+        LOG_E("param migrate init error. directory and params are too big for one sector.");
+        return(-RT_ERROR);
+    }
+    if (param_migrate_check(tbl) != RT_EOK)
+    {
+        param_mutex_deinit(tbl);
+        param_datas_deinit(tbl);
+        LOG_E("param migrate init error. no memory for name index.");
+        return(-RT_ERROR);
+    }
+    #endif
+    
+    #ifdef PARAM_USING_DYNAMIC
+    if (param_dyn_init(tbl) != RT_EOK)
+    {
+        param_mutex_deinit(tbl);
+        param_datas_deinit(tbl);
+        param_dyn_deinit(tbl);
+        LOG_E("param dynamic init error. no memory for create dynamic params.");
+        return(-RT_ERROR);
+    }
+    #endif
+    
+    #ifdef PARAM_USING_AUTO_SAVE
+    if (param_auto_save_timer_init(tbl) != RT_EOK)
+    {
+        param_mutex_deinit(tbl);
+        param_datas_deinit(tbl);
+        #ifdef PARAM_USING_DYNAMIC
+        param_dyn_deinit(tbl);
+        #endif
+        LOG_E("param datas init error. no memory for create param datas.");
+        return(-RT_ERROR);
+    }
+    #endif
+    
+    _param_resume_all(tbl);
+    rt_slist_append(&param_tbl_list, &tbl->list);
+    
+    return(RT_EOK);
+}
+
+void param_tbl_deinit(param_tbl_t *tbl)
+{
+    rt_slist_remove(&param_tbl_list, &tbl->list);
+    param_mutex_deinit(tbl);
+    param_datas_deinit(tbl);
+    #ifdef PARAM_USING_DYNAMIC
+    param_dyn_deinit(tbl);
+    #endif
+    #ifdef PARAM_USING_AUTO_SAVE
+    param_auto_save_timer_deinit(tbl);
+    #endif
+    #ifdef PARAM_USING_BACKEND
+    param_part_deinit(tbl);
+    #endif
+}
+
+param_tbl_t *param_tbl_find(const char *name)
+{
+    rt_slist_t *node;
+    
+    rt_slist_for_each(node, &param_tbl_list)
+    {
+        param_tbl_t *tbl = rt_slist_entry(node, param_tbl_t, list);
+        if (strcmp(tbl->name, name) == 0)
+        {
+            return(tbl);
+        }
+    }
+    return(NULL);
+}
+
+int param_tbl_load(param_tbl_t *tbl)
+{
+    int rst;
+    #ifdef PARAM_USING_STATS
+    u32 us;
+    #endif
+    
+    if (PARAM_TBL_STORAGE(tbl) == NULL || tbl->mutex == NULL)
+    {
+        LOG_E("param load failed. param no initialized.");
+        return(-RT_ERROR);
+    }
+
+    param_mutex_take(tbl);
+    #ifdef PARAM_USING_STATS
+    us = PARAM_STATS_TIME_US();
+    #endif
+    #ifdef PARAM_USING_PRESET
+    rst = param_preset_load(tbl);//the saved image is loaded if no preset is live
+    if (rst == -RT_EEMPTY)
+    #endif
+    #ifdef PARAM_USING_PRE_ERASE
+    rst = param_slot_load(tbl);
+    #elif defined(PARAM_USING_DUAL)
+    rst = param_dual_load(tbl);
+    #elif defined(PARAM_USING_XIP)
+    rst = param_xip_map(tbl, tbl->cfg.save_addr);
+    #else
+    rst = param_read_from_addr(tbl, tbl->cfg.save_addr);
+    #endif
+    if (rst == RT_EOK)
+    {
+        LOG_D("param load success from flash partition.");
+    }
+    #if !defined(PARAM_USING_PRE_ERASE) && !defined(PARAM_USING_DUAL)
+    else
+    {
+        #ifdef PARAM_USING_XIP
+        rst = param_xip_map(tbl, tbl->cfg.save_addr_bak);
+        #else
+        rst = param_read_from_addr(tbl, tbl->cfg.save_addr_bak);
+        #endif
+        if (rst == RT_EOK)
+        {
+            LOG_D("param load success from flash backup partition.");
+            PARAM_STAT_INC(tbl, backup_loads);
+        }
+    }
+    #endif
+    #ifdef PARAM_USING_XIP
+    if (rst == RT_EOK)
+    {
+        param_xip_reset(tbl);//unsaved changes are dropped, volatile params read default
+    }
+    #else
+    if (rst == RT_EOK)
+    {
+        param_volatile_resume(tbl);//volatile params never come back from flash
+    }
+    #endif
+    #ifdef PARAM_USING_JOURNAL
+    if (param_journal_load(tbl) != RT_EOK)//journal params are loaded even if the image is broken
+    {
+        LOG_E("param journal load failed .");
+    }
+    #endif
+    #ifdef PARAM_USING_DYNAMIC
+    if (param_dyn_load(tbl) != RT_EOK)//dynamic params are loaded even if the image is broken
+    {
+        LOG_E("param dynamic load failed .");
+    }
+    #endif
+    PARAM_GEN_STAMP_ALL(tbl);//values are replaced even if the load fails
+    #ifdef PARAM_USING_MIGRATE
+    if (tbl->mig != NULL)
+    {
+        if (param_migrate_finish(tbl) == RT_EOK)
+        {
+            LOG_I("param layout changed. migrated image is saved.");
+        }
+        else
+        {
+            LOG_E("param migrated image save failed .");
+        }
+    }
+    #endif
+    #ifdef PARAM_USING_STATS
+    tbl->stats.loads++;
+    tbl->stats.load_fails += (rst != RT_EOK);
+    param_stat_hist(tbl->stats.load_hist, &tbl->stats.load_max_us, PARAM_STATS_TIME_US() - us);
+    #endif
+    param_mutex_release(tbl);
+    
+    if (rst == RT_EOK)
+    {
+        return(RT_EOK);
+    }
+
+    LOG_E("param load failed .");
+    return(-RT_ERROR);
+}
+
+int param_tbl_save(param_tbl_t *tbl)
+{
+    int rst1, rst2;
+    #if !defined(PARAM_USING_EXT_IMAGE) && !defined(PARAM_USING_PRE_ERASE) && !defined(PARAM_USING_DUAL)
+    param_head_t head;
+    #endif
+    #ifdef PARAM_USING_STATS
+    u32 us;
+    #endif
+    
+    if (PARAM_TBL_STORAGE(tbl) == NULL || tbl->mutex == NULL)
+    {
+        LOG_E("param save failed . param no initialized.");
+        return(-RT_ERROR);
+    }
+    
+    param_mutex_take(tbl);
+    #ifdef PARAM_USING_STATS
+    us = PARAM_STATS_TIME_US();
+    #endif
+    #ifdef PARAM_USING_XIP
+    rst1 = param_xip_flush(tbl);
+    rst2 = rst1;
+    #elif defined(PARAM_USING_PRE_ERASE)
+    rst1 = param_slot_save(tbl);//the previous image is the backup
+    rst2 = rst1;
+    #elif defined(PARAM_USING_DUAL)
+    rst1 = param_dual_save(tbl);//the copies are written in parallel
+    rst2 = rst1;
+    #elif defined(PARAM_USING_EXT_IMAGE)
+    rst1 = param_write_ext_to_addr(tbl, tbl->cfg.save_addr);
+    rst2 = param_write_ext_to_addr(tbl, tbl->cfg.save_addr_bak);
+    #else
+    param_head_update(tbl, &head);
+    rst1 = param_write_to_addr(tbl, tbl->cfg.save_addr, &head);
+    rst2 = param_write_to_addr(tbl, tbl->cfg.save_addr_bak, &head);
+    #endif
+    #if defined(PARAM_USING_PRESET) && !defined(PARAM_USING_XIP)
+    if ((rst1 == RT_EOK) || (rst2 == RT_EOK))
+    {
+        param_preset_release(tbl);//the saved image is live again
+    }
+    #endif
+    #ifdef PARAM_USING_DYNAMIC
+    if (param_dyn_save(tbl) != RT_EOK)
+    {
+        LOG_E("param dynamic save failed . param write flash error.");
+    }
+    #endif
+    #ifdef PARAM_USING_STATS
+    tbl->stats.saves++;
+    tbl->stats.save_fails += ((rst1 != RT_EOK) && (rst2 != RT_EOK));
+    param_stat_hist(tbl->stats.save_hist, &tbl->stats.save_max_us, PARAM_STATS_TIME_US() - us);
+    #endif
+    param_mutex_release(tbl);
+
+    #ifdef PARAM_USING_AUTO_SAVE
+    param_auto_save_stop(tbl);
+    #endif
+    
+    if ((rst1 != RT_EOK) && (rst2 != RT_EOK))
+    {
+        LOG_E("param save failed . param write flash error.");
+        return(-RT_ERROR);
+    }
+    
+    return(RT_EOK);
+}
+
+int param_tbl_resume_all(param_tbl_t *tbl)
+{
+    int rst;
+    
+    PARAM_STAT_INC(tbl, calls[PSTAT_RESUME]);
+    rst = _param_resume_all(tbl);
+    
+    #ifdef PARAM_USING_JOURNAL
+    if (rst == RT_EOK)
+    {
+        param_mutex_take(tbl);
+        param_journal_compact(tbl);
+        param_mutex_release(tbl);
+    }
+    #endif
+    
+    #ifdef PARAM_USING_AUTO_SAVE
+    if (rst == RT_EOK)
+    {
+        param_auto_save_start(tbl);
+    }
+    #endif
+
+    return(rst);
+}
+
+#ifndef PARAM_USING_INDEX_ONLY
+const char *param_tbl_get_name(param_tbl_t *tbl, int idx)
+{
+    if ((u32)idx >= tbl->total)
+    {
+        return(NULL);
+    }
+    return(PARAM_MSG_NAME(tbl, idx));
+}
+#endif
+
+int param_tbl_resume_by_index(param_tbl_t *tbl, int idx)
+{
+    if (tbl->mutex == NULL)
+    {
+        LOG_E("param resume fail by index. param no initialized.");
+        return(-RT_ERROR);
+    }
+    
+    if ((u32)idx < tbl->total)
+    {
+        param_mutex_take(tbl);
+        PARAM_STAT_INC(tbl, calls[PSTAT_RESUME]);
+        param_resume_value(tbl, idx);
+        PARAM_GEN_STAMP(tbl, idx);
+        #ifdef PARAM_USING_JOURNAL
+        if (param_is_journal(tbl, idx))
+        {
+            param_journal_append(tbl, idx);
+        }
+        #endif
+        param_mutex_release(tbl);
+
+        #ifdef PARAM_USING_AUTO_SAVE
+        if (param_get_store(tbl, idx) == PSTORE_IMAGE)
+        {
+            param_auto_save_start(tbl);
+        }
+        #endif
+
+        return(RT_EOK);
+    }
+
+    return(-RT_ERROR);
+}
+
+int param_tbl_read_by_index(param_tbl_t *tbl, int idx, void *addr, int size)
+{
+    param_type_t ptype;
+    int psize;
+    #ifdef PARAM_USING_XIP
+    const u8 *paddr;
+    u8 dbuf[PARAM_VALUE_MAX];//default value of clean param
+    #else
+    u8 *paddr;
+    #endif
+    
+    if (tbl->mutex == NULL)
+    {
+        LOG_E("param read fail by index. param no initialized.");
+        return(-RT_ERROR);
+    }
+    
+    if (((u32)idx >= tbl->total) || (addr == NULL) || (size <= 0))
+    {
+        LOG_E("param write fail. input parameter error.");
+        return(-RT_ERROR);
+    }
+    
+    ptype = tbl->msgs[idx].type;
+    psize = tbl->msgs[idx].size;
+    PARAM_PROF_INC(tbl, idx, reads);
+    
+    param_mutex_take(tbl);
+    PARAM_STAT_INC(tbl, calls[PSTAT_READ_INDEX]);
+    
+    #ifdef PARAM_USING_XIP
+    paddr = param_xip_value(tbl, idx, dbuf);
+    #else
+    paddr = tbl->datas + tbl->offsets[idx];
+    #endif
+    
+    switch (ptype)
+    {
+    case PTYPE_STR:
+        psize = strlen((const char *)paddr);
+        if (psize > (size - 1))
+        {
+            psize = (size - 1);
+        }
+        memcpy(addr, paddr, psize);
+        ((u8*)addr)[psize] = 0;
+        break;
+    case PTYPE_ARRAY:
+        if (psize > size)
+        {
+            psize = size;
+        }
+        memcpy(addr, paddr, psize);
+        break;
+    case PTYPE_INT:
+        {
+            s64 lval;
+            
+            if (size != sizeof(u8) && size != sizeof(u16) && size != sizeof(u32) && size != sizeof(u64))
+            {
+                psize = 0;
+                break;
+            }
+            
+            if (psize == sizeof(u32))
+            {
+                s32 tv;
+                memcpy((u8 *)&tv, paddr, psize);
+                lval = (s64)tv;
+            }
+            else
+            {
+                memcpy((u8 *)&lval, paddr, psize);
+            }
+            
+            memcpy(addr, (u8 *)&lval, size);
+            psize = size;
+        }
+        break;
+    case PTYPE_HEX:
+        {
+            u64 lval;
+            
+            if (size != sizeof(u8) && size != sizeof(u16) && size != sizeof(u32) && size != sizeof(u64))
+            {
+                psize = 0;
+                break;
+            }
+            
+            if (psize == sizeof(u32))
+            {
+                u32 tv;
+                memcpy((u8 *)&tv, paddr, psize);
+                lval = (u64)tv;
+            }
+            else
+            {
+                memcpy((u8 *)&lval, paddr, psize);
+            }
+            
+            memcpy(addr, (u8 *)&lval, size);
+            psize = size;
+        }
+        break;
+    case PTYPE_FLOAT:
+        {
+            f64 fval;
+
+            if (size != sizeof(f32) && size != sizeof(f64))
+            {
+                psize = 0;
+                break;
+            }
+            
+            if (psize == sizeof(f32))
+            {
+                f32 tv;
+                memcpy((u8*)&tv, paddr, psize);
+                fval = (f64)tv;
+            }
+            else
+            {
+                memcpy((u8*)&fval, paddr, psize);
+            }
+
+            if (size == sizeof(f32))
+            {
+                f32 tv = fval;
+                memcpy(addr, (u8 *)&tv, size);
+            }
+            else
+            {
+                memcpy(addr, (u8 *)&fval, size);
+            }
+
+            psize = size;
+        }
+        break;
+    default:
+        psize = 0;
+        break;
+    }
+
+    param_mutex_release(tbl);
+    
+    return ((psize > 0) ? RT_EOK : -RT_ERROR);
+}
+
+int param_tbl_write_by_index(param_tbl_t *tbl, int idx, const void *addr, int size)
+{
+    param_type_t ptype;
+    int psize;
+    u8 *paddr;
+    
+    if (tbl->mutex == NULL)
+    {
+        LOG_E("param write fail. param no initialized.");
+        return(-RT_ERROR);
+    }
+    
+    if (((u32)idx >= tbl->total) || (addr == NULL) || (size <= 0))
+    {
+        LOG_E("param write fail. input parameter error.");
+        return(-RT_ERROR);
+    }
+    
+    ptype = tbl->msgs[idx].type;
+    psize = tbl->msgs[idx].size;
+    PARAM_PROF_INC(tbl, idx, writes);
+    
+    param_mutex_take(tbl);
+    PARAM_STAT_INC(tbl, calls[PSTAT_WRITE_INDEX]);
+    
+    #ifdef PARAM_USING_XIP
+    paddr = param_xip_shadow(tbl, idx);
+    if (paddr == NULL)
+    {
+        param_mutex_release(tbl);
+        LOG_E("param write fail. no shadow for the modified parameter.");
+        return(-RT_ERROR);
+    }
+    #else
+    paddr = tbl->datas + tbl->offsets[idx];
+    #endif
+    
+    switch (ptype)
+    {
+    case PTYPE_STR:
+        size = strlen(addr);
+        if (size > (psize - 1))
+        {
+            size = (psize - 1);
+        }
+        memcpy(paddr, addr, size);
+        memset(paddr + size, 0, psize - size);
+        size = psize;//an empty string is a valid write too
+        break;
+    case PTYPE_ARRAY:
+        if (size > psize)
+        {
+            size = psize;
+        }
+        memcpy(paddr, addr, size);
+        break;
+    case PTYPE_INT:
+        {
+            s64 lval;
+            
+            if (size != sizeof(u8) && size != sizeof(u16) && size != sizeof(u32) && size != sizeof(u64))
+            {
+                size = 0;
+                break;
+            }
+            
+            if (size == sizeof(u8))
+            {
+                lval = *((s8 *)addr);
+            }
+            else if (size == sizeof(u16))
+            {
+                s16 tv;
+                memcpy((u8 *)&tv, addr, size);
+                lval = (s64)tv;
+            }
+            else if (size == sizeof(u32))
+            {
+                s32 tv;
+                memcpy((u8 *)&tv, addr, size);
+                lval = (s64)tv;
+            }
+            else
+            {
+                memcpy((u8 *)&lval, addr, size);
+            }
+            
+            memcpy(paddr, (u8 *)&lval, psize);
+            size = psize;
+        }
+        break;
+    case PTYPE_HEX:
+        {
+            u64 lval;
+            
+            if (size != sizeof(u8) && size != sizeof(u16) && size != sizeof(u32) && size != sizeof(u64))
+            {
+                size = 0;
+                break;
+            }
+            
+            if (size == sizeof(u8))
+            {
+                lval = *((u8 *)addr);
+            }
+            else if (size == sizeof(u16))
+            {
+                u16 tv;
+                memcpy((u8 *)&tv, addr, size);
+                lval = (u64)tv;
+            }
+            else if (size == sizeof(u32))
+            {
+                u32 tv;
+                memcpy((u8 *)&tv, addr, size);
+                lval = (u64)tv;
+            }
+            else
+            {
+                memcpy((u8 *)&lval, addr, size);
+            }
+            
+            memcpy(paddr, (u8 *)&lval, psize);
+            size = psize;
+        }
+        break;
+    case PTYPE_FLOAT:
+        {
+            f64 fval;
+            
+            if (size != sizeof(f32) && size != sizeof(f64))
+            {
+                size = 0;
+                break;
+            }
+            
+            if (size == sizeof(f32))
+            {
+                f32 tv;
+                memcpy((u8*)&tv, addr, size);
+                fval = (f64)tv;
+            }
+            else
+            {
+                memcpy((u8*)&fval, addr, size);
+            }
+
+            if (psize == sizeof(f32))
+            {
+                f32 tv = fval;
+                memcpy(paddr, (u8 *)&tv, psize);
+            }
+            else
+            {
+                memcpy(paddr, (u8 *)&fval, psize);
+            }
+
+            size = psize;
+        }
+        break;
+    default:
+        size = 0;
+        break;
+    }
+    
+    #ifdef PARAM_USING_OVERLAY
+    param_overlay_update(tbl, idx);
+    #endif
+    #ifdef PARAM_USING_DELTA
+    if (size > 0)
+    {
+        param_gen_stamp(tbl, idx);
+    }
+    #endif
+    
+    #ifdef PARAM_USING_JOURNAL
+    if (param_is_journal(tbl, idx) && (size > 0))//only appends a record, the image is untouched
+    {
+        param_journal_append(tbl, idx);
+    }
+    #endif
+    
+    param_mutex_release(tbl);
+    
+    #ifdef PARAM_USING_AUTO_SAVE
+    if ((psize > 0) && (param_get_store(tbl, idx) == PSTORE_IMAGE))
+    {
+        param_auto_save_start(tbl);
+    }
+    #endif
+    
+    return ((psize > 0) ? RT_EOK : -RT_ERROR);
+}
+
+int param_tbl_notify(param_tbl_t *tbl, int idx)
+{
+    if (tbl->mutex == NULL)
+    {
+        LOG_E("param notify fail. param no initialized.");
+        return(-RT_ERROR);
+    }
+    
+    if ((u32)idx >= tbl->total)
+    {
+        return(-RT_ERROR);
+    }
+    
+    //the value is already stored in place, only the bookkeeping of a write is done
+    param_mutex_take(tbl);
+    PARAM_STAT_INC(tbl, calls[PSTAT_NOTIFY]);
+    #ifdef PARAM_USING_OVERLAY
+    param_overlay_update(tbl, idx);
+    #endif
+    PARAM_GEN_STAMP(tbl, idx);
+    #ifdef PARAM_USING_JOURNAL
+    if (param_is_journal(tbl, idx))
+    {
+        param_journal_append(tbl, idx);
+    }
+    #endif
+    param_mutex_release(tbl);
+    
+    #ifdef PARAM_USING_AUTO_SAVE
+    if (param_get_store(tbl, idx) == PSTORE_IMAGE)
+    {
+        param_auto_save_start(tbl);
+    }
+    #endif
+    
+    return(RT_EOK);
+}
+
+#ifndef PARAM_USING_INDEX_ONLY
+int param_tbl_resume_by_name(param_tbl_t *tbl, char *name)//resume default by name
+{
+    int idx = param_find_by_name(tbl, name);
+    if (idx < 0)
+    {
+        LOG_E("param resume fail by name. parameter don`t exist.");
+        return(-RT_ERROR);
+    }
+    
+    return(param_tbl_resume_by_index(tbl, idx));
+}
+
+int param_tbl_read_by_name(param_tbl_t *tbl, char *name, void *addr, int size)//read param by name
+{
+    int idx = param_find_by_name(tbl, name);
+    if (idx < 0)
+    {
+        LOG_E("param read fail by name. parameter don`t exist.");
+        return(-RT_ERROR);
+    }
+    
+    PARAM_STAT_INC(tbl, calls[PSTAT_READ_NAME]);
+    return(param_tbl_read_by_index(tbl, idx, addr, size));
+}
+
+int param_tbl_write_by_name(param_tbl_t *tbl, char *name, const void *addr, int size)//write param by name
+{
+    int idx = param_find_by_name(tbl, name);
+    if (idx < 0)
+    {
+        LOG_E("param write fail by name. parameter don`t exist.");
+        return(-RT_ERROR);
+    }
+    
+    PARAM_STAT_INC(tbl, calls[PSTAT_WRITE_NAME]);
+    return(param_tbl_write_by_index(tbl, idx, addr, size));
+}
+#endif
+
+#ifdef PARAM_USING_DYNAMIC
+int param_tbl_dyn_set(param_tbl_t *tbl, const char *key, const void *val, int len)
+{
+    param_dyn_rec_t *rec;
+    int klen, size, pos, free;
+    int old = 0;
+    
+    if (tbl->dyn_arena == NULL || tbl->mutex == NULL)
+    {
+        LOG_E("param dynamic set fail. param no initialized.");
+        return(-RT_ERROR);
+    }
+    
+    klen = (key == NULL) ? 0 : strlen(key);
+    if ((klen == 0) || (klen > PARAM_DYN_KEY_MAX) || (len < 0) || (len > 0xFFFF) || ((val == NULL) && (len > 0)))
+    {
+        LOG_E("param dynamic set fail. input parameter error.");
+        return(-RT_ERROR);
+    }
+    
+    size = param_dyn_rec_size(klen, len);
+    param_mutex_take(tbl);
+    pos = param_dyn_find(tbl, key, klen, &free);
+    if (pos >= 0)
+    {
+        rec = PARAM_DYN_REC(tbl, tbl->dyn_index[pos]);
+        if (rec->vlen == len)//same length, update in place
+        {
+            memcpy((u8 *)(rec + 1) + klen + 1, val, len);
+            tbl->dyn_dirty = 1;
+            param_mutex_release(tbl);
+            #ifdef PARAM_USING_AUTO_SAVE
+            param_auto_save_start(tbl);
+            #endif
+            return(RT_EOK);
+        }
+        old = param_dyn_rec_size(klen, rec->vlen);
+    }
+    
+    if (((pos < 0) && (tbl->dyn_count >= param_dyn_max_count(tbl)))
+        || (tbl->dyn_used - tbl->dyn_garbage - old + size > tbl->dyn_size))
+    {
+        param_mutex_release(tbl);
+        LOG_E("param dynamic set fail. no space for %s.", key);
+        return(-RT_ERROR);
+    }
+    if (pos >= 0)//length changed, the record is moved to the end
+    {
+        param_dyn_remove(tbl, pos);
+        free = pos;
+    }
+    if ((tbl->dyn_used + size > tbl->dyn_size) || (tbl->dyn_count + tbl->dyn_tombs >= param_dyn_max_count(tbl)))
+    {
+        param_dyn_compact(tbl);//drops deleted records and tombstones
+        param_dyn_find(tbl, key, klen, &free);
+    }
+    
+    rec = (param_dyn_rec_t *)(tbl->dyn_arena + tbl->dyn_used);
+    rec->vlen = len;
+    rec->klen = klen;
+    rec->flag = PARAM_DYN_LIVE;
+    memcpy(rec + 1, key, klen + 1);
+    memcpy((u8 *)(rec + 1) + klen + 1, val, len);
+    if (tbl->dyn_index[free] == PARAM_DYN_SLOT_DELETED)
+    {
+        tbl->dyn_tombs--;
+    }
+    tbl->dyn_index[free] = tbl->dyn_used / PARAM_DYN_ALIGN + 1;
+    tbl->dyn_used += size;
+    tbl->dyn_count++;
+    tbl->dyn_dirty = 1;
+    param_mutex_release(tbl);
+    
+    #ifdef PARAM_USING_AUTO_SAVE
+    param_auto_save_start(tbl);
+    #endif
+    
+    return(RT_EOK);
+}
+
+int param_tbl_dyn_get(param_tbl_t *tbl, const char *key, void *buf, int size)
+{
+    param_dyn_rec_t *rec;
+    int klen, len, pos;
+    
+    if (tbl->dyn_arena == NULL || tbl->mutex == NULL)
+    {
+        LOG_E("param dynamic get fail. param no initialized.");
+        return(-RT_ERROR);
+    }
+    
+    klen = (key == NULL) ? 0 : strlen(key);
+    if ((klen == 0) || (klen > PARAM_DYN_KEY_MAX) || ((buf == NULL) && (size > 0)))
+    {
+        return(-RT_ERROR);
+    }
+    
+    param_mutex_take(tbl);
+    pos = param_dyn_find(tbl, key, klen, NULL);
+    if (pos < 0)
+    {
+        param_mutex_release(tbl);
+        return(-RT_ERROR);
+    }
+    rec = PARAM_DYN_REC(tbl, tbl->dyn_index[pos]);
+    len = rec->vlen;
+    if (size > 0)
+    {
+        memcpy(buf, (u8 *)(rec + 1) + klen + 1, (len < size) ? len : size);
+    }
+    param_mutex_release(tbl);
+    
+    return(len);
+}
+
+int param_tbl_dyn_delete(param_tbl_t *tbl, const char *key)
+{
+    int klen, pos;
+    
+    if (tbl->dyn_arena == NULL || tbl->mutex == NULL)
+    {
+        LOG_E("param dynamic delete fail. param no initialized.");
+        return(-RT_ERROR);
+    }
+    
+    klen = (key == NULL) ? 0 : strlen(key);
+    if ((klen == 0) || (klen > PARAM_DYN_KEY_MAX))
+    {
+        return(-RT_ERROR);
+    }
+    
+    param_mutex_take(tbl);
+    pos = param_dyn_find(tbl, key, klen, NULL);
+    if (pos >= 0)
+    {
+        param_dyn_remove(tbl, pos);
+    }
+    param_mutex_release(tbl);
+    
+    if (pos < 0)
+    {
+        return(-RT_ERROR);
+    }
+    
+    #ifdef PARAM_USING_AUTO_SAVE
+    param_auto_save_start(tbl);
+    #endif
+    
+    return(RT_EOK);
+}
+
+int param_tbl_dyn_count(param_tbl_t *tbl)
+{
+    return(tbl->dyn_count);
+}
+#endif
+
+#if defined(PARAM_USING_EXPORT) || defined(PARAM_USING_TEXT_IMPORT)
+static const u8 *param_value_addr(param_tbl_t *tbl, int idx, u8 *buf)//current value, buf is used if it is not in RAM
+{
+    #ifdef PARAM_USING_XIP
+    return(param_xip_value(tbl, idx, buf));
+    #else
+    return(tbl->datas + tbl->offsets[idx]);
+    #endif
+}
+
+static void param_set_value(param_tbl_t *tbl, param_batch_t *batch, int idx, const u8 *val)//store value of batch, the table is locked
+{
+    u8 buf[PARAM_VALUE_MAX];
+    int size = tbl->msgs[idx].size;
+    u8 *paddr;
+    
+    if (memcmp(param_value_addr(tbl, idx, buf), val, size) == 0)
+    {
+        return;//unchanged params are not touched
+    }
+    #ifdef PARAM_USING_XIP
+    if (batch->apply == 0)//only the shadows are counted
+    {
+        batch->need += (param_xip_test(tbl, idx) == 0) ? param_xip_rec_size(size) : 0;
+        return;
+    }
+    paddr = param_xip_shadow(tbl, idx);
+    if (paddr == NULL)
+    {
+        batch->fails++;
+        return;
+    }
+    #else
+    paddr = tbl->datas + tbl->offsets[idx];
+    #endif
+    memcpy(paddr, val, size);
+    #ifdef PARAM_USING_OVERLAY
+    param_overlay_update(tbl, idx);
+    #endif
+    PARAM_GEN_STAMP(tbl, idx);
+}
+
+/* 
+ * values of a batch are stored in one locked pass, walk calls param_set_value for each value.
+ * with PARAM_USING_XIP the shadows of the batch are reserved first by a counting walk, the pool is
+ * saved before the batch if it is short, so a full pool is never saved with half of the batch
+ */
+static int param_batch_apply(param_tbl_t *tbl, void (*walk)(param_tbl_t *tbl, param_batch_t *batch, const void *arg), const void *arg)
+{
+    param_batch_t batch = {0};
+    
+    param_mutex_take(tbl);
+    #ifdef PARAM_USING_XIP
+    walk(tbl, &batch, arg);
+    if ((tbl->xip_used + batch.need > PARAM_XIP_SHADOW_SIZE) && (param_xip_flush(tbl) == RT_EOK))
+    {
+        batch.need = 0;//saved params have no shadow now
+        walk(tbl, &batch, arg);
+    }
+    if (tbl->xip_used + batch.need > PARAM_XIP_SHADOW_SIZE)
+    {
+        param_mutex_release(tbl);
+        LOG_E("param batch fail. shadow pool is too small, %d bytes needed.", batch.need);
+        return(-RT_ERROR);
+    }
+    #endif
+    batch.apply = 1;
+    walk(tbl, &batch, arg);
+    param_mutex_release(tbl);
+    
+    if (batch.fails != 0)
+    {
+        LOG_E("param batch fail. %d values are not stored.", batch.fails);
+        return(-RT_ERROR);
+    }
+    return(RT_EOK);
+}
+
+static int param_batch_save(param_tbl_t *tbl)//save once after a batch is applied
+{
+    #ifdef PARAM_USING_JOURNAL
+    param_mutex_take(tbl);
+    param_journal_compact(tbl);
+    param_mutex_release(tbl);
+    #endif
+    
+    return(param_tbl_save(tbl));
+}
+#endif
+
+#ifdef PARAM_USING_EXPORT
+static u16 param_layout_crc(param_tbl_t *tbl)//blob of other layout is never imported
+{
+    u16 crc16 = 0;
+    
+    for (int i = 0; i < tbl->total; i++)
+    {
+        u8 ts[2];
+        ts[0] = tbl->msgs[i].type;
+        ts[1] = tbl->msgs[i].size;
+        crc16 = (i == 0) ? PARAM_CRC16_CAL(ts, sizeof(ts)) : PARAM_CRC16_CYC_CAL(crc16, ts, sizeof(ts));
+    }
+    
+    return(crc16);
+}
+
+static void param_default_value(param_tbl_t *tbl, int idx, u8 *buf)
+{
+    #ifdef PARAM_USING_OVERLAY
+    memcpy(buf, tbl->defaults + tbl->offsets[idx], tbl->msgs[idx].size);
+    #else
+    memset(buf, 0, tbl->msgs[idx].size);
+    param_input_value(buf, tbl->msgs[idx].type, tbl->msgs[idx].size, PARAM_MSG_DEFVAL(tbl, idx));
+    #endif
+}
+
+static void param_export_put(u8 *buf, int size, int *pos, const void *data, int len)//bytes beyond buffer are only counted
+{
+    if ((buf != NULL) && (*pos + len <= size))
+    {
+        memcpy(buf + *pos, data, len);
+    }
+    *pos += len;
+}
+
+static int param_import_check(param_tbl_t *tbl, const param_export_head_t *head, const u8 *pdata)
+{
+    int pos = 0;
+    int last = -1;
+    
+    if ((head->flags & PARAM_EXPORT_SPARSE) == 0)
+    {
+        return((head->size == tbl->size) ? RT_EOK : -RT_ERROR);
+    }
+    if (head->flags & PARAM_EXPORT_DELTA)//epoch and generation first, records from the latest change, in no index order
+    {
+        if (head->size < PARAM_DELTA_HEAD_SIZE)
+        {
+            return(-RT_ERROR);
+        }
+        pos = PARAM_DELTA_HEAD_SIZE;
+    }
+    
+    //records must be in index order, so they are merged with defaults in one pass
+    while (pos < head->size)
+    {
+        u16 idx;
+        u8 len;
+        
+        if (pos + PARAM_EXPORT_REC_SIZE > head->size)
+        {
+            return(-RT_ERROR);
+        }
+        memcpy(&idx, pdata + pos, sizeof(idx));
+        len = pdata[pos + sizeof(idx)];
+        if ((idx >= tbl->total) || (((int)idx <= last) && ((head->flags & PARAM_EXPORT_DELTA) == 0)) || (len != tbl->msgs[idx].size)
+            || (pos + PARAM_EXPORT_REC_SIZE + len > head->size))
+        {
+            return(-RT_ERROR);
+        }
+        last = idx;
+        pos += PARAM_EXPORT_REC_SIZE + len;
+    }
+    
+    return(RT_EOK);
+}
+
+static void param_import_value(param_tbl_t *tbl, param_batch_t *batch, int idx, const u8 *val)
+{
+    if (param_is_volatile(tbl, idx) == 0)//volatile params keep RAM values
+    {
+        param_set_value(tbl, batch, idx, val);
+    }
+}
+
+static void param_import_apply(param_tbl_t *tbl, param_batch_t *batch, const void *blob)//walk of a verified blob
+{
+    const u8 *pdata = (const u8 *)blob + sizeof(param_export_head_t);
+    param_export_head_t head;
+    int pos = 0;
+    
+    memcpy(&head, blob, sizeof(head));
+    if ((head.flags & PARAM_EXPORT_SPARSE) == 0)
+    {
+        for (int i = 0; i < tbl->total; i++)
+        {
+            param_import_value(tbl, batch, i, pdata + tbl->offsets[i]);
+        }
+        return;
+    }
+    if (head.flags & PARAM_EXPORT_DELTA)//params without record keep their values
+    {
+        for (pos = PARAM_DELTA_HEAD_SIZE; pos < head.size; pos += PARAM_EXPORT_REC_SIZE + pdata[pos + sizeof(u16)])
+        {
+            u16 idx;
+            
+            memcpy(&idx, pdata + pos, sizeof(idx));
+            param_import_value(tbl, batch, idx, pdata + pos + PARAM_EXPORT_REC_SIZE);
+        }
+        return;
+    }
+    
+    //params without record are resumed to default
+    for (int i = 0; i < tbl->total; i++)
+    {
+        u8 buf[PARAM_VALUE_MAX];
+        u16 idx = 0xFFFF;//no more record
+        
+        if (pos < head.size)
+        {
+            memcpy(&idx, pdata + pos, sizeof(idx));
+        }
+        if (idx == i)
+        {
+            param_import_value(tbl, batch, i, pdata + pos + PARAM_EXPORT_REC_SIZE);
+            pos += PARAM_EXPORT_REC_SIZE + tbl->msgs[i].size;
+        }
+        else
+        {
+            param_default_value(tbl, i, buf);
+            param_import_value(tbl, batch, i, buf);
+        }
+    }
+}
+
+static int param_export_finish(param_tbl_t *tbl, u8 *pbuf, int size, int pos, int flags)//head of blob, pos is the blob size
+{
+    param_export_head_t head;
+    
+    if (pbuf == NULL)
+    {
+        return(pos);
+    }
+    if (pos > size)
+    {
+        LOG_E("param export fail. buffer is too small, %d bytes needed.", pos);
+        return(-RT_ERROR);
+    }
+    
+    head.magic = PARAM_MAGIC_EXPORT;
+    head.version = PARAM_EXPORT_VERSION;
+    head.flags = flags;
+    head.total = tbl->total;
+    head.layout = param_layout_crc(tbl);
+    head.size = pos - sizeof(head);
+    head.crc16 = PARAM_CRC16_CAL(pbuf + sizeof(head), head.size);
+    head.head_crc16 = PARAM_CRC16_CAL((u8*)&head, sizeof(head)-2);
+    memcpy(pbuf, &head, sizeof(head));
+    
+    return(pos);
+}
+
+int param_tbl_export(param_tbl_t *tbl, void *buf, int size, int flags)
+{
+    u8 *pbuf = buf;
+    int pos = sizeof(param_export_head_t);
+    
+    if (tbl->mutex == NULL)
+    {
+        LOG_E("param export fail. param no initialized.");
+        return(-RT_ERROR);
+    }
+    
+    param_mutex_take(tbl);
+    for (int i = 0; i < tbl->total; i++)
+    {
+        u8 vbuf[PARAM_VALUE_MAX];
+        u8 dbuf[PARAM_VALUE_MAX];
+        u8 len = tbl->msgs[i].size;
+        const u8 *val = param_value_addr(tbl, i, vbuf);
+        
+        if (flags & PARAM_EXPORT_SPARSE)
+        {
+            u16 idx = i;
+            
+            param_default_value(tbl, i, dbuf);
+            if (param_is_volatile(tbl, i) || (memcmp(val, dbuf, len) == 0))
+            {
+                continue;
+            }
+            param_export_put(pbuf, size, &pos, &idx, sizeof(idx));
+            param_export_put(pbuf, size, &pos, &len, sizeof(len));
+        }
+        param_export_put(pbuf, size, &pos, val, len);
+    }
+    param_mutex_release(tbl);
+    
+    return(param_export_finish(tbl, pbuf, size, pos, flags & PARAM_EXPORT_SPARSE));
+}
+
+#ifdef PARAM_USING_DELTA
+static u32 param_epoch_runs = 0;        //runs of tables in this boot, a table initialized again gets another epoch
+
+static u32 param_epoch_get(param_tbl_t *tbl)//epoch of the run, chosen at first use, the table is locked
+{
+    if (tbl->epoch == 0)
+    {
+        u32 epoch = (PARAM_BOOT_EPOCH() ^ (++param_epoch_runs << 20)) * 2654435761u;//spread the seed over all bits
+        tbl->epoch = (epoch != 0) ? epoch : 1;
+    }
+    return(tbl->epoch);
+}
+
+int param_tbl_delta_export(param_tbl_t *tbl, u32 epoch, u32 since, void *buf, int size)
+{
+    u8 *pbuf = buf;
+    int pos = sizeof(param_export_head_t);
+    
+    if (tbl->mutex == NULL)
+    {
+        LOG_E("param export fail. param no initialized.");
+        return(-RT_ERROR);
+    }
+    
+    param_mutex_take(tbl);
+    if ((epoch != param_epoch_get(tbl)) || (since > tbl->gen))//generation of another run, values may be lost since then
+    {
+        since = 0;
+    }
+    param_export_put(pbuf, size, &pos, &tbl->epoch, sizeof(tbl->epoch));
+    param_export_put(pbuf, size, &pos, &tbl->gen, sizeof(tbl->gen));
+    //the list is in order of change, so only changed params are visited
+    for (u16 idx = tbl->gen_head; (idx != PARAM_GEN_NONE) && (tbl->gens[idx].gen > since); idx = tbl->gens[idx].next)
+    {
+        u8 vbuf[PARAM_VALUE_MAX];
+        u8 len = tbl->msgs[idx].size;
+        
+        if (param_is_volatile(tbl, idx))
+        {
+            continue;
+        }
+        param_export_put(pbuf, size, &pos, &idx, sizeof(idx));
+        param_export_put(pbuf, size, &pos, &len, sizeof(len));
+        param_export_put(pbuf, size, &pos, param_value_addr(tbl, idx, vbuf), len);
+    }
+    param_mutex_release(tbl);
+    
+    return(param_export_finish(tbl, pbuf, size, pos, PARAM_EXPORT_SPARSE | PARAM_EXPORT_DELTA));
+}
+
+u32 param_tbl_generation(param_tbl_t *tbl)
+{
+    return(tbl->gen);
+}
+
+u32 param_tbl_epoch(param_tbl_t *tbl)
+{
+    u32 epoch;
+    
+    if (tbl->mutex == NULL)
+    {
+        LOG_E("param epoch get fail. param no initialized.");
+        return(0);
+    }
+    param_mutex_take(tbl);
+    epoch = param_epoch_get(tbl);
+    param_mutex_release(tbl);
+    return(epoch);
+}
+#endif
+
+int param_tbl_import(param_tbl_t *tbl, const void *buf, int size)
+{
+    const u8 *pdata = (const u8 *)buf + sizeof(param_export_head_t);
+    param_export_head_t head;
+    
+    if (tbl->mutex == NULL)
+    {
+        LOG_E("param import fail. param no initialized.");
+        return(-RT_ERROR);
+    }
+    if (size < (int)sizeof(head))
+    {
+        LOG_E("param import fail. blob is too short.");
+        return(-RT_ERROR);
+    }
+    memcpy(&head, buf, sizeof(head));
+    if ((head.magic != PARAM_MAGIC_EXPORT) || (PARAM_CRC16_CAL((u8*)&head, sizeof(head)-2) != head.head_crc16))
+    {
+        LOG_E("param import fail. head check fail.");
+        return(-RT_ERROR);
+    }
+    if (head.version != PARAM_EXPORT_VERSION)
+    {
+        LOG_E("param import fail. version %d unsupported.", head.version);
+        return(-RT_ERROR);
+    }
+    if ((head.total != tbl->total) || (head.layout != param_layout_crc(tbl)))
+    {
+        LOG_E("param import fail. blob is exported from other table layout.");
+        return(-RT_ERROR);
+    }
+    if (((int)sizeof(head) + head.size > size) || (PARAM_CRC16_CAL((u8 *)pdata, head.size) != head.crc16)
+        || (param_import_check(tbl, &head, pdata) != RT_EOK))
+    {
+        LOG_E("param import fail. data check fail.");
+        return(-RT_ERROR);
+    }
+    
+    //the blob is verified, all params are changed in one locked pass
+    if (param_batch_apply(tbl, param_import_apply, buf) != RT_EOK)
+    {
+        return(-RT_ERROR);
+    }
+    
+    return(param_batch_save(tbl));
+}
+#endif
+
+#ifdef PARAM_USING_TEXT_IMPORT
+static char *param_text_trim(char *str)
+{
+    char *end;
+    
+    while ((*str == ' ') || (*str == '\t'))
+    {
+        str++;
+    }
+    end = str + strlen(str);
+    while ((end > str) && ((end[-1] == ' ') || (end[-1] == '\t') || (end[-1] == '\r')))
+    {
+        end--;
+    }
+    *end = 0;
+    return(str);
+}
+
+static void param_text_error(param_text_t *ctx, const char *msg, const char *name)
+{
+    LOG_W("param text line %d : %s %s", ctx->line, msg, name);
+    if (ctx->errors == 0)
+    {
+        ctx->first_error = ctx->line;
+    }
+    ctx->errors++;
+}
+
+static int param_text_value(param_tbl_t *tbl, int idx, const char *value, u8 *buf)//parse a value, all of the text must be used and fit the param
+{
+    int size = tbl->msgs[idx].size;
+    char *end = NULL;
+    
+    memset(buf, 0, size);
+    switch(tbl->msgs[idx].type)
+    {
+    case PTYPE_STR:
+        if ((int)strlen(value) > size - 1)
+        {
+            return(-RT_ERROR);
+        }
+        memcpy(buf, value, strlen(value));
+        return(RT_EOK);
+    case PTYPE_ARRAY:
+        for (int n = 0; ; n++)//hex bytes with one separator, the parse is bounded by size
+        {
+            long byte = strtol(value, &end, 16);
+            if ((end == value) || (n >= size) || (byte < 0) || (byte > 0xFF))
+            {
+                return(-RT_ERROR);
+            }
+            buf[n] = byte;
+            if (*end == 0)
+            {
+                return(RT_EOK);
+            }
+            value = end + 1;
+        }
+    case PTYPE_INT:
+        {
+            s64 lval = strtoll(value, &end, 0);
+            memcpy(buf, &lval, size);
+        }
+        break;
+    case PTYPE_HEX:
+        {
+            u64 lval = strtoull(value, &end, 16);
+            memcpy(buf, &lval, size);
+        }
+        break;
+    case PTYPE_FLOAT:
+        {
+            f64 fval = strtod(value, &end);
+            f32 fval32 = fval;
+            memcpy(buf, (size == sizeof(f32)) ? (void *)&fval32 : (void *)&fval, size);
+        }
+        break;
+    default:
+        return(-RT_ERROR);
+    }
+    
+    return(((end != value) && (*end == 0)) ? RT_EOK : -RT_ERROR);
+}
+
+static void param_text_line(param_text_t *ctx)//stage the value of one complete line
+{
+    param_tbl_t *tbl = ctx->tbl;
+    u8 buf[PARAM_VALUE_MAX];
+    char *name, *value, *eq;
+    int idx;
+    
+    ctx->buf[ctx->len] = 0;
+    name = param_text_trim(ctx->buf);
+    if ((*name == 0) || (*name == '#'))
+    {
+        return;
+    }
+    eq = strchr(name, '=');
+    if (eq == NULL)
+    {
+        param_text_error(ctx, "no '=' in line", "");
+        return;
+    }
+    *eq = 0;
+    name = param_text_trim(name);
+    value = param_text_trim(eq + 1);
+    idx = param_name_index_find(tbl, ctx->index, ctx->slots, param_hash(name, strlen(name)), name);
+    if (idx < 0)
+    {
+        param_text_error(ctx, "unknown param", name);
+        return;
+    }
+    if (param_text_value(tbl, idx, value, buf) != RT_EOK)
+    {
+        param_text_error(ctx, "bad value of param", name);
+        return;
+    }
+    memcpy(ctx->stage + tbl->offsets[idx], buf, tbl->msgs[idx].size);
+    ctx->staged[idx >> 3] |= (1 << (idx & 7));
+    ctx->count++;
+}
+
+static void param_text_apply(param_tbl_t *tbl, param_batch_t *batch, const void *arg)//walk of staged values
+{
+    const param_text_t *ctx = arg;
+    
+    for (int i = 0; i < tbl->total; i++)
+    {
+        if ((ctx->staged[i >> 3] >> (i & 7)) & 1)
+        {
+            param_set_value(tbl, batch, i, ctx->stage + tbl->offsets[i]);
+        }
+    }
+}
+
+static void param_text_free(param_text_t *ctx)
+{
+    if (ctx->index != NULL)
+    {
+        free(ctx->index);
+    }
+    ctx->index = NULL;
+    ctx->stage = NULL;
+    ctx->staged = NULL;
+    ctx->tbl = NULL;
+}
+
+int param_tbl_text_begin(param_tbl_t *tbl, param_text_t *ctx)
+{
+    int slots = param_name_index_slots(tbl);
+    int index_size = slots * sizeof(param_name_slot_t);
+    u8 *mem;
+    
+    if (tbl->mutex == NULL)
+    {
+        LOG_E("param text import fail. param no initialized.");
+        return(-RT_ERROR);
+    }
+    
+    //name index, staged values and staged map in one block
+    mem = malloc(index_size + tbl->size + (tbl->total + 7) / 8);
+    if (mem == NULL)
+    {
+        LOG_E("param text import fail. no memory.");
+        return(-RT_ERROR);
+    }
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->tbl = tbl;
+    ctx->index = mem;
+    ctx->stage = mem + index_size;
+    ctx->staged = ctx->stage + tbl->size;
+    ctx->slots = slots;
+    ctx->line = 1;
+    memset(ctx->staged, 0, (tbl->total + 7) / 8);
+    param_name_index_build(tbl, ctx->index, slots);
+    
+    return(RT_EOK);
+}
+
+int param_text_feed(param_text_t *ctx, const char *text, int len)
+{
+    if (ctx->tbl == NULL)
+    {
+        LOG_E("param text import fail. import is not begun.");
+        return(-RT_ERROR);
+    }
+    
+    for (int i = 0; i < len; i++)
+    {
+        char c = text[i];
+        if (c == '\n')
+        {
+            if (ctx->skip)
+            {
+                param_text_error(ctx, "line is too long", "");
+            }
+            else
+            {
+                param_text_line(ctx);
+            }
+            ctx->line++;
+            ctx->len = 0;
+            ctx->skip = 0;
+            continue;
+        }
+        if (ctx->len >= PARAM_TEXT_LINE_MAX - 1)
+        {
+            ctx->skip = 1;
+            continue;
+        }
+        ctx->buf[ctx->len++] = c;
+    }
+    
+    return(RT_EOK);
+}
+
+int param_text_end(param_text_t *ctx)
+{
+    param_tbl_t *tbl = ctx->tbl;
+    int errors, rst;
+    
+    if (tbl == NULL)
+    {
+        LOG_E("param text import fail. import is not begun.");
+        return(-RT_ERROR);
+    }
+    if ((ctx->len > 0) || ctx->skip)//last line without newline
+    {
+        param_text_feed(ctx, "\n", 1);
+    }
+    
+    rst = param_batch_apply(tbl, param_text_apply, ctx);
+    errors = ctx->errors;
+    LOG_D("param text import. %d params staged, %d lines with error.", ctx->count, errors);
+    param_text_free(ctx);
+    if ((rst != RT_EOK) || (param_batch_save(tbl) != RT_EOK))
+    {
+        return(-RT_ERROR);
+    }
+    
+    return(errors);
+}
+
+void param_text_abort(param_text_t *ctx)
+{
+    param_text_free(ctx);
+}
+#endif
+
+#ifdef PARAM_USING_STATS
+int param_tbl_stats_get(param_tbl_t *tbl, param_stats_t *stats)
+{
+    if (stats == NULL)
+    {
+        return(-RT_ERROR);
+    }
+    
+    if (tbl->mutex == NULL)//not initialized, counters of last run are kept
+    {
+        *stats = tbl->stats;
+        return(RT_EOK);
+    }
+    param_mutex_take(tbl);
+    *stats = tbl->stats;
+    param_mutex_release(tbl);
+    return(RT_EOK);
+}
+
+void param_tbl_stats_reset(param_tbl_t *tbl)
+{
+    if (tbl->mutex == NULL)
+    {
+        memset(&tbl->stats, 0, sizeof(tbl->stats));
+        return;
+    }
+    param_mutex_take(tbl);
+    memset(&tbl->stats, 0, sizeof(tbl->stats));
+    param_mutex_release(tbl);
+}
+#endif
+
+#ifdef PARAM_USING_PROFILE
+static u32 param_prof_hits(const param_prof_t *prof)//saturated sum, so a wrapped counter still ranks high
+{
+    u32 hits = prof->reads + prof->writes;
+    return((hits < prof->reads) ? 0xFFFFFFFF : hits);
+}
+
+int param_tbl_prof_rank(param_tbl_t *tbl, u16 *order, int count)
+{
+    int n = 0;
+    
+    if ((order == NULL) || (count < 0))
+    {
+        return(-RT_ERROR);
+    }
+    
+    for (int i = 0; i < tbl->total; i++)//insertion into the sorted top list, equal hits keep the table order
+    {
+        u32 hits = param_prof_hits(&tbl->prof[i]);
+        int pos = n;
+        
+        while ((pos > 0) && (param_prof_hits(&tbl->prof[order[pos - 1]]) < hits))
+        {
+            pos--;
+        }
+        if (pos >= count)
+        {
+            continue;
+        }
+        if (n < count)
+        {
+            n++;
+        }
+        memmove(&order[pos + 1], &order[pos], (n - 1 - pos) * sizeof(order[0]));
+        order[pos] = i;
+    }
+    
+    return(n);
+}
+
+void param_tbl_prof_reset(param_tbl_t *tbl)
+{
+    memset(tbl->prof, 0, tbl->total * sizeof(param_prof_t));
+}
+#endif
+
+#ifdef PARAM_USING_PRESET
+int param_tbl_preset_store(param_tbl_t *tbl, const char *name)
+{
+    int preset, rst;
+    
+    if (PARAM_TBL_STORAGE(tbl) == NULL || tbl->mutex == NULL)
+    {
+        LOG_E("param preset store failed. param no initialized.");
+        return(-RT_ERROR);
+    }
+    preset = param_preset_find(tbl, name);
+    if (preset < 0)
+    {
+        return(-RT_ERROR);
+    }
+    
+    param_mutex_take(tbl);
+    #ifdef PARAM_USING_XIP
+    if (tbl->preset_cur == preset)//clean params are read from the preset sector itself
+    {
+        param_mutex_release(tbl);
+        LOG_E("param preset store failed. preset %s is mapped, save or switch first.", name);
+        return(-RT_ERROR);
+    }
+    #endif
+    rst = param_preset_write(tbl, preset);
+    param_mutex_release(tbl);
+    
+    if (rst != RT_EOK)
+    {
+        LOG_E("param preset store failed. preset : %s", name);
+        return(-RT_ERROR);
+    }
+    return(RT_EOK);
+}
+
+int param_tbl_preset_switch(param_tbl_t *tbl, const char *name)
+{
+    int preset, rst;
+    
+    if (PARAM_TBL_STORAGE(tbl) == NULL || tbl->mutex == NULL)
+    {
+        LOG_E("param preset switch failed. param no initialized.");
+        return(-RT_ERROR);
+    }
+    preset = param_preset_find(tbl, name);
+    if (preset < 0)
+    {
+        return(-RT_ERROR);
+    }
+    
+    param_mutex_take(tbl);
+    rst = param_preset_apply(tbl, preset);
+    param_mutex_release(tbl);
+    
+    if (rst != RT_EOK)
+    {
+        LOG_E("param preset switch failed. preset : %s", name);
+        return(-RT_ERROR);
+    }
+    return(RT_EOK);
+}
+
+const char *param_tbl_preset_active(param_tbl_t *tbl)
+{
+    int preset = tbl->preset_cur;
+    
+    return((preset >= 0) ? tbl->cfg.presets[preset] : NULL);
+}
+#endif
+
+int param_init(void)
+{
+    return(param_tbl_init(&param_tbl_main));
+}
+
+void param_deinit(void)
+{
+    param_tbl_deinit(&param_tbl_main);
+}
+
+int param_load_from_flash(void)
+{
+    return(param_tbl_load(&param_tbl_main));
+}
+
+int param_save_to_flash(void)
+{
+    return(param_tbl_save(&param_tbl_main));
+}
+
+int param_resume_all(void)
+{
+    return(param_tbl_resume_all(&param_tbl_main));
+}
+
+#ifndef PARAM_USING_INDEX_ONLY
+const char *param_get_name(int idx)
+{
+    return(param_tbl_get_name(&param_tbl_main, idx));
+}
+#endif
+
+int param_resume_by_index(int idx)
+{
+    return(param_tbl_resume_by_index(&param_tbl_main, idx));
+}
+
+int param_read_by_index(int idx, void *addr, int size)
+{
+    return(param_tbl_read_by_index(&param_tbl_main, idx, addr, size));
+}
+
+int param_write_by_index(int idx, const void *addr, int size)
+{
+    return(param_tbl_write_by_index(&param_tbl_main, idx, addr, size));
+}
+
+#ifndef PARAM_USING_INDEX_ONLY
+int param_resume_by_name(char *name)
+{
+    return(param_tbl_resume_by_name(&param_tbl_main, name));
+}
+
+int param_read_by_name(char *name, void *addr, int size)
+{
+    return(param_tbl_read_by_name(&param_tbl_main, name, addr, size));
+}
+
+int param_write_by_name(char *name, const void *addr, int size)
+{
+    return(param_tbl_write_by_name(&param_tbl_main, name, addr, size));
+}
+#endif
+
+#ifdef PARAM_USING_DYNAMIC
+int param_dyn_set(const char *key, const void *val, int len)
+{
+    return(param_tbl_dyn_set(&param_tbl_main, key, val, len));
+}
+
+int param_dyn_get(const char *key, void *buf, int size)
+{
+    return(param_tbl_dyn_get(&param_tbl_main, key, buf, size));
+}
+
+int param_dyn_delete(const char *key)
+{
+    return(param_tbl_dyn_delete(&param_tbl_main, key));
+}
+#endif
+
+#ifdef PARAM_USING_EXPORT
+int param_export(void *buf, int size, int flags)
+{
+    return(param_tbl_export(&param_tbl_main, buf, size, flags));
+}
+
+int param_import(const void *buf, int size)
+{
+    return(param_tbl_import(&param_tbl_main, buf, size));
+}
+
+#ifdef PARAM_USING_DELTA
+int param_delta_export(u32 epoch, u32 since, void *buf, int size)
+{
+    return(param_tbl_delta_export(&param_tbl_main, epoch, since, buf, size));
+}
+
+u32 param_generation(void)
+{
+    return(param_tbl_generation(&param_tbl_main));
+}
+
+u32 param_epoch(void)
+{
+    return(param_tbl_epoch(&param_tbl_main));
+}
+#endif
+#endif
+
+#ifdef PARAM_USING_TEXT_IMPORT
+int param_text_begin(param_text_t *ctx)
+{
+    return(param_tbl_text_begin(&param_tbl_main, ctx));
+}
+#endif
+
+#ifdef PARAM_USING_STATS
+int param_stats_get(param_stats_t *stats)
+{
+    return(param_tbl_stats_get(&param_tbl_main, stats));
+}
+
+void param_stats_reset(void)
+{
+    param_tbl_stats_reset(&param_tbl_main);
+}
+#endif
+
+#ifdef PARAM_USING_PROFILE
+int param_prof_rank(u16 *order, int count)
+{
+    return(param_tbl_prof_rank(&param_tbl_main, order, count));
+}
+
+void param_prof_reset(void)
+{
+    param_tbl_prof_reset(&param_tbl_main);
+}
+#endif
+
+#ifdef PARAM_USING_PRESET
+int param_preset_store(const char *name)
+{
+    return(param_tbl_preset_store(&param_tbl_main, name));
+}
+
+int param_preset_switch(const char *name)
+{
+    return(param_tbl_preset_switch(&param_tbl_main, name));
+}
+
+const char *param_preset_active(void)
+{
+    return(param_tbl_preset_active(&param_tbl_main));
+}
+#endif
+
+#ifdef PARAM_USING_CLI
+typedef enum{
+    POUT_TEXT = 0,      //0-aligned columns for reading
+    POUT_JSON,          //1-one json object of each param
+    POUT_CSV            //2-comma separated values with a header row
+}param_out_t;
+
+typedef struct
+{
+    int len;
+    char buf[PARAM_CLI_LINE_MAX];
+}param_line_t;
+
+static void param_line_flush(param_line_t *line)//print the buffered row and a new line
+{
+    line->buf[line->len] = 0;
+    PARAM_PRINT("%s\n", line->buf);
+    line->len = 0;
+}
+
+static void param_line_putc(param_line_t *line, char c)
+{
+    if (line->len >= (int)sizeof(line->buf) - 1)//row is longer than buffer, print the part before
+    {
+        line->buf[line->len] = 0;
+        PARAM_PRINT("%s", line->buf);
+        line->len = 0;
+    }
+    line->buf[line->len++] = c;
+}
+
+static void param_line_puts(param_line_t *line, const char *str)
+{
+    while (*str)
+    {
+        param_line_putc(line, *str++);
+    }
+}
+
+static void param_line_col(param_line_t *line, const char *str, int width)//string and spaces to the width of column
+{
+    int len = strlen(str);
+    param_line_puts(line, str);
+    while (len++ < width)
+    {
+        param_line_putc(line, ' ');
     }
+}
 
-    param_mutex_release();
+static void param_line_int(param_line_t *line, s64 val, int width)
+{
+    char str[24];
+    char *p = str + sizeof(str) - 1;
+    u64 uval = (val < 0) ? (0 - (u64)val) : (u64)val;
     
-    return ((psize > 0) ? RT_EOK : -RT_ERROR);
+    *p = 0;
+    do
+    {
+        *--p = '0' + (uval % 10);
+        uval /= 10;
+    } while (uval);
+    if (val < 0)
+    {
+        *--p = '-';
+    }
+    param_line_col(line, p, width);
 }
 
-int param_write_by_index(int idx, const void *addr, int size)
+static void param_line_hex(param_line_t *line, u64 val, int digits)
 {
-    param_type_t ptype;
-    u32 psize;
-    u8 *paddr;
-    
-    if (param_datas == NULL || param_mutex == NULL)
+    static const char hex[] = "0123456789ABCDEF";
+    while (digits-- > 0)
     {
-        LOG_E("param write fail. param no initialized.");
-        return(-RT_ERROR);
+        param_line_putc(line, hex[(val >> (digits * 4)) & 0x0F]);
     }
-    
-    if (((u32)idx >= PARAM_TOTAL) || (addr == NULL) || (size <= 0))
+}
+
+static void param_line_quote(param_line_t *line, const char *str, int size, int mode)//string quoted as json or csv
+{
+    param_line_putc(line, '"');
+    for (int i = 0; (i < size) && str[i]; i++)
     {
-        LOG_E("param write fail. input parameter error.");
-        return(-RT_ERROR);
+        char c = str[i];
+        if (c == '"')
+        {
+            param_line_putc(line, (mode == POUT_JSON) ? '\\' : '"');
+        }
+        else if ((mode == POUT_JSON) && (c == '\\'))
+        {
+            param_line_putc(line, '\\');
+        }
+        else if ((mode == POUT_JSON) && ((u8)c < 0x20))
+        {
+            param_line_puts(line, "\\u00");
+            param_line_hex(line, (u8)c, 2);
+            continue;
+        }
+        param_line_putc(line, c);
     }
+    param_line_putc(line, '"');
+}
+
+static const char *param_type_name(int type, int size, char *str)
+{
+    switch(type)
+    {
+    case PTYPE_STR:
+        return("string");
+    case PTYPE_ARRAY:
+        return("array");
+    case PTYPE_INT:
+        sprintf(str, "int%d", size*8);
+        return(str);
+    case PTYPE_HEX:
+        sprintf(str, "hex%d", size*8);
+        return(str);
+    case PTYPE_FLOAT:
+        return((size == sizeof(f32)) ? "float" : "double");
+    default:
+        return("unknow");
+    }
+}
+
+static void param_line_type(param_line_t *line, int type, int size, int width)
+{
+    char str[8];
+    param_line_col(line, param_type_name(type, size, str), width);
+}
+
+static void param_line_value(param_line_t *line, int type, int size, const void *val, int mode)
+{
+    const u8 *pv = (const u8 *)val;
     
-    ptype = param_msg_table[idx].type;
-    psize = param_msg_table[idx].size;
-    paddr = param_datas + param_offset_table[idx];
-    
-    param_mutex_take();
-    
-    switch (ptype)
+    switch(type)
     {
     case PTYPE_STR:
-        size = strlen(addr);
-        if (size > (psize - 1))
+        if ((mode == POUT_JSON) || ((mode == POUT_CSV) && strpbrk((const char *)val, ",\"\r\n")))
         {
-            size = (psize - 1);
+            param_line_quote(line, (const char *)val, size, mode);
+            break;
+        }
+        for (int i = 0; (i < size) && pv[i]; i++)
+        {
+            param_line_putc(line, pv[i]);
         }
-        memcpy(paddr, addr, size);
-        paddr[size] = 0;
         break;
     case PTYPE_ARRAY:
-        if (size > psize)
+        if (mode == POUT_JSON)
         {
-            size = psize;
+            param_line_putc(line, '"');
         }
-        memcpy(paddr, addr, size);
-        break;
-    case PTYPE_INT:
+        for (int i = 0; i < size; i++)
         {
-            s64 lval;
-            
-            if (size != sizeof(u8) && size != sizeof(u16) && size != sizeof(u32) && size != sizeof(u64))
+            if (i != 0)
             {
-                size = 0;
-                break;
+                param_line_putc(line, ' ');
             }
-            
-            if (size == sizeof(u8))
+            param_line_hex(line, pv[i], 2);
+        }
+        if (mode == POUT_JSON)
+        {
+            param_line_putc(line, '"');
+        }
+        break;
+    case PTYPE_INT:
+        {
+            s64 lval = 0;
+            if (size == sizeof(s8))
             {
-                lval = *((s8 *)addr);
+                lval = *((s8*)val);
             }
-            else if (size == sizeof(u16))
+            else if (size == sizeof(s16))
             {
                 s16 tv;
-                memcpy((u8 *)&tv, addr, size);
-                lval = (s64)tv;
+                memcpy((u8 *)&tv, val, size);
+                lval = tv;
             }
-            else if (size == sizeof(u32))
+            else if (size == sizeof(s32))
             {
                 s32 tv;
-                memcpy((u8 *)&tv, addr, size);
-                lval = (s64)tv;
+                memcpy((u8 *)&tv, val, size);
+                lval = tv;
             }
-            else
+            else if (size == sizeof(s64))
             {
-                memcpy((u8 *)&lval, addr, size);
+                memcpy((u8 *)&lval, val, size);
             }
-            
-            memcpy(paddr, (u8 *)&lval, psize);
-            size = psize;
+            param_line_int(line, lval, 0);
         }
         break;
     case PTYPE_HEX:
         {
-            u64 lval;
-            
-            if (size != sizeof(u8) && size != sizeof(u16) && size != sizeof(u32) && size != sizeof(u64))
+            u64 lval = 0;
+            if (size > (int)sizeof(u64))
             {
-                size = 0;
                 break;
             }
-            
-            if (size == sizeof(u8))
-            {
-                lval = *((u8 *)addr);
-            }
-            else if (size == sizeof(u16))
-            {
-                u16 tv;
-                memcpy((u8 *)&tv, addr, size);
-                lval = (u64)tv;
-            }
-            else if (size == sizeof(u32))
+            memcpy((u8 *)&lval, val, size);//little endian
+            if (mode == POUT_JSON)
             {
-                u32 tv;
-                memcpy((u8 *)&tv, addr, size);
-                lval = (u64)tv;
+                param_line_putc(line, '"');
             }
-            else
+            param_line_hex(line, lval, size * 2);
+            if (mode == POUT_JSON)
             {
-                memcpy((u8 *)&lval, addr, size);
+                param_line_putc(line, '"');
             }
-            
-            memcpy(paddr, (u8 *)&lval, psize);
-            size = psize;
         }
         break;
     case PTYPE_FLOAT:
         {
-            f64 fval;
-            
-            if (size != sizeof(f32) && size != sizeof(f64))
-            {
-                size = 0;
-                break;
-            }
-            
+            char tbuf[32];
+            double fval;
             if (size == sizeof(f32))
             {
                 f32 tv;
-                memcpy((u8*)&tv, addr, size);
-                fval = (f64)tv;
+                memcpy((u8 *)&tv, val, size);
+                fval = tv;
             }
             else
             {
-                memcpy((u8*)&fval, addr, size);
-            }
-
-            if (psize == sizeof(f32))
-            {
-                f32 tv = fval;
-                memcpy(paddr, (u8 *)&tv, psize);
+                memcpy((u8 *)&fval, val, sizeof(fval));
             }
-            else
+            if ((mode == POUT_JSON) && ((fval != fval) || (fval > DBL_MAX) || (fval < -DBL_MAX)))//nan or inf is not a json number
             {
-                memcpy(paddr, (u8 *)&fval, psize);
+                param_line_puts(line, "null");
+                break;
             }
-
-            size = psize;
+            snprintf(tbuf, sizeof(tbuf), (size == sizeof(f32)) ? "%.3f" : "%.5f", fval);
+            param_line_puts(line, tbuf);
         }
         break;
     default:
-        size = 0;
         break;
     }
+}
+
+static void param_line_param(param_line_t *line, param_tbl_t *tbl, int idx, int mode)//one row of the param
+{
+    char buf[PARAM_VALUE_MAX + 1];
+    const char *name = param_tbl_get_name(tbl, idx);
+    int type = param_get_type(tbl, idx);
+    int size = param_get_size(tbl, idx);
+    
+    if (param_tbl_read_by_index(tbl, idx, buf, size) < 0)
+    {
+        memset(buf, 0, size);
+    }
+    buf[size] = 0;
+    switch(mode)
+    {
+    case POUT_JSON:
+        param_line_puts(line, "{\"name\":");
+        param_line_quote(line, name, PARAM_VALUE_MAX, mode);
+        param_line_puts(line, ",\"type\":\"");
+        param_line_type(line, type, size, 0);
+        param_line_puts(line, "\",\"size\":");
+        param_line_int(line, size, 0);
+        param_line_puts(line, ",\"value\":");
+        param_line_value(line, type, size, buf, mode);
+        param_line_putc(line, '}');
+        break;
+    case POUT_CSV:
+        param_line_puts(line, name);
+        param_line_putc(line, ',');
+        param_line_type(line, type, size, 0);
+        param_line_putc(line, ',');
+        param_line_int(line, size, 0);
+        param_line_putc(line, ',');
+        param_line_value(line, type, size, buf, mode);
+        break;
+    default:
+        param_line_col(line, name, 16+2);
+        param_line_type(line, type, size, 6+2);
+        param_line_int(line, size, 4+2);
+        param_line_value(line, type, size, buf, mode);
+        break;
+    }
+}
+
+static int param_name_match(const char *name, const char *prefix)//prefix may end with '*'
+{
+    int len;
     
-    param_mutex_release();
+    if (prefix == NULL)
+    {
+        return(1);
+    }
+    len = strlen(prefix);
+    if ((len > 0) && (prefix[len - 1] == '*'))
+    {
+        len--;
+    }
+    return(strncmp(name, prefix, len) == 0);
+}
+
+static int param_cli_options(int argc, char **argv, const char **arg)//parse -j/-c of output mode, the other argument is returned
+{
+    int mode = POUT_TEXT;
     
-    #ifdef PARAM_USING_AUTO_SAVE
-    if (psize > 0)
+    *arg = NULL;
+    for (int i = 2; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-j") == 0)
+        {
+            mode = POUT_JSON;
+        }
+        else if (strcmp(argv[i], "-c") == 0)
+        {
+            mode = POUT_CSV;
+        }
+        else
+        {
+            *arg = argv[i];
+        }
+    }
+    return(mode);
+}
+
+static void param_list_cmd(param_tbl_t *tbl, int argc, char **argv)
+{
+    param_line_t line;
+    const char *prefix;
+    int mode = param_cli_options(argc, argv, &prefix);
+    int count = 0;
+    
+    line.len = 0;
+    if (mode == POUT_TEXT)
+    {
+        PARAM_PRINT("\n");
+        PARAM_PRINT("name              type    size  value          \n");
+        PARAM_PRINT("----------------  ------  ----  -------------  \n");
+    }
+    else if (mode == POUT_CSV)
+    {
+        PARAM_PRINT("name,type,size,value\n");
+    }
+    else
+    {
+        PARAM_PRINT("[\n");
+    }
+    for (int i=0; i<tbl->total; i++)
+    {
+        if ( ! param_name_match(param_tbl_get_name(tbl, i), prefix))
+        {
+            continue;
+        }
+        if ((mode == POUT_JSON) && (count != 0))
+        {
+            param_line_putc(&line, ',');
+        }
+        param_line_param(&line, tbl, i, mode);
+        param_line_flush(&line);
+        count++;
+    }
+    if (mode == POUT_JSON)
+    {
+        PARAM_PRINT("]\n");
+    }
+    else if (mode == POUT_TEXT)
+    {
+        if (prefix)
+        {
+            PARAM_PRINT("---- param total : %d/%d ----\n", count, tbl->total);
+        }
+        else
+        {
+            PARAM_PRINT("---- param total : %d ----\n", tbl->total);
+        }
+    }
+}
+
+#ifdef PARAM_USING_COMPRESS
+static void param_bench(param_tbl_t *tbl, int count)
+{
+    static const char *comp_name[] = {"none", "rle"};
+    u8 comp_bak = tbl->comp;
+    param_line_t line;
+    
+    line.len = 0;
+    PARAM_PRINT("\n");
+    PARAM_PRINT("comp    raw     flash   save(us)    load(us)    \n");
+    PARAM_PRINT("------  ------  ------  ----------  ----------  \n");
+    for (int comp = PCOMP_NONE; comp <= PCOMP_RLE; comp++)
+    {
+        param_ext_head_t head;
+        rt_tick_t save_tick, load_tick;
+        
+        tbl->comp = comp;
+        save_tick = rt_tick_get();
+        for (int i = 0; i < count; i++)
+        {
+            param_tbl_save(tbl);
+        }
+        save_tick = rt_tick_get() - save_tick;
+        load_tick = rt_tick_get();
+        for (int i = 0; i < count; i++)
+        {
+            param_tbl_load(tbl);
+        }
+        load_tick = rt_tick_get() - load_tick;
+        #ifdef PARAM_USING_PRE_ERASE
+        if (param_flash_read(tbl, param_slot_addr(tbl, tbl->slot_cur), (u8*)&head, sizeof(head)) < 0)
+        #else
+        if (param_flash_read(tbl, tbl->cfg.save_addr, (u8*)&head, sizeof(head)) < 0)
+        #endif
+        {
+            PARAM_PRINT("param bench read head fail.\n");
+            break;
+        }
+        
+        param_line_col(&line, comp_name[comp], 6+2);
+        param_line_int(&line, head.raw_size, 6+2);
+        param_line_int(&line, head.size, 6+2);
+        param_line_int(&line, (u64)save_tick * 1000000 / RT_TICK_PER_SECOND / count, 10+2);
+        param_line_int(&line, (u64)load_tick * 1000000 / RT_TICK_PER_SECOND / count, 10+2);
+        param_line_flush(&line);
+    }
+    tbl->comp = comp_bak;
+}
+#endif
+
+#ifdef PARAM_USING_DYNAMIC
+static void param_line_dyn_value(param_line_t *line, const u8 *val, int len)
+{
+    int i;
+    
+    for (i = 0; (i < len) && (val[i] >= 0x20) && (val[i] < 0x7F); i++);
+    if (i == len)//printable string
+    {
+        for (i = 0; i < len; i++)
+        {
+            param_line_putc(line, val[i]);
+        }
+        return;
+    }
+    param_line_value(line, PTYPE_ARRAY, len, val, POUT_TEXT);
+}
+
+static void param_dyn_cmd(param_tbl_t *tbl, int argc, char **argv)
+{
+    param_line_t line;
+    
+    line.len = 0;
+    if (tbl->dyn_arena == NULL)
+    {
+        PARAM_PRINT("param no initialized.\n");
+        return;
+    }
+    if (argc < 3)
+    {
+        u32 pos = 0;
+        PARAM_PRINT("\n");
+        PARAM_PRINT("name              size  value          \n");
+        PARAM_PRINT("----------------  ----  -------------  \n");
+        param_mutex_take(tbl);
+        while (pos < tbl->dyn_used)
+        {
+            param_dyn_rec_t *rec = (param_dyn_rec_t *)(tbl->dyn_arena + pos);
+            if (rec->flag == PARAM_DYN_LIVE)
+            {
+                param_line_col(&line, (const char *)(rec + 1), 16+2);
+                param_line_int(&line, rec->vlen, 4+2);
+                param_line_dyn_value(&line, (u8 *)(rec + 1) + rec->klen + 1, rec->vlen);
+                param_line_flush(&line);
+            }
+            pos += param_dyn_rec_size(rec->klen, rec->vlen);
+        }
+        PARAM_PRINT("---- dynamic total : %d/%d, arena : %d/%d ----", tbl->dyn_count, param_dyn_max_count(tbl),
+                    tbl->dyn_used - tbl->dyn_garbage, tbl->dyn_size);
+        param_mutex_release(tbl);
+        PARAM_PRINT("\n");
+        return;
+    }
+    if ((strcmp(argv[2], "set") == 0) && (argc >= 5))
+    {
+        if (param_tbl_dyn_set(tbl, argv[3], argv[4], strlen(argv[4])) == RT_EOK)
+        {
+            PARAM_PRINT("set dynamic param success, the name is %s\n", argv[3]);
+        }
+        return;
+    }
+    if ((strcmp(argv[2], "get") == 0) && (argc >= 4))
+    {
+        u8 buf[128];
+        int len = param_tbl_dyn_get(tbl, argv[3], buf, sizeof(buf));
+        if (len < 0)
+        {
+            PARAM_PRINT("this dynamic param don`t exist, the name is %s\n", argv[3]);
+            return;
+        }
+        param_line_dyn_value(&line, buf, (len < (int)sizeof(buf)) ? len : (int)sizeof(buf));
+        param_line_flush(&line);
+        return;
+    }
+    if ((strcmp(argv[2], "del") == 0) && (argc >= 4))
+    {
+        if (param_tbl_dyn_delete(tbl, argv[3]) == RT_EOK)
+        {
+            PARAM_PRINT("delete dynamic param success, the name is %s\n", argv[3]);
+        }
+        else
+        {
+            PARAM_PRINT("this dynamic param don`t exist, the name is %s\n", argv[3]);
+        }
+        return;
+    }
+    PARAM_PRINT("param dyn               -List display all dynamic params.\n");
+    PARAM_PRINT("param dyn set name val  -Create or update the dynamic param.\n");
+    PARAM_PRINT("param dyn get name      -Read the dynamic param.\n");
+    PARAM_PRINT("param dyn del name      -Delete the dynamic param.\n");
+}
+#endif
+
+#ifdef PARAM_USING_EXPORT
+#define PARAM_HEX_LINE_BYTES                32      //bytes of each exported hex line
+
+static u8 *param_import_blob = NULL;    //hex lines staged for import
+static int param_import_len = 0;
+static int param_import_size = 0;
+
+static int param_export_blob(param_tbl_t *tbl, int flags, u32 epoch, u32 since, u8 *buf, int size)
+{
+    #ifdef PARAM_USING_DELTA
+    if (flags & PARAM_EXPORT_DELTA)
     {
-        param_auto_save_start();
+        return(param_tbl_delta_export(tbl, epoch, since, buf, size));
     }
     #endif
-    
-    return ((psize > 0) ? RT_EOK : -RT_ERROR);
+    return(param_tbl_export(tbl, buf, size, flags));
 }
 
-int param_resume_by_name(char *name)//resume default by name
+static void param_export_cmd(param_tbl_t *tbl, int argc, char **argv)
 {
-    int idx = param_find_by_name(name);
-    if (idx < 0)
+    int flags = ((argc >= 3) && (strcmp(argv[2], "diff") == 0)) ? PARAM_EXPORT_SPARSE : 0;
+    u32 epoch = 0, since = 0;
+    int size;
+    u8 *blob;
+    
+    #ifdef PARAM_USING_DELTA
+    if ((argc >= 5) && (strcmp(argv[2], "since") == 0))
     {
-        LOG_E("param resume fail by name. parameter don`t exist.");
-        return(-RT_ERROR);
+        flags = PARAM_EXPORT_SPARSE | PARAM_EXPORT_DELTA;
+        epoch = strtoul(argv[3], NULL, 0);
+        since = strtoul(argv[4], NULL, 0);
     }
-    
-    return(param_resume_by_index(idx));
+    #endif
+    size = param_export_blob(tbl, flags, epoch, since, NULL, 0);
+    if (size < 0)
+    {
+        return;
+    }
+    blob = malloc(size);
+    if (blob == NULL)
+    {
+        PARAM_PRINT("param export fail. no memory.\n");
+        return;
+    }
+    size = param_export_blob(tbl, flags, epoch, since, blob, size);
+    for (int i = 0; i < size; i++)
+    {
+        PARAM_PRINT("%02X", blob[i]);
+        if (((i + 1) % PARAM_HEX_LINE_BYTES == 0) || (i + 1 == size))
+        {
+            PARAM_PRINT("\n");
+        }
+    }
+    if ((size > 0) && (flags & PARAM_EXPORT_DELTA))
+    {
+        u32 gen;
+        
+        memcpy(&epoch, blob + sizeof(param_export_head_t), sizeof(epoch));
+        memcpy(&gen, blob + sizeof(param_export_head_t) + sizeof(epoch), sizeof(gen));
+        PARAM_PRINT("---- export size : %d, epoch : %u, generation : %u ----\n", size, epoch, gen);
+    }
+    else if (size > 0)
+    {
+        PARAM_PRINT("---- export size : %d ----\n", size);
+    }
+    free(blob);
 }
 
-int param_read_by_name(char *name, void *addr, int size)//read param by name
+static int param_hex_digit(char c)
 {
-    int idx = param_find_by_name(name);
-    if (idx < 0)
+    if ((c >= '0') && (c <= '9'))
     {
-        LOG_E("param read fail by name. parameter don`t exist.");
-        return(-RT_ERROR);
+        return(c - '0');
+    }
+    if ((c >= 'a') && (c <= 'f'))
+    {
+        return(c - 'a' + 10);
     }
+    if ((c >= 'A') && (c <= 'F'))
+    {
+        return(c - 'A' + 10);
+    }
+    return(-1);
+}
+
+static int param_import_max(param_tbl_t *tbl)//size of the biggest blob of table
+{
+    int size = sizeof(param_export_head_t) + tbl->size + tbl->total * PARAM_EXPORT_REC_SIZE;
     
-    return(param_read_by_index(idx, addr, size));
+    #ifdef PARAM_USING_DELTA
+    size += PARAM_DELTA_HEAD_SIZE;
+    #endif
+    return(size);
 }
 
-int param_write_by_name(char *name, const void *addr, int size)//write param by name
+static void param_import_free(void)
 {
-    int idx = param_find_by_name(name);
-    if (idx < 0)
+    if (param_import_blob != NULL)
     {
-        LOG_E("param write fail by name. parameter don`t exist.");
-        return(-RT_ERROR);
+        free(param_import_blob);
+        param_import_blob = NULL;
     }
-    
-    return(param_write_by_index(idx, addr, size));
+    param_import_len = 0;
+    param_import_size = 0;
 }
 
-#ifdef PARAM_USING_CLI
-static void param_print_str(const char *str, int min_len)
+static void param_import_cmd(param_tbl_t *tbl, int argc, char **argv)
 {
-    int empty_len = min_len - strlen(str);
-    if (empty_len < 0)
+    if (argc < 3)
+    {
+        PARAM_PRINT("param import begin      -Start import, the blob buffer is allocated.\n");
+        PARAM_PRINT("param import hex ...    -Append hex lines printed by param export.\n");
+        PARAM_PRINT("param import end        -Check and apply the blob, then save params.\n");
+        return;
+    }
+    if (strcmp(argv[2], "begin") == 0)
     {
-        empty_len = 0;
+        param_import_free();
+        param_import_size = param_import_max(tbl);
+        param_import_blob = malloc(param_import_size);
+        if (param_import_blob == NULL)
+        {
+            param_import_size = 0;
+            PARAM_PRINT("param import fail. no memory.\n");
+        }
+        return;
+    }
+    if (param_import_blob == NULL)
+    {
+        PARAM_PRINT("param import is not begun, please run 'param import begin' first.\n");
+        return;
+    }
+    if (strcmp(argv[2], "end") == 0)
+    {
+        if (param_tbl_import(tbl, param_import_blob, param_import_len) == RT_EOK)
+        {
+            PARAM_PRINT("param import success, %d bytes.\n", param_import_len);
+        }
+        else
+        {
+            PARAM_PRINT("param import fail, no param is changed.\n");
+        }
+        param_import_free();
+        return;
     }
-    PARAM_PRINT("%s", str);
-    for (int i=0; i<empty_len; i++)
+    for (int n = 2; n < argc; n++)
     {
-        PARAM_PRINT(" ");
+        const char *p = argv[n];
+        while (*p != 0)
+        {
+            int hi = param_hex_digit(p[0]);
+            int lo = (hi < 0) ? -1 : param_hex_digit(p[1]);
+            if ((lo < 0) || (param_import_len >= param_import_size))
+            {
+                PARAM_PRINT("param import fail. bad hex or too long, please begin again.\n");
+                param_import_free();
+                return;
+            }
+            param_import_blob[param_import_len++] = (hi << 4) | lo;
+            p += 2;
+        }
     }
 }
+#endif
 
-static void param_print_size(int size, int min_len)
-{
-    char str[8];
-    sprintf(str, "%d", size);
-    param_print_str(str, min_len);
-}
+#ifdef PARAM_USING_TEXT_IMPORT
+static param_text_t param_text_ctx;     //text import of command line
 
-static void param_print_type(int type, int size, int min_len)
+static void param_text_cmd(param_tbl_t *tbl, int argc, char **argv)
 {
-    char *pstr;
-    char str[8];
-    switch(type)
+    if (argc < 3)
     {
-    case PTYPE_STR:
-        pstr = "string";
-        break;
-    case PTYPE_ARRAY:
-        pstr = "array";
-        break;
-    case PTYPE_INT:
-        sprintf(str, "int%d", size*8);
-        pstr = str;
-        break;
-    case PTYPE_HEX:
-        sprintf(str, "hex%d", size*8);
-        pstr = str;
-        break;
-    case PTYPE_FLOAT:
-        if(size == sizeof(f32))
+        PARAM_PRINT("param text begin        -Start text import.\n");
+        PARAM_PRINT("param text name=val ... -Stage lines, each argument is one line.\n");
+        PARAM_PRINT("param text end          -Apply staged params, then save params.\n");
+        PARAM_PRINT("param text abort        -Drop staged params.\n");
+        return;
+    }
+    if (strcmp(argv[2], "begin") == 0)
+    {
+        param_text_abort(&param_text_ctx);
+        if (param_tbl_text_begin(tbl, &param_text_ctx) == RT_EOK)
         {
-            pstr = "float";
+            PARAM_PRINT("param text import begin.\n");
         }
-        else
+        return;
+    }
+    if (param_text_ctx.tbl == NULL)
+    {
+        PARAM_PRINT("param text import is not begun, please run 'param text begin' first.\n");
+        return;
+    }
+    if (strcmp(argv[2], "abort") == 0)
+    {
+        param_text_abort(&param_text_ctx);
+        PARAM_PRINT("param text import abort.\n");
+        return;
+    }
+    if (strcmp(argv[2], "end") == 0)
+    {
+        int count = param_text_ctx.count;
+        int first = param_text_ctx.first_error;
+        int errors = param_text_end(&param_text_ctx);
+        if (errors < 0)
         {
-            pstr = "double";
+            PARAM_PRINT("param text import fail. params save error.\n");
+            return;
         }
-        break;
-    default:
-        pstr = "unknow";
-        break;
+        PARAM_PRINT("param text import success, %d lines staged, %d lines with error", count, errors);
+        if (errors > 0)
+        {
+            PARAM_PRINT(", the first is line %d", first);
+        }
+        PARAM_PRINT(".\n");
+        return;
+    }
+    for (int n = 2; n < argc; n++)
+    {
+        param_text_feed(&param_text_ctx, argv[n], strlen(argv[n]));
+        param_text_feed(&param_text_ctx, "\n", 1);
     }
-    param_print_str(pstr, min_len);
 }
+#endif
 
-static void param_print_value(int type, int size, void *val)
+#ifdef PARAM_USING_STATS
+static void param_stats_cmd(param_tbl_t *tbl, int argc, char **argv)
 {
-    switch(type)
+    static const char *api_name[PSTAT_API_TOTAL] = {"read_by_index", "read_by_name", "write_by_index", "write_by_name", "resume", "notify"};
+    static const char *rgn_name[PSTAT_RGN_TOTAL] = {"image", "backup", "journal", "dynamic", "spare", "preset"};
+    param_stats_t st;
+    param_line_t line;
+    
+    if ((argc >= 3) && (strcmp(argv[2], "reset") == 0))
     {
-    case PTYPE_STR:
-        PARAM_PRINT((char*)val);
-        break;
-    case PTYPE_ARRAY:
-        for (int i = 0; i < size; i++)
+        param_tbl_stats_reset(tbl);
+        PARAM_PRINT("param stats reset success.\n");
+        return;
+    }
+    param_tbl_stats_get(tbl, &st);
+    line.len = 0;
+    
+    PARAM_PRINT("\n");
+    PARAM_PRINT("api               calls       \n");
+    PARAM_PRINT("----------------  ----------  \n");
+    for (int i = 0; i < PSTAT_API_TOTAL; i++)
+    {
+        param_line_col(&line, api_name[i], 16+2);
+        param_line_int(&line, st.calls[i], 0);
+        param_line_flush(&line);
+    }
+    PARAM_PRINT("lock : takes %u, waits %u, wait %u us, max %u us\n", st.locks, st.lock_waits, st.lock_wait_us, st.lock_wait_max_us);
+    PARAM_PRINT("save : requests %u, coalesced %u, done %u, fails %u, max %u us\n",
+                st.save_requests, st.save_coalesced, st.saves, st.save_fails, st.save_max_us);
+    PARAM_PRINT("load : done %u, fails %u, from backup %u, crc fails %u, max %u us\n",
+                st.loads, st.load_fails, st.backup_loads, st.crc_fails, st.load_max_us);
+    #ifdef PARAM_USING_PACED_WRITE
+    PARAM_PRINT("write: yields %u, longest step %u us, budget %u us\n", st.write_yields, st.write_step_max_us, PARAM_WRITE_BUDGET_US);
+    #endif
+    
+    PARAM_PRINT("\n");
+    param_line_col(&line, "latency(ms)", 12);
+    for (int i = 0; i < PARAM_STATS_HIST; i++)
+    {
+        char str[8];
+        sprintf(str, (i < PARAM_STATS_HIST - 1) ? "<%d" : ">=%d", 1 << ((i < PARAM_STATS_HIST - 1) ? i : (i - 1)));
+        param_line_col(&line, str, 8);
+    }
+    param_line_flush(&line);
+    for (int n = 0; n < 2; n++)
+    {
+        const u32 *hist = (n == 0) ? st.save_hist : st.load_hist;
+        param_line_col(&line, (n == 0) ? "save" : "load", 12);
+        for (int i = 0; i < PARAM_STATS_HIST; i++)
         {
-            u8 *pv = (u8*)val;
-            if (i != 0)
-            {   
-                PARAM_PRINT(" ");
-            }
-            PARAM_PRINT("%02X", pv[i]);
+            param_line_int(&line, hist[i], 8);
         }
-        break;
-    case PTYPE_INT:
-        if (size == sizeof(s8))
+        param_line_flush(&line);
+    }
+    
+    PARAM_PRINT("\n");
+    PARAM_PRINT("region    erased(B)   programmed(B)  \n");
+    PARAM_PRINT("--------  ----------  -------------  \n");
+    for (int i = 0; i < PSTAT_RGN_TOTAL; i++)
+    {
+        param_line_col(&line, rgn_name[i], 8+2);
+        param_line_int(&line, st.erase_bytes[i], 10+2);
+        param_line_int(&line, st.prog_bytes[i], 0);
+        param_line_flush(&line);
+    }
+    
+    PARAM_PRINT("\n");
+    PARAM_PRINT("sector    erases      \n");
+    PARAM_PRINT("--------  ----------  \n");
+    for (int i = 0; (i < PARAM_STATS_SECTORS) && (st.sectors[i].erases > 0); i++)
+    {
+        param_line_puts(&line, "0x");
+        param_line_hex(&line, st.sectors[i].addr, 6);
+        param_line_col(&line, "", 2);
+        param_line_int(&line, st.sectors[i].erases, 0);
+        param_line_flush(&line);
+    }
+}
+#endif
+
+#ifdef PARAM_USING_PROFILE
+static void param_hot_def(param_tbl_t *tbl, const u16 *order, int group)//definitions of a group in suggested order
+{
+    static const char *store_name[] = {"", ", PARAM_IMMEDIATE", ", PARAM_VOLATILE"};
+    static const char *group_name[] = {"written, grouped for incremental saves", "read only, hot params share cache lines", "not accessed"};
+    param_line_t line;
+    char def[PARAM_CLI_LINE_MAX];
+    
+    line.len = 0;
+    PARAM_PRINT("\n//%s\n", group_name[group]);
+    for (int i = 0; i < tbl->total; i++)
+    {
+        int idx = order[i];
+        const param_msg_t *msg = &tbl->msgs[idx];
+        const param_prof_t *prof = &tbl->prof[idx];
+        const char *macro;
+        int size = -1;//no size argument
+        
+        if (group != ((prof->writes > 0) ? 0 : (prof->reads > 0) ? 1 : 2))
         {
-            PARAM_PRINT("%d", *((s8*)val));
+            continue;
         }
-        else if (size == sizeof(u16))
+        switch(msg->type)
         {
-            s16 lval;
-            memcpy((u8 *)&lval, val, size);
-            PARAM_PRINT("%d", lval);
+        case PTYPE_STR:
+            macro = "PARAM_STRING";
+            size = msg->size - 1;
+            break;
+        case PTYPE_ARRAY:
+            macro = "PARAM_ARRAY";
+            size = msg->size;
+            break;
+        case PTYPE_INT:
+            macro = (msg->size == sizeof(u32)) ? "PARAM_INT" : "PARAM_INT64";
+            break;
+        case PTYPE_HEX:
+            macro = (msg->size == sizeof(u32)) ? "PARAM_HEX" : "PARAM_HEX64";
+            break;
+        default:
+            macro = (msg->size == sizeof(f32)) ? "PARAM_FLOAT" : "PARAM_DOUBLE";
+            break;
         }
-        else if (size == sizeof(u32))
+        if (size >= 0)
         {
-            s32 lval;
-            memcpy((u8 *)&lval, val, size);
-            PARAM_PRINT("%d", lval);
+            snprintf(def, sizeof(def), "%s(%s, %d, %s%s)", macro, param_tbl_get_name(tbl, idx), size,
+                     PARAM_MSG_DEFVAL(tbl, idx), store_name[msg->store]);
         }
-        else if (size == sizeof(u64))
+        else
         {
-            s64 lval;
-            s32 tv;
-            memcpy((u8 *)&lval, val, size);
-            tv = lval / 1000000000;
-            if (tv != 0)
-            {
-                PARAM_PRINT("%d", tv);
-            }
-            tv = lval % 1000000000;
-            PARAM_PRINT("%d", tv);
+            snprintf(def, sizeof(def), "%s(%s, %s%s)", macro, param_tbl_get_name(tbl, idx),
+                     PARAM_MSG_DEFVAL(tbl, idx), store_name[msg->store]);
         }
-        break;
-    case PTYPE_HEX:
-        if (size == sizeof(u8))
+        param_line_col(&line, def, 47);
+        param_line_puts(&line, " //reads ");
+        param_line_int(&line, prof->reads, 0);
+        param_line_puts(&line, " writes ");
+        param_line_int(&line, prof->writes, 0);
+        param_line_flush(&line);
+    }
+}
+
+static void param_hot_cmd(param_tbl_t *tbl, int argc, char **argv)
+{
+    param_line_t line;
+    u16 *order;
+    int count = PARAM_PROF_TOP;
+    
+    if (argc >= 3)
+    {
+        if (strcmp(argv[2], "reset") == 0)
         {
-            PARAM_PRINT("%02X", *((u8*)val));
+            param_tbl_prof_reset(tbl);
+            PARAM_PRINT("param access counters reset success.\n");
+            return;
         }
-        else if (size == sizeof(u16))
+        count = (strcmp(argv[2], "def") == 0) ? tbl->total : atoi(argv[2]);
+        if (count <= 0)
+        {
+            PARAM_PRINT("param hot [count | def | reset]\n");
+            return;
+        }
+    }
+    
+    order = malloc(tbl->total * sizeof(u16));
+    if (order == NULL)
+    {
+        PARAM_PRINT("param hot fail. no memory.\n");
+        return;
+    }
+    count = param_tbl_prof_rank(tbl, order, count);
+    
+    if ((argc >= 3) && (strcmp(argv[2], "def") == 0))
+    {
+        PARAM_PRINT("//suggested order of %s params, indexes change, saved images need PARAM_USING_MIGRATE to keep values\n", tbl->name);
+        PARAM_PRINT("PARAM_BEGIN()\n");
+        for (int g = 0; g < 3; g++)
         {
-            u16 lval;
-            memcpy((u8 *)&lval, val, size);
-            PARAM_PRINT("%04X", lval);
+            param_hot_def(tbl, order, g);
         }
-        else if (size == sizeof(u32))
+        PARAM_PRINT("\nPARAM_END()\n");
+        free(order);
+        return;
+    }
+    
+    line.len = 0;
+    PARAM_PRINT("\n");
+    PARAM_PRINT("index  name              reads       writes      \n");
+    PARAM_PRINT("-----  ----------------  ----------  ----------  \n");
+    for (int i = 0; i < count; i++)
+    {
+        const param_prof_t *prof = &tbl->prof[order[i]];
+        if ((prof->reads == 0) && (prof->writes == 0))
         {
-            u32 lval;
-            memcpy((u8 *)&lval, val, size);
-            PARAM_PRINT("%08X", lval);
+            break;
         }
-        else if (size == sizeof(u64))
+        param_line_int(&line, order[i], 5+2);
+        param_line_col(&line, param_tbl_get_name(tbl, order[i]), 16+2);
+        param_line_int(&line, prof->reads, 10+2);
+        param_line_int(&line, prof->writes, 0);
+        param_line_flush(&line);
+    }
+    free(order);
+}
+#endif
+
+#ifdef PARAM_USING_PRESET
+static void param_preset_cmd(param_tbl_t *tbl, int argc, char **argv)
+{
+    const char *active;
+    
+    if (argc < 3)
+    {
+        active = param_tbl_preset_active(tbl);
+        PARAM_PRINT("live image : %s\n", (active != NULL) ? active : "saved");
+        for (int i = 0; i < tbl->cfg.preset_total; i++)
         {
-            u64 lval;
-            memcpy((u8 *)&lval, val, size);
-            PARAM_PRINT("%08X", (u32)(lval >> 32));
-            PARAM_PRINT("%08X", (u32)lval);
+            PARAM_PRINT("  %s\n", tbl->cfg.presets[i]);
         }
-        break;
-    case PTYPE_FLOAT:
-        if (size == sizeof(f32))
+        return;
+    }
+    if ((argc >= 4) && (strcmp(argv[2], "store") == 0))
+    {
+        if (param_tbl_preset_store(tbl, argv[3]) == RT_EOK)
         {
-            char tbuf[20];
-            float fval = *((float*)val);
-            sprintf(tbuf, "%.3f", fval);
-            PARAM_PRINT(tbuf);
+            PARAM_PRINT("param preset %s store success.\n", argv[3]);
         }
-        else
+        return;
+    }
+    if ((argc >= 4) && (strcmp(argv[2], "switch") == 0))
+    {
+        if (param_tbl_preset_switch(tbl, argv[3]) == RT_EOK)
         {
-            char tbuf[20];
-            double fval = *((double*)val);
-            sprintf(tbuf, "%.5f", fval);
-            PARAM_PRINT(tbuf);
+            PARAM_PRINT("param preset %s switch success.\n", argv[3]);
         }
-        break;
-    default:
-        break;
+        return;
     }
+    PARAM_PRINT("param preset [store name | switch name]\n");
 }
+#endif
 
 static void param_cmd(int argc, char **argv)
 {
+    param_tbl_t *tbl = &param_tbl_main;
+    
+    if ((argc >= 3) && (strcmp(argv[1], "-t") == 0))
+    {
+        tbl = param_tbl_find(argv[2]);
+        if (tbl == NULL)
+        {
+            PARAM_PRINT("this table don`t exist, the name is %s\n", argv[2]);
+            return;
+        }
+        argc -= 2;
+        argv += 2;
+    }
     if (argc < 2)
     {
         PARAM_PRINT("Usage: \n");
-        PARAM_PRINT("param init              -Initialize parameter module.\n");
-        PARAM_PRINT("param list              -List display all params.\n");
+        PARAM_PRINT("param -t table cmd ...  -Run the command on a table initialized by param_tbl_init, default is main table.\n");
+        PARAM_PRINT("param tables            -List display all initialized tables.\n");
+        PARAM_PRINT("param init              -Initialize parameter module, only the main table.\n");
+        PARAM_PRINT("param list [-j|-c] [prefix*] -List display params, all or matched by name prefix, as text/json/csv.\n");
         PARAM_PRINT("param load              -Load all params from flash.\n");
         PARAM_PRINT("param save              -Save all params to flash.\n");
         PARAM_PRINT("param resume name       -Resume the param to default by name.\n");
-        PARAM_PRINT("param read name         -Read the param by name.\n");
+        PARAM_PRINT("param read name [-j|-c] -Read the param by name, as text/json/csv.\n");
         PARAM_PRINT("param write name val    -Write the param by name.\n");
+        PARAM_PRINT("param diff              -List display params differ from default.\n");
+        PARAM_PRINT("param bench [count]     -Benchmark save and load of each compression type.\n");
+        PARAM_PRINT("param dyn [set|get|del] -List/set/get/delete dynamic params, value is string.\n");
+        PARAM_PRINT("param export [diff]     -Export all params or non-default params as hex lines.\n");
+        PARAM_PRINT("param export since epoch gen -Export params changed since the generation of the epoch, with PARAM_USING_DELTA.\n");
+        PARAM_PRINT("param import ...        -Import hex lines of exported params, run it for usage.\n");
+        PARAM_PRINT("param text ...          -Import name=val lines as one batch, run it for usage.\n");
+        PARAM_PRINT("param stats [reset]     -Show or clear statistics of calls, saves, loads and flash wear.\n");
+        PARAM_PRINT("param hot [n|def|reset] -Show the most accessed params, suggest an order of definitions, or clear counters.\n");
+        PARAM_PRINT("param preset [store|switch name] -List presets, store live values as a preset, or switch to it.\n");
         PARAM_PRINT("\n");
         return ;
     }
+    if (strcmp(argv[1], "tables") == 0)
+    {
+        rt_slist_t *node;
+        param_line_t line;
+        line.len = 0;
+        PARAM_PRINT("\n");
+        PARAM_PRINT("table             part              total  size  \n");
+        PARAM_PRINT("----------------  ----------------  -----  ----  \n");
+        rt_slist_for_each(node, &param_tbl_list)
+        {
+            param_tbl_t *ptbl = rt_slist_entry(node, param_tbl_t, list);
+            param_line_col(&line, ptbl->name, 16+2);
+            param_line_col(&line, ptbl->cfg.part_name, 16+2);
+            param_line_int(&line, ptbl->total, 5+2);
+            param_line_int(&line, ptbl->size, 4+2);
+            param_line_flush(&line);
+        }
+        return;
+    }
     if (strcmp(argv[1], "init") == 0)
     {
-        if (param_init() == RT_EOK)
+        if (tbl != &param_tbl_main)//only initialized tables are found by name
+        {
+            PARAM_PRINT("the table %s is initialized by param_tbl_init in its module.\n", tbl->name);
+            return;
+        }
+        if (param_tbl_init(tbl) == RT_EOK)
         {
             PARAM_PRINT("param init success.\n");
         }
@@ -1049,35 +7242,138 @@ static void param_cmd(int argc, char **argv)
     }
     if (strcmp(argv[1], "deinit") == 0)
     {
-        param_deinit();
+        param_tbl_deinit(tbl);
         PARAM_PRINT("param deinit success.\n");
         return;
     }
     if (strcmp(argv[1], "list") == 0)
     {
+        param_list_cmd(tbl, argc, argv);
+        return;
+    }
+    if (strcmp(argv[1], "diff") == 0)
+    {
+        #ifdef PARAM_USING_OVERLAY
+        int count = 0;
+        param_line_t line;
+        line.len = 0;
         PARAM_PRINT("\n");
-        PARAM_PRINT("name              type    size  value          \n");
-        PARAM_PRINT("----------------  ------  ----  -------------  \n");
-        for (int i=0; i<PARAM_TOTAL; i++)
+        PARAM_PRINT("name              value          \n");
+        PARAM_PRINT("----------------  -------------  \n");
+        for (int n = 0; n < PARAM_MAP_SIZE(tbl); n++)
         {
-            char buf[128];
-            char *name = (char *)param_get_name(i);
-            int type = param_get_type(i);
-            int size = param_get_size(i);
-            param_print_str(name, 16+2);
-            param_print_type(type, size, 6+2);
-            param_print_size(size, 4+2);
-            param_read_by_index(i, buf, size);
-            param_print_value(type, size, buf);
-            PARAM_PRINT("\n");
+            if (tbl->overlay_map[n] == 0)//all 8 params are default
+            {
+                continue;
+            }
+            for (int i = n*8; (i < n*8 + 8) && (i < tbl->total); i++)
+            {
+                char buf[PARAM_VALUE_MAX + 1];
+                int type, size;
+                if (param_overlay_test(tbl, i) == 0)
+                {
+                    continue;
+                }
+                type = param_get_type(tbl, i);
+                size = param_get_size(tbl, i);
+                param_tbl_read_by_index(tbl, i, buf, size);
+                buf[size] = 0;
+                param_line_col(&line, param_tbl_get_name(tbl, i), 16+2);
+                param_line_value(&line, type, size, buf, POUT_TEXT);
+                param_line_puts(&line, "  (default : ");
+                param_line_puts(&line, PARAM_MSG_DEFVAL(tbl, i));
+                param_line_putc(&line, ')');
+                param_line_flush(&line);
+                count++;
+            }
         }
-        PARAM_PRINT("---- param total : %d ----", PARAM_TOTAL);
+        PARAM_PRINT("---- param differ : %d/%d ----", count, tbl->total);
         PARAM_PRINT("\n");
+        #else
+        PARAM_PRINT("param diff is unsupported, please enable PARAM_USING_OVERLAY.\n");
+        #endif
+        return;
+    }
+    if (strcmp(argv[1], "dyn") == 0)
+    {
+        #ifdef PARAM_USING_DYNAMIC
+        param_dyn_cmd(tbl, argc, argv);
+        #else
+        PARAM_PRINT("param dyn is unsupported, please enable PARAM_USING_DYNAMIC.\n");
+        #endif
+        return;
+    }
+    if (strcmp(argv[1], "export") == 0)
+    {
+        #ifdef PARAM_USING_EXPORT
+        param_export_cmd(tbl, argc, argv);
+        #else
+        PARAM_PRINT("param export is unsupported, please enable PARAM_USING_EXPORT.\n");
+        #endif
+        return;
+    }
+    if (strcmp(argv[1], "import") == 0)
+    {
+        #ifdef PARAM_USING_EXPORT
+        param_import_cmd(tbl, argc, argv);
+        #else
+        PARAM_PRINT("param import is unsupported, please enable PARAM_USING_EXPORT.\n");
+        #endif
+        return;
+    }
+    if (strcmp(argv[1], "text") == 0)
+    {
+        #ifdef PARAM_USING_TEXT_IMPORT
+        param_text_cmd(tbl, argc, argv);
+        #else
+        PARAM_PRINT("param text is unsupported, please enable PARAM_USING_TEXT_IMPORT.\n");
+        #endif
+        return;
+    }
+    if (strcmp(argv[1], "stats") == 0)
+    {
+        #ifdef PARAM_USING_STATS
+        param_stats_cmd(tbl, argc, argv);
+        #else
+        PARAM_PRINT("param stats is unsupported, please enable PARAM_USING_STATS.\n");
+        #endif
+        return;
+    }
+    if (strcmp(argv[1], "hot") == 0)
+    {
+        #ifdef PARAM_USING_PROFILE
+        param_hot_cmd(tbl, argc, argv);
+        #else
+        PARAM_PRINT("param hot is unsupported, please enable PARAM_USING_PROFILE.\n");
+        #endif
+        return;
+    }
+    if (strcmp(argv[1], "preset") == 0)
+    {
+        #ifdef PARAM_USING_PRESET
+        param_preset_cmd(tbl, argc, argv);
+        #else
+        PARAM_PRINT("param preset is unsupported, please enable PARAM_USING_PRESET.\n");
+        #endif
+        return;
+    }
+    if (strcmp(argv[1], "bench") == 0)
+    {
+        #ifdef PARAM_USING_COMPRESS
+        int count = (argc < 3) ? 10 : atoi(argv[2]);
+        if (count <= 0)
+        {
+            count = 1;
+        }
+        param_bench(tbl, count);
+        #else
+        PARAM_PRINT("param bench is unsupported, please enable PARAM_USING_COMPRESS.\n");
+        #endif
         return;
     }
     if (strcmp(argv[1], "load") == 0)
     {
-        if (param_load_from_flash() == RT_EOK)
+        if (param_tbl_load(tbl) == RT_EOK)
         {
             PARAM_PRINT("param load success.\n");
         }
@@ -1085,7 +7381,7 @@ static void param_cmd(int argc, char **argv)
     }
     if (strcmp(argv[1], "save") == 0)
     {
-        if (param_save_to_flash() == RT_EOK)
+        if (param_tbl_save(tbl) == RT_EOK)
         {
             PARAM_PRINT("param save success.\n");
         }
@@ -1101,12 +7397,12 @@ static void param_cmd(int argc, char **argv)
         {
             if (strcmp(argv[2], "all") == 0)
             {
-                if (param_resume_all() == RT_EOK)
+                if (param_tbl_resume_all(tbl) == RT_EOK)
                 {
                     PARAM_PRINT("resume all param success.\n");
                 }
             }
-            else if (param_resume_by_name(argv[2]) == RT_EOK)
+            else if (param_tbl_resume_by_name(tbl, argv[2]) == RT_EOK)
             {
                 PARAM_PRINT("resume param success, the name is %s\n", argv[2]);
             }
@@ -1115,28 +7411,40 @@ static void param_cmd(int argc, char **argv)
     }
     if (strcmp(argv[1], "read") == 0)
     {
-        if (argc < 3)
+        const char *name;
+        int mode = param_cli_options(argc, argv, &name);
+        if (name == NULL)
         {
-            PARAM_PRINT("param read name         -Read the param by name.\n");
+            PARAM_PRINT("param read name [-j|-c] -Read the param by name, as text/json/csv.\n");
         }
         else
         {
-            char buf[128];
+            char buf[PARAM_VALUE_MAX + 1];
             int type, size;
-            int idx = param_find_by_name(argv[2]);
+            param_line_t line;
+            int idx = param_find_by_name(tbl, (char *)name);
             if (idx < 0)
             {
-                PARAM_PRINT("this param don`t exist, the name is %s\n", argv[2]);
+                PARAM_PRINT("this param don`t exist, the name is %s\n", name);
+                return;
+            }
+            line.len = 0;
+            if (mode != POUT_TEXT)
+            {
+                param_line_param(&line, tbl, idx, mode);
+                param_line_flush(&line);
                 return;
             }
-            type = param_get_type(idx);
-            size = param_get_size(idx);
-            if (param_read_by_index(idx, buf, size) < 0)
+            type = param_get_type(tbl, idx);
+            size = param_get_size(tbl, idx);
+            if (param_tbl_read_by_index(tbl, idx, buf, size) < 0)
             {
-                PARAM_PRINT("read param error, the name is %s\n", argv[2]);
+                PARAM_PRINT("read param error, the name is %s\n", name);
+                return;
             }
-            param_print_value(type, size, buf);
-            PARAM_PRINT("\n");
+            buf[size] = 0;
+            param_line_value(&line, type, size, buf, POUT_TEXT);
+            param_line_flush(&line);
         }
         return;
     }
@@ -1150,16 +7458,16 @@ static void param_cmd(int argc, char **argv)
         {
             char buf[128];
             int type, size;
-            int idx = param_find_by_name(argv[2]);
+            int idx = param_find_by_name(tbl, argv[2]);
             if (idx < 0)
             {
                 PARAM_PRINT("this param don`t exist, the name is %s\n", argv[2]);
                 return;
             }
-            type = param_get_type(idx);
-            size = param_get_size(idx);
+            type = param_get_type(tbl, idx);
+            size = param_get_size(tbl, idx);
             param_input_value(buf, type, size, argv[3]);
-            if (param_write_by_index(idx, buf, size) < 0)
+            if (param_tbl_write_by_index(tbl, idx, buf, size) < 0)
             {
                 PARAM_PRINT("write param error, the name is %s\n", argv[2]);
                 return;